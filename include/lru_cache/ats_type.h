@@ -10,8 +10,13 @@
 #include <sys/socket.h>
 #include <cstring>
 
+#include <lru_cache/ip_text.h>
+
 // CPP header
+#include <cstdint>
 #include <string>
+#include <string_view>
+#include <type_traits>
 
 using std::string;
 
@@ -74,18 +79,217 @@ struct IpAddress {
 
   bool operator!=(const IpAddress& rhs) const { return !(*this == rhs); }
 
+  // equals compares with the address of a sockaddr, as operator== does, sockaddr of other families never equal.
+  bool equals(const struct sockaddr* rhs) const {
+    if (base.sa_family != rhs->sa_family) {
+      return false;
+    }
+    if (rhs->sa_family == AF_INET) {
+      return v4.sin_addr.s_addr == reinterpret_cast<const struct sockaddr_in*>(rhs)->sin_addr.s_addr;
+    }
+    if (rhs->sa_family == AF_INET6) {
+      const auto* rhs6 = reinterpret_cast<const struct sockaddr_in6*>(rhs);
+      return memcmp(&v6.sin6_addr.s6_addr, &rhs6->sin6_addr.s6_addr, 16) == 0;
+    }
+    return false;
+  }
+
+  // parse sets the IpAddress from an address text (e.g. "1.2.3.4" or "2001:db8::1", port 0) without inet_pton,
+  // returns false and leaves the IpAddress cleared if the text is not an address.
+  bool parse(std::string_view text) {
+    clear();
+    if (IpText::parse(text, &v4.sin_addr)) {
+      base.sa_family = AF_INET;
+      return true;
+    }
+    if (IpText::parse(text, &v6.sin6_addr)) {
+      base.sa_family = AF_INET6;
+      return true;
+    }
+    return false;
+  }
+
+  // toChars writes the text toString() returns NUL-terminated into buf of size len without allocation, returns the
+  // text length, or 0 if len is too small (INET6_ADDRSTRLEN fits any address) or the family is neither.
+  size_t toChars(char* buf, size_t len) const {
+    if (base.sa_family == AF_INET) {
+      return IpText::format(v4.sin_addr, buf, len);
+    } else if (base.sa_family == AF_INET6) {
+      return IpText::format(v6.sin6_addr, buf, len);
+    }
+    return 0;
+  }
+
   // Convert the IpAddress to readable string such as "1.2.3.4" or "2001:db8:8714::12".
   string toString() const {
-    if (base.sa_family == AF_INET) {  // ipv4
-      char str[INET_ADDRSTRLEN];
-      inet_ntop(AF_INET, &(v4.sin_addr), str, INET_ADDRSTRLEN);
-      return string(str);
-    } else if (base.sa_family == AF_INET6) {  // ipv6
-      char str[INET6_ADDRSTRLEN];
-      inet_ntop(AF_INET6, &(v6.sin6_addr), str, INET6_ADDRSTRLEN);
-      return string(str);
+    char str[INET6_ADDRSTRLEN];
+    return string(str, toChars(str, sizeof(str)));
+  }
+};
+
+/**
+ * IpAddressText parses an IP address text (e.g. an X-Forwarded-For entry) into
+ * a sockaddr holding only the family and the address, without the memset and
+ * copy of an IpAddress. The family is AF_UNSPEC if the text is not an address.
+ *
+ */
+struct IpAddressText {
+  union {
+    struct sockaddr base;
+    struct sockaddr_in v4;
+    struct sockaddr_in6 v6;
+  };
+
+  explicit IpAddressText(std::string_view text) {
+    if (IpText::parse(text, &v4.sin_addr)) {
+      base.sa_family = AF_INET;
+    } else if (IpText::parse(text, &v6.sin6_addr)) {
+      base.sa_family = AF_INET6;
+    } else {
+      base.sa_family = AF_UNSPEC;
     }
-    return string();
   }
+
+  explicit operator bool() const { return base.sa_family != AF_UNSPEC; }
+
+  // lookup returns the heterogeneous lookup form of the address, see LRUC::IsTextLookup.
+  const struct sockaddr* lookup() const { return &base; }
 };
+
+/**
+ * PackedIpKey is a 16 bytes trivially copyable cache key holding only the
+ * address of an IpAddress, port / flowinfo / scope_id are dropped.
+ *
+ * IPv4 addresses are stored IPv4-mapped (::ffff:a.b.c.d), thus IPv4 1.2.3.4
+ * and IPv6 ::ffff:1.2.3.4 are the same key and convert back as AF_INET.
+ * IpAddress of other families (e.g. a cleared one) packs to "::".
+ *
+ * hash() is two multiply-fold rounds over the two 64 bits words and
+ * operator== compares the two words without branching on the family.
+ *
+ */
+struct PackedIpKey {
+  alignas(16) uint64_t word[2];
+
+  PackedIpKey() = default;
+
+  // Implicit conversion from u_int32_t (network byte order) is allowed, as IpAddress does.
+  PackedIpKey(u_int32_t ip_v4) { set(ip_v4); }
+
+  explicit PackedIpKey(const struct sockaddr* baseVal) { set(baseVal); }
+
+  explicit PackedIpKey(const IpAddress& ip) { set(&ip.base); }
+
+  void set(const struct sockaddr* baseVal) {
+    if (baseVal->sa_family == AF_INET) {
+      set(reinterpret_cast<const struct sockaddr_in*>(baseVal)->sin_addr.s_addr);
+    } else if (baseVal->sa_family == AF_INET6) {
+      memcpy(word, &reinterpret_cast<const struct sockaddr_in6*>(baseVal)->sin6_addr, sizeof(word));
+    } else {
+      word[0] = word[1] = 0;
+    }
+  }
+
+  void set(u_int32_t ip_v4) {
+    const u_int32_t mapped = htonl(0xffff);
+    word[0] = 0;
+    memcpy(reinterpret_cast<uint8_t*>(word) + 8, &mapped, sizeof(mapped));
+    memcpy(reinterpret_cast<uint8_t*>(word) + 12, &ip_v4, sizeof(ip_v4));
+  }
+
+  // isV4 tells whether the key is an IPv4-mapped address.
+  bool isV4() const {
+    u_int32_t mapped;
+    memcpy(&mapped, reinterpret_cast<const uint8_t*>(word) + 8, sizeof(mapped));
+    return word[0] == 0 && mapped == htonl(0xffff);
+  }
+
+  // v4 returns the IPv4 address in network byte order, valid only if isV4().
+  u_int32_t v4() const {
+    u_int32_t ip_v4;
+    memcpy(&ip_v4, reinterpret_cast<const uint8_t*>(word) + 12, sizeof(ip_v4));
+    return ip_v4;
+  }
+
+  // toSockaddr writes sockaddr_in or sockaddr_in6 (port 0) into out of size len,
+  // returns the written length or 0 if len is too small.
+  socklen_t toSockaddr(struct sockaddr* out, socklen_t len) const {
+    if (isV4()) {
+      if (len < sizeof(struct sockaddr_in)) {
+        return 0;
+      }
+      struct sockaddr_in v4Addr {};
+      v4Addr.sin_family = AF_INET;
+      v4Addr.sin_addr.s_addr = v4();
+      memcpy(out, &v4Addr, sizeof(v4Addr));
+      return sizeof(v4Addr);
+    }
+
+    if (len < sizeof(struct sockaddr_in6)) {
+      return 0;
+    }
+    struct sockaddr_in6 v6Addr {};
+    v6Addr.sin6_family = AF_INET6;
+    memcpy(&v6Addr.sin6_addr, word, sizeof(word));
+    memcpy(out, &v6Addr, sizeof(v6Addr));
+    return sizeof(v6Addr);
+  }
+
+  IpAddress toIpAddress() const {
+    struct sockaddr_in6 storage;
+    toSockaddr(reinterpret_cast<struct sockaddr*>(&storage), sizeof(storage));
+    return IpAddress{reinterpret_cast<const struct sockaddr*>(&storage)};
+  }
+
+  std::size_t hash() const noexcept {
+    // a word equal to its salt zeroes the first product whatever the other
+    // word is, the second round mixes both words in again.
+    const uint64_t first = mix(word[0] ^ 0xa0761d6478bd642fULL, word[1] ^ 0xe7037ed1a0b428dbULL);
+    return static_cast<std::size_t>(
+        mix(first ^ word[0] ^ 0x8ebc6af09c88c6e3ULL, first ^ word[1] ^ 0x589965cc75374cc3ULL));
+  }
+
+  bool operator==(const PackedIpKey& rhs) const { return ((word[0] ^ rhs.word[0]) | (word[1] ^ rhs.word[1])) == 0; }
+
+  bool operator!=(const PackedIpKey& rhs) const { return !(*this == rhs); }
+
+  // parse sets the key from an address text, returns false and leaves "::" if the text is not an address.
+  bool parse(std::string_view text) {
+    struct in_addr v4Addr;
+    if (IpText::parse(text, &v4Addr)) {
+      set(v4Addr.s_addr);
+      return true;
+    }
+    word[0] = word[1] = 0;
+    return IpText::parse(text, reinterpret_cast<struct in6_addr*>(word));
+  }
+
+  // toChars writes the address text as IpAddress::toChars does.
+  size_t toChars(char* buf, size_t len) const {
+    if (isV4()) {
+      struct in_addr v4Addr;
+      v4Addr.s_addr = v4();
+      return IpText::format(v4Addr, buf, len);
+    }
+    struct in6_addr v6Addr;
+    memcpy(&v6Addr, word, sizeof(word));
+    return IpText::format(v6Addr, buf, len);
+  }
+
+  string toString() const {
+    char str[INET6_ADDRSTRLEN];
+    return string(str, toChars(str, sizeof(str)));
+  }
+
+private:
+  __extension__ typedef unsigned __int128 uint128;
+
+  // mix folds the 64x64->128 bits product of a and b to 64 bits.
+  static uint64_t mix(uint64_t a, uint64_t b) {
+    const uint128 product = static_cast<uint128>(a) * static_cast<uint128>(b);
+    return static_cast<uint64_t>(product) ^ static_cast<uint64_t>(product >> 64);
+  }
+};
+
+static_assert(sizeof(PackedIpKey) == 16 && std::is_trivially_copyable_v<PackedIpKey>);
 }  // namespace AtsPluginUtils
@@ -0,0 +1,32 @@
+/**
+ * @author shchang
+ *
+ */
+
+#pragma once
+
+#include <type_traits>
+
+#if defined(__SANITIZE_THREAD__)
+// ThreadSanitizer dynamic annotations, seqlock readers ignore their validated
+// racy reads.
+extern "C" void AnnotateIgnoreReadsBegin(const char* file, int line);
+extern "C" void AnnotateIgnoreReadsEnd(const char* file, int line);
+#endif
+
+namespace vsdmars {
+
+/**
+ * is_bitwise_copyable tells whether T can be copied with memcpy and read while
+ * being concurrently overwritten (the result is discarded on validation
+ * failure). Specialize for types which are not trivially copyable but hold no
+ * pointers, e.g. AtsPluginUtils::IpAddress in clock_lru_cache_hash.h.
+ *
+ */
+template <typename T>
+struct is_bitwise_copyable : std::is_trivially_copyable<T> {};
+
+template <typename T>
+inline constexpr bool is_bitwise_copyable_v = is_bitwise_copyable<T>::value;
+
+}  // namespace vsdmars
@@ -0,0 +1,410 @@
+/**
+ * @author shchang
+ *
+ */
+
+#pragma once
+#include <ats_type.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string_view>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace vsdmars {
+
+/**
+ * Cidr is an address block, address / prefixLen (e.g. "10.0.0.0/8" or
+ * "2001:db8::/32"). Host bits of address are ignored.
+ *
+ * operator< orders IPv4 blocks before IPv6 ones, then by address bytes, then
+ * by prefix length, the order CidrIndex is built from.
+ *
+ */
+struct Cidr final {
+  AtsPluginUtils::IpAddress address{};
+  uint8_t prefixLen = 0;
+
+  /**
+   * parse sets the block from "address/prefixLen", an address without prefix
+   * length is a single address block. Returns false and leaves cidr unchanged
+   * if the text is not a block.
+   */
+  static bool parse(std::string_view text, Cidr* cidr) {
+    const size_t slash = text.find('/');
+    Cidr parsed;
+    if (!parsed.address.parse(text.substr(0, slash))) {
+      return false;
+    }
+
+    const int maxLen = parsed.address.base.sa_family == AF_INET ? 32 : 128;
+    if (slash == std::string_view::npos) {
+      parsed.prefixLen = static_cast<uint8_t>(maxLen);
+    } else {
+      const std::string_view len = text.substr(slash + 1);
+      if (len.empty() || len.size() > 3 || (len.size() > 1 && len[0] == '0')) {
+        return false;
+      }
+      int value = 0;
+      for (char c : len) {
+        if (c < '0' || c > '9') {
+          return false;
+        }
+        value = value * 10 + (c - '0');
+      }
+      if (value > maxLen) {
+        return false;
+      }
+      parsed.prefixLen = static_cast<uint8_t>(value);
+    }
+
+    *cidr = parsed;
+    return true;
+  }
+
+  bool operator<(const Cidr& rhs) const {
+    const bool v4 = address.base.sa_family == AF_INET;
+    if (v4 != (rhs.address.base.sa_family == AF_INET)) {
+      return v4;
+    }
+    const int order = v4 ? memcmp(&address.v4.sin_addr, &rhs.address.v4.sin_addr, sizeof(struct in_addr))
+                         : memcmp(&address.v6.sin6_addr, &rhs.address.v6.sin6_addr, sizeof(struct in6_addr));
+    return order != 0 ? order < 0 : prefixLen < rhs.prefixLen;
+  }
+};
+
+/**
+ * CidrIndex is a read-only longest prefix match index of address blocks to
+ * values (e.g. a CIDR blocklist to CacheValue), used alongside the caches for
+ * blocks too large to expand into addresses.
+ *
+ *  IPv4: DIR-24-8, a 2^24 entries table indexed by the first 24 bits, blocks
+ *        longer than /24 in 256 entries groups indexed by the last 8 bits. A
+ *        lookup reads one or two entries.
+ *  IPv6: path compressed binary trie, a node per block and per branching
+ *        point, laid out in preorder. A 2^16 entries jump table indexed by
+ *        the first 16 bits holds where the walk stands after them, a lookup
+ *        walks the nodes past /16 on the address's path from there.
+ *
+ * The index is built at once from entries sorted by Cidr::operator< (e.g. the
+ * sorted blocklist file), std::invalid_argument is thrown if they are not
+ * sorted, of another family or have a prefix length above the family's.
+ * Entries with the same block: the last one wins.
+ *
+ * find() is thread-safe, it only reads. The index is rebuilt by building a new
+ * one and publishing it, e.g. through std::atomic<std::shared_ptr>.
+ *
+ * The IPv4 table takes 64MB once an IPv4 block is built, the IPv6 jump table
+ * 512KB once an IPv6 block is built.
+ *
+ */
+template <class TValue>
+class CidrIndex final {
+public:
+  using Entries = std::vector<std::pair<Cidr, TValue>>;
+
+  CidrIndex() : values_(), tbl24_(), tbl8_(), nodes_(), jumps_() {}
+
+  explicit CidrIndex(const Entries& sorted);
+
+  /**
+   * find returns the value of the longest block holding the address, nullptr
+   * if none does.
+   */
+  const TValue* find(const struct sockaddr* addr) const;
+
+  const TValue* find(const AtsPluginUtils::IpAddress& ip) const { return find(&ip.base); }
+
+  const TValue* find(std::string_view text) const {
+    const AtsPluginUtils::IpAddressText addr{text};
+    return find(&addr.base);
+  }
+
+  /**
+   * size returns the built entry count.
+   */
+  size_t size() const { return values_.size(); }
+
+private:
+  // tbl24_ entry pointing to a tbl8_ group, otherwise value index + 1 (0: no block).
+  static constexpr uint32_t TBL8_FLAG = 0x80000000U;
+  static constexpr size_t TBL24_SIZE = size_t{1} << 24;
+  static constexpr size_t TBL8_GROUP = 256;
+  static constexpr uint32_t JUMP_BITS = 16;
+
+  /**
+   * Node is an IPv6 trie node: the first len bits of bits are its prefix,
+   * child[b] (0: none, the root is never a child) the subtrie continuing with
+   * bit b.
+   */
+  struct Node final {
+    uint64_t bits[2];
+    uint32_t child[2];
+    uint32_t value;  // value index + 1, 0: branching point only.
+    uint32_t len;
+  };
+
+  std::vector<TValue> values_;
+  std::vector<uint32_t> tbl24_;
+  std::vector<uint32_t> tbl8_;
+  std::vector<Node> nodes_;
+
+  /**
+   * Jump is the walk state after the first JUMP_BITS bits: the next node to
+   * match (0: none) and the value of the longest block so far.
+   */
+  struct Jump final {
+    uint32_t node;
+    uint32_t value;
+  };
+  std::vector<Jump> jumps_;
+
+private:
+  void buildV4(uint32_t addr, int len, uint32_t value);
+
+  void insertV6(const uint64_t bits[2], uint32_t len, uint32_t value);
+
+  // layoutV6 renumbers the nodes in preorder, a node's child 0 follows it in memory, and fills jumps_.
+  void layoutV6();
+
+  const TValue* findV6(const uint64_t bits[2]) const;
+
+  // loadV6 reads the address as two host order words, most significant bits first.
+  static void loadV6(const struct in6_addr& addr, uint64_t bits[2]) {
+    memcpy(bits, addr.s6_addr, sizeof(uint64_t) * 2);
+    bits[0] = __builtin_bswap64(bits[0]);
+    bits[1] = __builtin_bswap64(bits[1]);
+  }
+
+  static uint64_t mask(uint32_t len) { return len == 0 ? 0 : len >= 64 ? ~uint64_t{0} : ~uint64_t{0} << (64 - len); }
+
+  // matches tells whether bits start with the first len bits of prefix.
+  static bool matches(const uint64_t bits[2], const uint64_t prefix[2], uint32_t len) {
+    const uint64_t diff =
+        ((bits[0] ^ prefix[0]) & mask(len)) | ((bits[1] ^ prefix[1]) & mask(len > 64 ? len - 64 : 0));
+    return diff == 0;
+  }
+
+  static uint32_t bit(const uint64_t bits[2], uint32_t pos) {
+    return static_cast<uint32_t>(pos < 64 ? bits[0] >> (63 - pos) : bits[1] >> (127 - pos)) & 1U;
+  }
+
+  static uint32_t commonLen(const uint64_t a[2], const uint64_t b[2]) {
+    if (a[0] != b[0]) {
+      return static_cast<uint32_t>(__builtin_clzll(a[0] ^ b[0]));
+    }
+    return a[1] != b[1] ? 64 + static_cast<uint32_t>(__builtin_clzll(a[1] ^ b[1])) : 128;
+  }
+};
+
+template <class TValue>
+CidrIndex<TValue>::CidrIndex(const Entries& sorted) : values_(), tbl24_(), tbl8_(), nodes_(), jumps_() {
+  if (!std::is_sorted(sorted.begin(), sorted.end(),
+                      [](const auto& lhs, const auto& rhs) { return lhs.first < rhs.first; })) {
+    throw std::invalid_argument("CidrIndex: entries are not sorted");
+  }
+
+  values_.reserve(sorted.size());
+  std::vector<std::vector<std::pair<uint32_t, uint32_t>>> v4ByLen(33);
+  for (const auto& [cidr, value] : sorted) {
+    values_.push_back(value);
+    const uint32_t ref = static_cast<uint32_t>(values_.size());
+
+    if (cidr.address.base.sa_family == AF_INET) {
+      if (cidr.prefixLen > 32) {
+        throw std::invalid_argument("CidrIndex: IPv4 prefix length above 32");
+      }
+      v4ByLen[cidr.prefixLen].emplace_back(ntohl(cidr.address.v4.sin_addr.s_addr), ref);
+    } else if (cidr.address.base.sa_family == AF_INET6) {
+      if (cidr.prefixLen > 128) {
+        throw std::invalid_argument("CidrIndex: IPv6 prefix length above 128");
+      }
+      uint64_t bits[2];
+      loadV6(cidr.address.v6.sin6_addr, bits);
+      insertV6(bits, cidr.prefixLen, ref);
+    } else {
+      throw std::invalid_argument("CidrIndex: address is neither IPv4 nor IPv6");
+    }
+  }
+
+  if (!nodes_.empty()) {
+    layoutV6();
+  }
+
+  // shorter blocks first, longer ones overwrite the addresses they hold.
+  for (int len = 0; len <= 32; len++) {
+    for (const auto& [addr, ref] : v4ByLen[static_cast<size_t>(len)]) {
+      buildV4(addr, len, ref);
+    }
+  }
+}
+
+template <class TValue>
+void CidrIndex<TValue>::buildV4(uint32_t addr, int len, uint32_t value) {
+  if (tbl24_.empty()) {
+    tbl24_.resize(TBL24_SIZE);
+  }
+
+  const uint32_t first = len == 0 ? 0 : addr & (~uint32_t{0} << (32 - len));
+  if (len <= 24) {
+    // no tbl8_ group yet, blocks longer than /24 come later.
+    std::fill_n(tbl24_.begin() + (first >> 8), size_t{1} << (24 - len), value);
+    return;
+  }
+
+  uint32_t& entry = tbl24_[first >> 8];
+  if ((entry & TBL8_FLAG) == 0) {
+    const uint32_t group = static_cast<uint32_t>(tbl8_.size() / TBL8_GROUP);
+    tbl8_.resize(tbl8_.size() + TBL8_GROUP, entry);
+    entry = TBL8_FLAG | group;
+  }
+  std::fill_n(tbl8_.begin() + ((entry & ~TBL8_FLAG) * TBL8_GROUP + (first & 0xFF)), size_t{1} << (32 - len), value);
+}
+
+template <class TValue>
+void CidrIndex<TValue>::insertV6(const uint64_t bits[2], uint32_t len, uint32_t value) {
+  const uint64_t prefix[2] = {bits[0] & mask(len), bits[1] & mask(len > 64 ? len - 64 : 0)};
+  if (nodes_.empty()) {
+    nodes_.push_back(Node{{0, 0}, {0, 0}, 0, 0});
+  }
+
+  auto newNode = [this](const uint64_t nodeBits[2], uint32_t nodeLen, uint32_t nodeValue) {
+    nodes_.push_back(Node{{nodeBits[0] & mask(nodeLen), nodeBits[1] & mask(nodeLen > 64 ? nodeLen - 64 : 0)},
+                          {0, 0},
+                          nodeValue,
+                          nodeLen});
+    return static_cast<uint32_t>(nodes_.size() - 1);
+  };
+
+  // nodes_[node] prefix is a prefix of the block.
+  uint32_t node = 0;
+  while (true) {
+    if (nodes_[node].len == len) {
+      nodes_[node].value = value;
+      return;
+    }
+
+    const uint32_t branch = bit(prefix, nodes_[node].len);
+    const uint32_t child = nodes_[node].child[branch];
+    if (child == 0) {
+      const uint32_t leaf = newNode(prefix, len, value);
+      nodes_[node].child[branch] = leaf;
+      return;
+    }
+
+    const uint32_t common = std::min({commonLen(prefix, nodes_[child].bits), len, nodes_[child].len});
+    if (common == nodes_[child].len) {
+      node = child;
+      continue;
+    }
+
+    // the block splits the edge to child: the block itself or a branching point above child.
+    const uint32_t split = newNode(prefix, common, common == len ? value : 0);
+    nodes_[split].child[bit(nodes_[child].bits, common)] = child;
+    if (common != len) {
+      const uint32_t leaf = newNode(prefix, len, value);
+      nodes_[split].child[bit(prefix, common)] = leaf;
+    }
+    nodes_[node].child[branch] = split;
+    return;
+  }
+}
+
+template <class TValue>
+void CidrIndex<TValue>::layoutV6() {
+  std::vector<Node> ordered;
+  ordered.reserve(nodes_.size());
+  // (old node index, new index of the parent, branch from the parent), the root has no parent.
+  std::vector<std::tuple<uint32_t, uint32_t, uint32_t>> stack{{0, 0, 0}};
+  while (!stack.empty()) {
+    const auto [node, parent, branch] = stack.back();
+    stack.pop_back();
+
+    const uint32_t index = static_cast<uint32_t>(ordered.size());
+    if (index != 0) {
+      ordered[parent].child[branch] = index;
+    }
+    ordered.push_back(nodes_[node]);
+    for (uint32_t b : {1U, 0U}) {
+      if (nodes_[node].child[b] != 0) {
+        stack.emplace_back(nodes_[node].child[b], index, b);
+      }
+    }
+  }
+  nodes_.swap(ordered);
+
+  // walk the nodes shorter than JUMP_BITS for every value of the first JUMP_BITS bits.
+  jumps_.resize(size_t{1} << JUMP_BITS);
+  for (uint32_t first = 0; first < jumps_.size(); first++) {
+    const uint64_t bits[2] = {static_cast<uint64_t>(first) << (64 - JUMP_BITS), 0};
+    Jump jump{0, 0};
+    uint32_t node = 0;
+    while (true) {
+      const Node& current = nodes_[node];
+      if (current.len >= JUMP_BITS) {
+        jump.node = node;
+        break;
+      }
+      if (!matches(bits, current.bits, current.len)) {
+        break;
+      }
+      if (current.value != 0) {
+        jump.value = current.value;
+      }
+      node = current.child[bit(bits, current.len)];
+      if (node == 0) {
+        break;
+      }
+    }
+    jumps_[first] = jump;
+  }
+}
+
+template <class TValue>
+const TValue* CidrIndex<TValue>::find(const struct sockaddr* addr) const {
+  if (addr->sa_family == AF_INET) {
+    if (tbl24_.empty()) {
+      return nullptr;
+    }
+    const uint32_t ip = ntohl(reinterpret_cast<const struct sockaddr_in*>(addr)->sin_addr.s_addr);
+    uint32_t entry = tbl24_[ip >> 8];
+    if ((entry & TBL8_FLAG) != 0) {
+      entry = tbl8_[(entry & ~TBL8_FLAG) * TBL8_GROUP + (ip & 0xFF)];
+    }
+    return entry != 0 ? &values_[entry - 1] : nullptr;
+  }
+
+  if (addr->sa_family == AF_INET6 && !nodes_.empty()) {
+    uint64_t bits[2];
+    loadV6(reinterpret_cast<const struct sockaddr_in6*>(addr)->sin6_addr, bits);
+    return findV6(bits);
+  }
+  return nullptr;
+}
+
+template <class TValue>
+const TValue* CidrIndex<TValue>::findV6(const uint64_t bits[2]) const {
+  const Jump& jump = jumps_[bits[0] >> (64 - JUMP_BITS)];
+  uint32_t best = jump.value;
+  uint32_t node = jump.node;
+  while (node != 0) {
+    const Node& current = nodes_[node];
+    if (!matches(bits, current.bits, current.len)) {
+      break;
+    }
+    if (current.value != 0) {
+      best = current.value;
+    }
+    if (current.len == 128) {
+      break;
+    }
+    node = current.child[bit(bits, current.len)];
+  }
+  return best != 0 ? &values_[best - 1] : nullptr;
+}
+
+}  // namespace vsdmars
@@ -4,128 +4,634 @@
  */
 
 #pragma once
+#include <lru_cache/bitwise_copyable.h>
+#include <lru_cache/distributed_shared_mutex.h>
+#include <lru_cache/swiss_table.h>
 
+#include <algorithm>
 #include <atomic>
+#include <cstdint>
+#include <cstring>
 #include <functional>
+#include <limits>
 #include <mutex>
 #include <optional>
 #include <shared_mutex>
-#include <unordered_map>
+#include <stdexcept>
 #include <vector>
 
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
 namespace vsdmars {
 
+/**
+ * ClockCounters is the GCLOCK reference counter array of LRUClockCache.
+ *
+ * Each slot owns a saturating counter of CounterBits bits, counters are packed
+ * into 64 bits words in fields of 1, 2 or 4 bits (CounterBits rounded up to
+ * power of 2). touch() increments the counter, a saturated counter is not
+ * written again.
+ *
+ * evict() moves the clock hand to the next zero counter and decrements every
+ * counter it passes. Words are examined as a whole with SWAR arithmetic, runs
+ * of words holding no zero counter are checked 4 (AVX2) or 2 (SSE2) words per
+ * step and aged. A victim is found within 2^CounterBits rotations.
+ *
+ * touch() may run concurrently with evict(): counters only decrease in evict()
+ * and reset(), evict() subtracts from counters it found non zero with atomic
+ * read-modify-write, thus a concurrent touch is never lost. A counter touched
+ * after evict() read it zero is still evicted.
+ *
+ */
+template <size_t CounterBits> class ClockCounters final {
+  static_assert(CounterBits >= 1 && CounterBits <= 4,
+                "CounterBits must be in [1, 4]");
+
+private:
+  using Word = uint64_t;
+  using WordVector = std::vector<std::atomic<Word>>;
+
+  // field width, CounterBits rounded up to power of 2.
+  constexpr static size_t FIELD = CounterBits == 1   ? 1
+                                  : CounterBits == 2 ? 2
+                                                     : 4;
+  constexpr static size_t PER_WORD = 64 / FIELD;
+  constexpr static Word MAX = (Word{1} << CounterBits) - 1;
+  // lowest bit of every field.
+  constexpr static Word LOW = ~Word{0} / ((Word{1} << FIELD) - 1);
+
+  WordVector words_;
+  const size_t size_;
+  size_t hand_;
+
+private:
+  /**
+   * nonZero returns LOW bit set for every non zero field of word.
+   */
+  static Word nonZero(Word word) {
+    Word any = word;
+    for (size_t i = 1; i < FIELD; i++) {
+      any |= word >> i;
+    }
+    return any & LOW;
+  }
+
+  /**
+   * fields returns the bits of fields [from, to) of a word.
+   */
+  static Word fields(size_t from, size_t to) {
+    Word upper = to == PER_WORD ? ~Word{0} : (Word{1} << (to * FIELD)) - 1;
+    return upper & ~((Word{1} << (from * FIELD)) - 1);
+  }
+
+  /**
+   * ageWords decrements words [first, last) in bulk as long as they hold no
+   * zero counter. Returns the first word not aged.
+   */
+  size_t ageWords(size_t first, size_t last);
+
+public:
+  explicit ClockCounters(size_t size)
+      : words_((size + PER_WORD - 1) / PER_WORD), size_(size), hand_(0) {}
+
+  ClockCounters(const ClockCounters &other) = delete;
+  ClockCounters &operator=(const ClockCounters &) = delete;
+
+  /**
+   * touch increments slot's counter, thread-safe, also against evict().
+   */
+  void touch(size_t slot) {
+    auto &word = words_[slot / PER_WORD];
+    const size_t shift = (slot % PER_WORD) * FIELD;
+
+    Word cur = word.load(std::memory_order_relaxed);
+    while (((cur >> shift) & MAX) < MAX &&
+           !word.compare_exchange_weak(cur, cur + (Word{1} << shift),
+                                       std::memory_order_relaxed)) {
+    }
+  }
+
+  /**
+   * reset zeroes slot's counter, thread-safe.
+   */
+  void reset(size_t slot) {
+    const size_t shift = (slot % PER_WORD) * FIELD;
+    words_[slot / PER_WORD].fetch_and(~(MAX << shift),
+                                      std::memory_order_relaxed);
+  }
+
+  /**
+   * clear zeroes all counters and rewinds the hand. Not thread-safe.
+   */
+  void clear() noexcept;
+
+  /**
+   * evict returns the slot of the next zero counter, the hand moves past it.
+   * Caller excludes reset() and other evict() calls, touch() may run
+   * concurrently. size must be > 0.
+   */
+  size_t evict();
+};
+
+template <size_t CounterBits>
+size_t ClockCounters<CounterBits>::ageWords(size_t first, size_t last) {
+  // counters are only incremented concurrently by touch(), see evict(): a
+  // word checked non zero stays non zero until it's aged.
+  auto load = [this](size_t w) {
+    return static_cast<long long>(words_[w].load(std::memory_order_relaxed));
+  };
+  size_t i = first;
+
+#if defined(__AVX2__)
+  const __m256i low = _mm256_set1_epi64x(static_cast<long long>(LOW));
+  for (; i + 4 <= last; i += 4) {
+    __m256i word =
+        _mm256_set_epi64x(load(i + 3), load(i + 2), load(i + 1), load(i));
+    __m256i any = word;
+    for (int k = 1; k < static_cast<int>(FIELD); k++) {
+      any = _mm256_or_si256(any, _mm256_srli_epi64(word, k));
+    }
+    any = _mm256_and_si256(any, low);
+
+    if (_mm256_movemask_epi8(_mm256_cmpeq_epi32(any, low)) != -1) {
+      break;
+    }
+    for (size_t k = i; k < i + 4; k++) {
+      words_[k].fetch_sub(LOW, std::memory_order_relaxed);
+    }
+  }
+#elif defined(__SSE2__)
+  const __m128i low = _mm_set1_epi64x(static_cast<long long>(LOW));
+  for (; i + 2 <= last; i += 2) {
+    __m128i word = _mm_set_epi64x(load(i + 1), load(i));
+    __m128i any = word;
+    for (int k = 1; k < static_cast<int>(FIELD); k++) {
+      any = _mm_or_si128(any, _mm_srli_epi64(word, k));
+    }
+    any = _mm_and_si128(any, low);
+
+    if (_mm_movemask_epi8(_mm_cmpeq_epi32(any, low)) != 0xFFFF) {
+      break;
+    }
+    for (size_t k = i; k < i + 2; k++) {
+      words_[k].fetch_sub(LOW, std::memory_order_relaxed);
+    }
+  }
+#endif
+
+  for (; i < last && nonZero(static_cast<Word>(load(i))) == LOW; i++) {
+    words_[i].fetch_sub(LOW, std::memory_order_relaxed);
+  }
+
+  return i;
+}
+
+template <size_t CounterBits>
+void ClockCounters<CounterBits>::clear() noexcept {
+  for (auto &word : words_) {
+    word.store(0, std::memory_order_relaxed);
+  }
+  hand_ = 0;
+}
+
+template <size_t CounterBits> size_t ClockCounters<CounterBits>::evict() {
+  // words holding PER_WORD counters, the last word may be partial.
+  const size_t fullWords = size_ / PER_WORD;
+  size_t slot = hand_;
+
+  while (true) {
+    size_t w = slot / PER_WORD;
+    size_t from = slot % PER_WORD;
+    size_t to = std::min(PER_WORD, size_ - w * PER_WORD);
+
+    Word word = words_[w].load(std::memory_order_relaxed);
+    Word zeros = ~nonZero(word) & LOW & fields(from, to);
+
+    if (zeros != 0) {
+      size_t victim = static_cast<size_t>(__builtin_ctzll(zeros)) / FIELD;
+
+      // age the counters passed in this word.
+      words_[w].fetch_sub(LOW & fields(from, victim),
+                          std::memory_order_relaxed);
+
+      hand_ = w * PER_WORD + victim + 1;
+      if (hand_ >= size_) {
+        hand_ = 0;
+      }
+      return w * PER_WORD + victim;
+    }
+
+    words_[w].fetch_sub(LOW & fields(from, to), std::memory_order_relaxed);
+
+    // skip the following words holding no zero counter.
+    w = ageWords(w + 1, fullWords);
+    slot = w * PER_WORD;
+    if (slot >= size_) {
+      slot = 0;
+    }
+  }
+}
+
+/**
+ * LRUClockCache keeps keys and values in flat slot arrays and approximates LRU
+ * with GCLOCK, see ClockCounters. find() and visit() increment the slot's
+ * counter, insert() evicts the first zero counter slot under the clock hand.
+ *
+ * CounterBits: GCLOCK counter bits per slot, in [1, 4].
+ * TMutex: SharedMutex guarding the cache, e.g. DistributedSharedMutex for
+ * read-mostly workloads on many cores.
+ *
+ * Keys are indexed by a SwissTable of 32 bits slot indexes sized once at
+ * construction, keys live only in keyBuf_. Lookup matches the hash tag of 16
+ * index entries with one SIMD compare and compares the key of a slot only on
+ * tag match. Tombstones left by erase and eviction are dropped by an in-place
+ * rehash once the table's load budget is used up.
+ *
+ * Optimistic find:
+ * For bitwise copyable TKey and TValue of at most 2 cache lines find() first
+ * runs without the lock (seqlock): each slot has a sequence counter the writer
+ * makes odd while overwriting the slot, the reader compares the key and copies
+ * the value then validates the counter. A hit or a miss is trusted only if the
+ * index sequence, bumped around every index update, didn't move, thus a stale
+ * index entry never serves an erased slot. On conflict find() falls back to
+ * the shared lock. An optimistic hit touches the slot's GCLOCK counter, which
+ * is atomic against evict(); a slot reused meanwhile gets the touch of the
+ * key it held. Besides that readers write no shared memory. Under
+ * ThreadSanitizer the validated racy reads are annotated as ignored.
+ *
+ */
 template <typename TKey, typename TValue, typename THash = std::hash<TKey>,
-          typename TKeyEqual = std::equal_to<TKey>>
+          typename TKeyEqual = std::equal_to<TKey>, size_t CounterBits = 2,
+          typename TMutex = std::shared_mutex>
 class LRUClockCache final {
 private:
   // type defs
-  using HashMap = std::unordered_map<TKey, size_t, THash, TKeyEqual>;
-  using Mutex = std::shared_mutex;
-  using CharVector = std::vector<std::atomic<char>>;
+  using Index = SwissTable<uint32_t>;
+  using Mutex = TMutex;
   using KeyVector = std::vector<TKey>;
   using ValueVector = std::vector<TValue>;
+  using IndexVector = std::vector<size_t>;
   using Optional = std::optional<TValue>;
 
+public:
+  constexpr static bool OptimisticRead = is_bitwise_copyable_v<TKey> &&
+                                         is_bitwise_copyable_v<TValue> &&
+                                         sizeof(TValue) <= 128;
+
 private:
+  constexpr static size_t NPOS = Index::NPOS;
+
   Mutex mutex_;
-  HashMap hash_map_;
+  Index index_;
+  // odd while index_ is being updated, see OptimisticRead.
+  std::atomic<uint64_t> indexSeq_;
+  // per slot sequence, odd while the slot is being overwritten. Empty unless
+  // OptimisticRead.
+  std::vector<std::atomic<uint32_t>> slotSeq_;
+  std::atomic<size_t> size_;
   KeyVector keyBuf_;
   ValueVector valueBuf_;
-  CharVector surviveBuf_;
+  ClockCounters<CounterBits> counters_;
+  // slots holding no key, consumed by insert before sweeping.
+  IndexVector freeList_;
   const size_t capacity_;
-  size_t cur_idx_;
-  size_t evict_idx_;
+
+private:
+  /**
+   * resetFreeList pushes every slot into freeList_, slot 0 is consumed first.
+   * Caller holds the unique lock.
+   */
+  void resetFreeList();
+
+  static uint64_t hash(const TKey &key) {
+    return static_cast<uint64_t>(THash{}(key));
+  }
+
+  /**
+   * lookup returns the index_ position of key, NPOS if not found.
+   */
+  size_t lookup(const TKey &key, uint64_t keyHash) const {
+    return index_.find(keyHash, [this, &key](uint32_t slot) {
+      return TKeyEqual{}(keyBuf_[slot], key);
+    });
+  }
+
+  /**
+   * link and unlink add/remove the slot to/from index_.
+   * Caller holds the unique lock, link requires keyBuf_ of all linked slots
+   * since index_ may rehash.
+   */
+  void link(uint64_t keyHash, size_t slot);
+  void unlink(size_t pos);
+
+  /**
+   * writeSlot overwrites the slot's key and value, readers observe the slot's
+   * sequence odd meanwhile. Caller holds the unique lock.
+   */
+  void writeSlot(size_t slot, const TKey &key, const TValue &value);
+
+  /**
+   * seqBegin and seqEnd bracket a write guarded by seq, writers are
+   * serialized by the unique lock.
+   */
+  template <typename TSeq> static void seqBegin(std::atomic<TSeq> &seq) {
+    seq.store(seq.load(std::memory_order_relaxed) + 1,
+              std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+  }
+  template <typename TSeq> static void seqEnd(std::atomic<TSeq> &seq) {
+    seq.store(seq.load(std::memory_order_relaxed) + 1,
+              std::memory_order_release);
+  }
+
+  /**
+   * optimisticFind looks key up without the lock, returns false if the result
+   * couldn't be validated.
+   */
+  bool optimisticFind(const TKey &key, uint64_t keyHash, Optional &result);
 
 public:
   explicit LRUClockCache(size_t size);
 
-  ~LRUClockCache() noexcept { clear(); }
+  ~LRUClockCache() noexcept = default;
 
   LRUClockCache(const LRUClockCache &other) = delete;
   LRUClockCache &operator=(const LRUClockCache &) = delete;
 
-  typename HashMap::size_type size() const { return hash_map_.size(); }
+  size_t size() const { return size_.load(std::memory_order_relaxed); }
   constexpr size_t capacity() const noexcept { return capacity_; }
 
+  /**
+   * clear resets all slots and the free list. Not thread-safe.
+   */
   void clear() noexcept;
+
+  /**
+   * erase resets the key's slot and hands it to the free list,
+   * the slot is reused by the next insert.
+   */
   size_t erase(const TKey &key);
   Optional find(const TKey &key);
+
+  /**
+   * visit calls fn(const TValue &) on the stored value under the shared lock,
+   * returns true if key exist. fn must not access the cache.
+   */
+  template <typename TFn> bool visit(const TKey &key, TFn &&fn);
   bool insert(const TKey &key, const TValue &value);
 };
 
-template <typename TKey, typename TValue, typename THash, typename TKeyEqual>
-LRUClockCache<TKey, TValue, THash, TKeyEqual>::LRUClockCache(size_t size)
-    : surviveBuf_(size), capacity_(size), cur_idx_(0),
-      evict_idx_(capacity_ / 2) {
-  hash_map_.reserve(capacity_);
+template <typename TKey, typename TValue, typename THash, typename TKeyEqual,
+          size_t CounterBits, typename TMutex>
+LRUClockCache<TKey, TValue, THash, TKeyEqual, CounterBits,
+              TMutex>::LRUClockCache(size_t size)
+    // index_ never doubles holding at most size slots, its buffers stay put
+    // under optimistic readers.
+    : index_(size), indexSeq_(0), slotSeq_(OptimisticRead ? size : 0),
+      size_(0), counters_(size), freeList_(), capacity_(size) {
+  if (capacity_ >= std::numeric_limits<uint32_t>::max()) {
+    throw std::length_error("LRUClockCache: size exceeds 32 bits slot index");
+  }
+
   keyBuf_.resize(capacity_);
   valueBuf_.resize(capacity_);
+  resetFreeList();
+}
+
+template <typename TKey, typename TValue, typename THash, typename TKeyEqual,
+          size_t CounterBits, typename TMutex>
+void LRUClockCache<TKey, TValue, THash, TKeyEqual, CounterBits,
+                   TMutex>::resetFreeList() {
+  freeList_.clear();
+  freeList_.reserve(capacity_);
+
+  for (size_t i = capacity_; i > 0; i--) {
+    freeList_.push_back(i - 1);
+  }
 }
 
-template <typename TKey, typename TValue, typename THash, typename TKeyEqual>
-void LRUClockCache<TKey, TValue, THash, TKeyEqual>::clear() noexcept {
-  hash_map_.clear();
+template <typename TKey, typename TValue, typename THash, typename TKeyEqual,
+          size_t CounterBits, typename TMutex>
+void LRUClockCache<TKey, TValue, THash, TKeyEqual, CounterBits, TMutex>::link(
+    uint64_t keyHash, size_t slot) {
+  seqBegin(indexSeq_);
+  index_.insert(keyHash, static_cast<uint32_t>(slot),
+                [this](uint32_t linked) { return hash(keyBuf_[linked]); });
+  seqEnd(indexSeq_);
+  size_.fetch_add(1, std::memory_order_relaxed);
 }
 
-template <typename TKey, typename TValue, typename THash, typename TKeyEqual>
-size_t LRUClockCache<TKey, TValue, THash, TKeyEqual>::erase(const TKey &key) {
+template <typename TKey, typename TValue, typename THash, typename TKeyEqual,
+          size_t CounterBits, typename TMutex>
+void LRUClockCache<TKey, TValue, THash, TKeyEqual, CounterBits, TMutex>::unlink(
+    size_t pos) {
+  seqBegin(indexSeq_);
+  index_.erase(pos);
+  seqEnd(indexSeq_);
+  size_.fetch_sub(1, std::memory_order_relaxed);
+}
+
+template <typename TKey, typename TValue, typename THash, typename TKeyEqual,
+          size_t CounterBits, typename TMutex>
+void LRUClockCache<TKey, TValue, THash, TKeyEqual, CounterBits,
+                   TMutex>::writeSlot(size_t slot, const TKey &key,
+                                      const TValue &value) {
+  if constexpr (OptimisticRead) {
+    seqBegin(slotSeq_[slot]);
+  }
+
+  keyBuf_[slot] = key;
+  valueBuf_[slot] = value;
+
+  if constexpr (OptimisticRead) {
+    seqEnd(slotSeq_[slot]);
+  }
+}
+
+template <typename TKey, typename TValue, typename THash, typename TKeyEqual,
+          size_t CounterBits, typename TMutex>
+bool LRUClockCache<TKey, TValue, THash, TKeyEqual, CounterBits,
+                   TMutex>::optimisticFind(const TKey &key, uint64_t keyHash,
+                                           Optional &result) {
+  const uint64_t indexSeq = indexSeq_.load(std::memory_order_acquire);
+  if (indexSeq & 1) {
+    return false;
+  }
+
+  bool conflict = false;
+  size_t found = NPOS;
+
+  // index_ entries may be stale, a slot read is validated by the slot's
+  // sequence, the probe as a whole by indexSeq_ below.
+#if defined(__SANITIZE_THREAD__)
+  AnnotateIgnoreReadsBegin(__FILE__, __LINE__);
+#endif
+  index_.find(keyHash, [&](uint32_t slot) {
+    if (slot >= capacity_) {
+      conflict = true;
+      return false;
+    }
+
+    const uint32_t seq = slotSeq_[slot].load(std::memory_order_acquire);
+    if (seq & 1) {
+      conflict = true;
+      return false;
+    }
+
+    // seqlock read, result is discarded if the slot changed meanwhile.
+    bool matched = TKeyEqual{}(keyBuf_[slot], key);
+    TValue copy;
+    std::memcpy(static_cast<void *>(&copy),
+                static_cast<const void *>(&valueBuf_[slot]), sizeof(TValue));
+
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (slotSeq_[slot].load(std::memory_order_relaxed) != seq) {
+      conflict = true;
+      return false;
+    }
+
+    if (matched) {
+      result = copy;
+      found = slot;
+    }
+    return matched;
+  });
+#if defined(__SANITIZE_THREAD__)
+  AnnotateIgnoreReadsEnd(__FILE__, __LINE__);
+#endif
+
+  // a hit or a miss is valid only if no index update overlapped the probe. A
+  // hit through an entry unlinked meanwhile may read the slot erase() reset to
+  // TKey{} / TValue{}, which matches key TKey{}.
+  std::atomic_thread_fence(std::memory_order_acquire);
+  if (conflict || indexSeq_.load(std::memory_order_relaxed) != indexSeq) {
+    return false;
+  }
+
+  if (found != NPOS) {
+    counters_.touch(found);
+  }
+  return true;
+}
+
+template <typename TKey, typename TValue, typename THash, typename TKeyEqual,
+          size_t CounterBits, typename TMutex>
+void LRUClockCache<TKey, TValue, THash, TKeyEqual, CounterBits,
+                   TMutex>::clear() noexcept {
+  index_.clear();
+  size_ = 0;
+
+  std::fill(keyBuf_.begin(), keyBuf_.end(), TKey{});
+  std::fill(valueBuf_.begin(), valueBuf_.end(), TValue{});
+  counters_.clear();
+
+  resetFreeList();
+}
+
+template <typename TKey, typename TValue, typename THash, typename TKeyEqual,
+          size_t CounterBits, typename TMutex>
+size_t LRUClockCache<TKey, TValue, THash, TKeyEqual, CounterBits,
+                     TMutex>::erase(
+    const TKey &key) {
+  uint64_t keyHash = hash(key);
   std::unique_lock lock(mutex_);
-  return hash_map_.erase(key);
+
+  size_t pos = lookup(key, keyHash);
+  if (pos == NPOS) {
+    return 0;
+  }
+
+  size_t idx = index_.slot(pos);
+  unlink(pos);
+
+  writeSlot(idx, TKey{}, TValue{});
+  counters_.reset(idx);
+  freeList_.push_back(idx);
+
+  return 1;
 }
 
-template <typename TKey, typename TValue, typename THash, typename TKeyEqual>
-typename LRUClockCache<TKey, TValue, THash, TKeyEqual>::Optional
-LRUClockCache<TKey, TValue, THash, TKeyEqual>::find(const TKey &key) {
+template <typename TKey, typename TValue, typename THash, typename TKeyEqual,
+          size_t CounterBits, typename TMutex>
+typename LRUClockCache<TKey, TValue, THash, TKeyEqual, CounterBits,
+                       TMutex>::Optional
+LRUClockCache<TKey, TValue, THash, TKeyEqual, CounterBits, TMutex>::find(
+    const TKey &key) {
+  uint64_t keyHash = hash(key);
+
+  if constexpr (OptimisticRead) {
+    if (Optional result; optimisticFind(key, keyHash, result)) {
+      return result;
+    }
+  }
+
   std::shared_lock lock(mutex_);
-  if (auto it = hash_map_.find(key); it != hash_map_.end()) {
-    surviveBuf_[it->second] = 1;
-    return valueBuf_[it->second];
+  if (size_t pos = lookup(key, keyHash); pos != NPOS) {
+    counters_.touch(index_.slot(pos));
+    return valueBuf_[index_.slot(pos)];
   } else {
     return {};
   }
 }
 
-template <typename TKey, typename TValue, typename THash, typename TKeyEqual>
-bool LRUClockCache<TKey, TValue, THash, TKeyEqual>::insert(
+template <typename TKey, typename TValue, typename THash, typename TKeyEqual,
+          size_t CounterBits, typename TMutex>
+template <typename TFn>
+bool LRUClockCache<TKey, TValue, THash, TKeyEqual, CounterBits, TMutex>::visit(
+    const TKey &key, TFn &&fn) {
+  uint64_t keyHash = hash(key);
+  std::shared_lock lock(mutex_);
+  if (size_t pos = lookup(key, keyHash); pos != NPOS) {
+    counters_.touch(index_.slot(pos));
+    fn(valueBuf_[index_.slot(pos)]);
+    return true;
+  }
+
+  return false;
+}
+
+template <typename TKey, typename TValue, typename THash, typename TKeyEqual,
+          size_t CounterBits, typename TMutex>
+bool LRUClockCache<TKey, TValue, THash, TKeyEqual, CounterBits, TMutex>::insert(
     const TKey &key, const TValue &value) {
+  uint64_t keyHash = hash(key);
   {
     std::shared_lock lock(mutex_);
-    if (auto it = hash_map_.find(key); it != hash_map_.end()) {
+    if (lookup(key, keyHash) != NPOS) {
       return false;
     }
   }
 
   std::unique_lock lock(mutex_);
-  // signed; use -1
-  long long victim_idx = -1;
+  // key inserted by another thread between the shared and the unique lock.
+  if (lookup(key, keyHash) != NPOS) {
+    return false;
+  }
 
-  while (victim_idx == -1) {
-    if (surviveBuf_[cur_idx_] > 0) {
-      surviveBuf_[cur_idx_] = 0;
-    }
+  // free slot holds no key, nothing to evict.
+  if (!freeList_.empty()) {
+    size_t free_idx = freeList_.back();
+    freeList_.pop_back();
 
-    cur_idx_++;
-    if (cur_idx_ >= capacity_) {
-      cur_idx_ = 0;
-    }
+    writeSlot(free_idx, key, value);
+    counters_.reset(free_idx);
+    link(keyHash, free_idx);
 
-    if (surviveBuf_[evict_idx_] == 0) {
-      victim_idx = static_cast<decltype(victim_idx)>(evict_idx_);
-    }
-
-    evict_idx_++;
-    if (evict_idx_ >= capacity_) {
-      evict_idx_ = 0;
-    }
+    return true;
   }
 
-  hash_map_.erase(keyBuf_[static_cast<size_t>(victim_idx)]);
+  // free list is empty, every slot holds a live key. Optimistic find may
+  // touch counters meanwhile, see ClockCounters.
+  size_t victim_idx = counters_.evict();
+
+  const TKey &victim = keyBuf_[victim_idx];
+  unlink(lookup(victim, hash(victim)));
 
-  keyBuf_[static_cast<size_t>(victim_idx)] = key;
-  valueBuf_[static_cast<size_t>(victim_idx)] = value;
-  surviveBuf_[static_cast<size_t>(victim_idx)] = 0;
-  hash_map_.emplace(key, static_cast<size_t>(victim_idx));
+  writeSlot(victim_idx, key, value);
+  counters_.reset(victim_idx);
+  link(keyHash, victim_idx);
 
   return true;
 }
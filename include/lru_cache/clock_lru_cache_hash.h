@@ -1,6 +1,7 @@
 #pragma once
 
 #include <ats_type.h>
+#include <lru_cache/lockfree_clock_cache.h>
 
 #include <boost/functional/hash.hpp>
 #include <cstdint>
@@ -51,6 +52,11 @@ struct hash<AtsPluginUtils::IpAddress> {
   }
 };
 
+template <>
+struct hash<AtsPluginUtils::PackedIpKey> {
+  std::size_t operator()(AtsPluginUtils::PackedIpKey const& ip) const noexcept { return ip.hash(); }
+};
+
 template <>
 struct equal_to<AtsPluginUtils::IpAddress> {
   bool operator()(const AtsPluginUtils::IpAddress& lhs, const AtsPluginUtils::IpAddress& rhs) const {
@@ -59,3 +65,12 @@ struct equal_to<AtsPluginUtils::IpAddress> {
 };
 
 }  // namespace std
+
+namespace vsdmars {
+/**
+ * AtsPluginUtils::IpAddress is a union of sockaddr types without pointers,
+ * its user defined copy operations are plain memcpy.
+ */
+template <>
+struct is_bitwise_copyable<AtsPluginUtils::IpAddress> : std::true_type {};
+}  // namespace vsdmars
@@ -0,0 +1,148 @@
+/**
+ * @author shchang
+ *
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace vsdmars {
+
+/**
+ * DistributedSharedMutex is a big-reader lock meeting the SharedMutex
+ * requirements, usable as LRUClockCache's TMutex.
+ *
+ * Reader indicators are spread over cache line sized slots, one slot per
+ * hardware thread rounded up to power of 2. A thread always uses the same slot,
+ * assigned round-robin on its first lock, so lock_shared() / unlock_shared()
+ * only write to a cache line shared with few or no other threads.
+ *
+ * A writer serializes with other writers, raises the writer flag and waits
+ * until every reader slot drained, its cost grows with the slot count. Readers
+ * arriving while the flag is raised back off until the writer unlocks, thus
+ * writers are not starved by a continuous stream of readers.
+ *
+ * Suited to read-mostly workloads, std::shared_mutex is cheaper when writes are
+ * frequent.
+ *
+ */
+class DistributedSharedMutex final {
+private:
+  struct alignas(64) Slot final {
+    std::atomic<uint32_t> readers_{0};
+  };
+
+  std::vector<Slot> slots_;
+  const size_t mask_;
+  std::mutex writerMutex_;
+  alignas(64) std::atomic<bool> writer_{false};
+
+private:
+  static size_t slotCount() {
+    size_t count = 1;
+    while (count < std::thread::hardware_concurrency()) {
+      count <<= 1;
+    }
+    return count;
+  }
+
+  /**
+   * threadSlot returns the calling thread's slot number, the same across all
+   * DistributedSharedMutex instances.
+   */
+  static size_t threadSlot() {
+    static std::atomic<size_t> next{0};
+    thread_local size_t slot = next.fetch_add(1, std::memory_order_relaxed);
+    return slot;
+  }
+
+  Slot &slot() { return slots_[threadSlot() & mask_]; }
+
+  /**
+   * waitReaders waits until every reader slot drained, writer flag raised.
+   */
+  void waitReaders() {
+    for (auto &slot : slots_) {
+      while (slot.readers_.load(std::memory_order_acquire) != 0) {
+        std::this_thread::yield();
+      }
+    }
+  }
+
+public:
+  DistributedSharedMutex() : slots_(slotCount()), mask_(slots_.size() - 1), writerMutex_() {}
+
+  DistributedSharedMutex(const DistributedSharedMutex &) = delete;
+  DistributedSharedMutex &operator=(const DistributedSharedMutex &) = delete;
+
+  void lock() {
+    writerMutex_.lock();
+
+    // pairs with the reader's increment then flag check, either the reader
+    // sees the flag or the writer sees the reader.
+    writer_.store(true, std::memory_order_seq_cst);
+    waitReaders();
+  }
+
+  bool try_lock() {
+    if (!writerMutex_.try_lock()) {
+      return false;
+    }
+
+    writer_.store(true, std::memory_order_seq_cst);
+    for (auto &slot : slots_) {
+      if (slot.readers_.load(std::memory_order_acquire) != 0) {
+        writer_.store(false, std::memory_order_release);
+        writerMutex_.unlock();
+        return false;
+      }
+    }
+
+    return true;
+  }
+
+  void unlock() {
+    writer_.store(false, std::memory_order_release);
+    writerMutex_.unlock();
+  }
+
+  void lock_shared() {
+    Slot &own = slot();
+
+    while (true) {
+      own.readers_.fetch_add(1, std::memory_order_seq_cst);
+      if (!writer_.load(std::memory_order_seq_cst)) {
+        return;
+      }
+
+      // back off until the writer unlocks.
+      own.readers_.fetch_sub(1, std::memory_order_release);
+      while (writer_.load(std::memory_order_relaxed)) {
+        std::this_thread::yield();
+      }
+    }
+  }
+
+  bool try_lock_shared() {
+    Slot &own = slot();
+
+    own.readers_.fetch_add(1, std::memory_order_seq_cst);
+    if (!writer_.load(std::memory_order_seq_cst)) {
+      return true;
+    }
+
+    own.readers_.fetch_sub(1, std::memory_order_release);
+    return false;
+  }
+
+  void unlock_shared() {
+    slot().readers_.fetch_sub(1, std::memory_order_release);
+  }
+};
+
+} // namespace vsdmars
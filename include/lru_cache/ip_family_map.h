@@ -0,0 +1,198 @@
+/**
+ * @author shchang
+ *
+ */
+
+#pragma once
+#include <ats_type.h>
+#include <lru_cache/lrucache.h>
+#include <lru_cache/spin_shared_mutex.h>
+#include <lru_cache/swiss_table.h>
+
+#include <cstdint>
+#include <mutex>
+#include <shared_mutex>
+#include <type_traits>
+#include <utility>
+
+namespace vsdmars {
+
+/**
+ * IpFamilyHashCompare is the TBB::HashCompare type for AtsPluginUtils::IpAddress
+ * routing on sa_family: an IPv4 address is hashed from its 4 bytes with a single
+ * multiply, any other address from its 16 bytes PackedIpKey in two multiply-fold
+ * rounds.
+ *
+ * Both the high bits (ScalableLRUCache shard selection) and the low bits (TBB
+ * bucket selection) of the hash code are mixed.
+ *
+ * It is transparent: const sockaddr* is hashed and compared against IpAddress
+ * directly, address text is parsed once into TextKey. key() builds the
+ * IpAddress for pre-oneTBB containers, which find the key type only.
+ *
+ */
+struct IpFamilyHashCompare final {
+  using is_transparent = void;
+  using TextKey = AtsPluginUtils::IpAddressText;
+
+  static size_t hash(uint32_t ipV4) {
+    const uint64_t mixed = (ipV4 + 1ULL) * 0x9E3779B97F4A7C15ULL;
+    return static_cast<size_t>(mixed ^ (mixed >> 32));
+  }
+
+  static size_t hash(const AtsPluginUtils::PackedIpKey& ipV6) { return ipV6.hash(); }
+
+  static size_t hash(const struct sockaddr* addr) {
+    return addr->sa_family == AF_INET ? hash(reinterpret_cast<const struct sockaddr_in*>(addr)->sin_addr.s_addr)
+                                      : hash(AtsPluginUtils::PackedIpKey{addr});
+  }
+
+  static size_t hash(const AtsPluginUtils::IpAddress& ip) { return hash(&ip.base); }
+
+  static bool equal(const AtsPluginUtils::IpAddress& k1, const AtsPluginUtils::IpAddress& k2) { return k1 == k2; }
+
+  static bool equal(const AtsPluginUtils::IpAddress& k1, const struct sockaddr* k2) { return k1.equals(k2); }
+
+  static AtsPluginUtils::IpAddress key(const struct sockaddr* addr) {
+    AtsPluginUtils::IpAddress ip;
+    ip.set(addr);
+    return ip;
+  }
+};
+
+/**
+ * IpFamilyMap is the LRUCache hash-map backend (see lrucache_map.h) for
+ * AtsPluginUtils::IpAddress keys, which routes on sa_family:
+ *  IPv4: SwissTable keyed by the 4 bytes address (uint32_t).
+ *  others: SwissTable keyed by the 16 bytes PackedIpKey.
+ * Each table is guarded by its own single word reader-writer lock, IPv4 and
+ * IPv6 lookups never contend with each other.
+ *
+ * The map hashes the packed address with IpFamilyHashCompare itself, the
+ * caller's THashCompare (HashedKeyCompare inside LRUCache) is not used. Since
+ * both tables live behind one LRUCache, they share its capacity and LRU list.
+ *
+ * The IPv4 table is sized for capacity, the IPv6 table for capacity / 8 and
+ * doubles on demand. An IpAddress of neither family is stored as "::".
+ *
+ * TKey is AtsPluginUtils::IpAddress or HashedKey<AtsPluginUtils::IpAddress, THash>.
+ * visit() also routes heterogeneous lookups (const sockaddr*, address text
+ * parsed by LRUCache) straight to the packed address, no IpAddress is
+ * constructed.
+ *
+ */
+template <typename TKey, typename TValue, typename THashCompare>
+class IpFamilyMap final {
+private:
+  using IpAddress = AtsPluginUtils::IpAddress;
+  using PackedIpKey = AtsPluginUtils::PackedIpKey;
+
+  // IPv6 table initial share of the capacity.
+  constexpr static size_t V6_SHARE = 8;
+
+  template <typename TPacked>
+  struct Table final {
+    using Slot = std::pair<TPacked, TValue>;
+    constexpr static size_t NPOS = SwissTable<Slot>::NPOS;
+
+    SpinSharedMutex mutex_;
+    SwissTable<Slot> table_;
+
+    explicit Table(size_t capacity) : mutex_(), table_(capacity) {}
+
+    size_t find(const TPacked& key, uint64_t keyHash) const {
+      return table_.find(keyHash, [&key](const Slot& slot) { return slot.first == key; });
+    }
+  };
+
+  Table<uint32_t> v4_;
+  Table<PackedIpKey> v6_;
+
+private:
+  /**
+   * route calls fn(table, packedKey) with the table of the address family.
+   */
+  template <typename TFn>
+  bool route(const struct sockaddr* addr, TFn&& fn) {
+    if (addr->sa_family == AF_INET) {
+      return fn(v4_, reinterpret_cast<const struct sockaddr_in*>(addr)->sin_addr.s_addr);
+    }
+    return fn(v6_, PackedIpKey{addr});
+  }
+
+  template <typename TFn>
+  bool route(const IpAddress& key, TFn&& fn) {
+    return route(&key.base, std::forward<TFn>(fn));
+  }
+
+  template <typename THash, typename TFn>
+  bool route(const HashedKey<IpAddress, THash>& key, TFn&& fn) {
+    return route(key.key_, std::forward<TFn>(fn));
+  }
+
+  // heterogeneous lookup of const sockaddr*, address text included.
+  template <typename TLookup, typename TFn>
+  bool route(const HashedLookup<TLookup>& key, TFn&& fn) {
+    return route(key.key_, std::forward<TFn>(fn));
+  }
+
+public:
+  IpFamilyMap(size_t capacity, size_t /* bucketCount */) : v4_(capacity), v6_(capacity / V6_SHARE) {}
+
+  IpFamilyMap(const IpFamilyMap&) = delete;
+  IpFamilyMap& operator=(const IpFamilyMap&) = delete;
+
+  // TProbe is TKey or a HashedLookup.
+  template <typename TProbe, typename TFn>
+  bool visit(const TProbe& key, TFn&& fn) {
+    return route(key, [&fn](auto& t, const auto& packed) {
+      const uint64_t keyHash = IpFamilyHashCompare::hash(packed);
+      std::shared_lock<SpinSharedMutex> lock(t.mutex_);
+
+      size_t pos = t.find(packed, keyHash);
+      if (pos == t.NPOS) {
+        return false;
+      }
+
+      fn(t.table_.slot(pos).second);
+      return true;
+    });
+  }
+
+  bool insert(const TKey& key, const TValue& value) {
+    return route(key, [&value](auto& t, const auto& packed) {
+      using Slot = typename std::decay_t<decltype(t)>::Slot;
+      const uint64_t keyHash = IpFamilyHashCompare::hash(packed);
+      std::unique_lock<SpinSharedMutex> lock(t.mutex_);
+
+      if (t.find(packed, keyHash) != t.NPOS) {
+        return false;
+      }
+
+      t.table_.insert(keyHash, Slot{packed, value},
+                      [](const Slot& slot) { return IpFamilyHashCompare::hash(slot.first); });
+      return true;
+    });
+  }
+
+  bool erase(const TKey& key) {
+    return route(key, [](auto& t, const auto& packed) {
+      const uint64_t keyHash = IpFamilyHashCompare::hash(packed);
+      std::unique_lock<SpinSharedMutex> lock(t.mutex_);
+
+      size_t pos = t.find(packed, keyHash);
+      if (pos == t.NPOS) {
+        return false;
+      }
+
+      t.table_.erase(pos);
+      return true;
+    });
+  }
+
+  void clear() noexcept {
+    v4_.table_.clear();
+    v6_.table_.clear();
+  }
+};
+}  // namespace vsdmars
@@ -0,0 +1,233 @@
+/**
+ * @author shchang
+ *
+ */
+
+#pragma once
+#include <ats_type.h>
+#include <lru_cache/lrucache_tbb.h>
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <random>
+
+#if defined(__SSE4_2__)
+#include <nmmintrin.h>
+#endif
+
+namespace vsdmars {
+
+/**
+ * IpHashFamily selects the hash function of IpHashCompare:
+ *  Compat: twang_mix64 chained with boost::hash_combine, the hash codes of
+ *          tbb::tbb_hash_compare<AtsPluginUtils::IpAddress>.
+ *  Wy:     wyhash style, the address words multiplied 64x64->128 bits and
+ *          folded, twice.
+ *  Crc32c: CRC32C of the address (SSE4.2 crc32 instruction when compiled in,
+ *          table driven otherwise, same hash codes) spread with a multiply.
+ *  SipHash13: SipHash-1-3 of the address keyed with a per-process random key.
+ *
+ * Compat, Wy and Crc32c are fixed and public, an attacker choosing client
+ * addresses (e.g. across an IPv6 /64) can aim them at one bucket or one shard.
+ * SipHash13 is for caches keyed by attacker controlled addresses: its hash
+ * codes can't be predicted without the key, they differ from one process to
+ * the next.
+ *
+ */
+enum class IpHashFamily { Compat, Wy, Crc32c, SipHash13 };
+
+namespace detail {
+
+// CRC32C (Castagnoli, reflected polynomial 0x82F63B78) byte table.
+inline constexpr std::array<uint32_t, 256> makeCrc32cTable() {
+  std::array<uint32_t, 256> table{};
+  for (uint32_t i = 0; i < 256; i++) {
+    uint32_t crc = i;
+    for (int bit = 0; bit < 8; bit++) {
+      crc = (crc >> 1) ^ ((crc & 1U) != 0 ? 0x82F63B78U : 0U);
+    }
+    table[i] = crc;
+  }
+  return table;
+}
+
+inline constexpr std::array<uint32_t, 256> CRC32C_TABLE = makeCrc32cTable();
+
+/**
+ * crc32c accumulates the 8 bytes of word (little endian) into crc as the
+ * SSE4.2 crc32 instruction does, without the initial / final inversion.
+ */
+inline uint32_t crc32c(uint32_t crc, uint64_t word) {
+#if defined(__SSE4_2__)
+  return static_cast<uint32_t>(_mm_crc32_u64(crc, word));
+#else
+  for (int i = 0; i < 8; i++) {
+    crc = CRC32C_TABLE[(crc ^ static_cast<uint32_t>(word)) & 0xFFU] ^ (crc >> 8);
+    word >>= 8;
+  }
+  return crc;
+#endif
+}
+
+struct SipKey {
+  uint64_t k0;
+  uint64_t k1;
+};
+
+/**
+ * processSipKey returns the SipHash key of this process, drawn from
+ * std::random_device on first use.
+ */
+inline const SipKey& processSipKey() {
+  static const SipKey key = [] {
+    std::random_device device;
+    std::uniform_int_distribution<uint64_t> dist;
+    return SipKey{dist(device), dist(device)};
+  }();
+  return key;
+}
+
+/**
+ * sipHash13 is SipHash-1-3 of the len (up to 16) bytes message held little
+ * endian in lo and hi.
+ */
+inline uint64_t sipHash13(const SipKey& key, uint64_t lo, uint64_t hi, size_t len) {
+  uint64_t v0 = key.k0 ^ 0x736f6d6570736575ULL;
+  uint64_t v1 = key.k1 ^ 0x646f72616e646f6dULL;
+  uint64_t v2 = key.k0 ^ 0x6c7967656e657261ULL;
+  uint64_t v3 = key.k1 ^ 0x7465646279746573ULL;
+
+  auto rotl = [](uint64_t x, int bits) { return (x << bits) | (x >> (64 - bits)); };
+  auto round = [&] {
+    v0 += v1;
+    v1 = rotl(v1, 13) ^ v0;
+    v0 = rotl(v0, 32);
+    v2 += v3;
+    v3 = rotl(v3, 16) ^ v2;
+    v0 += v3;
+    v3 = rotl(v3, 21) ^ v0;
+    v2 += v1;
+    v1 = rotl(v1, 17) ^ v2;
+    v2 = rotl(v2, 32);
+  };
+  auto compress = [&](uint64_t m) {
+    v3 ^= m;
+    round();
+    v0 ^= m;
+  };
+
+  // full 8 bytes words, then the last 0-7 bytes with the length in the top byte.
+  const uint64_t tail = static_cast<uint64_t>(len) << 56;
+  if (len == 16) {
+    compress(lo);
+    compress(hi);
+    compress(tail);
+  } else if (len >= 8) {
+    compress(lo);
+    compress(tail | (hi & ((1ULL << ((len - 8) * 8)) - 1)));
+  } else {
+    compress(tail | (lo & ((1ULL << (len * 8)) - 1)));
+  }
+
+  v2 ^= 0xff;
+  round();
+  round();
+  round();
+  return v0 ^ v1 ^ v2 ^ v3;
+}
+
+}  // namespace detail
+
+/**
+ * IpHashCompare is the TBB::HashCompare type for AtsPluginUtils::IpAddress with
+ * a selectable hash function, e.g.
+ *
+ *   ScalableLRUCache<IpAddress, TValue, IpHashCompare<IpHashFamily::Wy>>
+ *
+ * ScalableLRUCache selects the shard from the high 16 bits of the hash code,
+ * the backend the bucket from the low bits, all families mix both. Compat keeps
+ * the hash codes of the default tbb_hash_compare<IpAddress>, ip_hash_benchmark
+ * compares the families' speed and bucket / shard distribution.
+ *
+ * It is transparent: const sockaddr* is hashed and compared against IpAddress
+ * directly, address text is parsed once into TextKey. key() builds the
+ * IpAddress for pre-oneTBB containers, which find the key type only.
+ *
+ */
+template <IpHashFamily Family>
+struct IpHashCompare final {
+  using is_transparent = void;
+  using TextKey = AtsPluginUtils::IpAddressText;
+
+  static size_t hash(const struct sockaddr* addr) {
+    if constexpr (Family == IpHashFamily::Compat) {
+      return tbb::tbb_hash_compare<AtsPluginUtils::IpAddress>::hash(addr);
+    } else {
+      uint64_t word[2] = {0, 0};
+      size_t len = 0;
+      if (addr->sa_family == AF_INET) {
+        word[0] = reinterpret_cast<const struct sockaddr_in*>(addr)->sin_addr.s_addr;
+        len = sizeof(struct in_addr);
+      } else if (addr->sa_family == AF_INET6) {
+        memcpy(word, reinterpret_cast<const struct sockaddr_in6*>(addr)->sin6_addr.s6_addr, sizeof(word));
+        len = sizeof(struct in6_addr);
+      }
+
+      if constexpr (Family == IpHashFamily::Wy) {
+        return wyHash(word[0], word[1], len);
+      } else if constexpr (Family == IpHashFamily::Crc32c) {
+        return crcHash(word[0], word[1], len);
+      } else {
+        return static_cast<size_t>(detail::sipHash13(detail::processSipKey(), word[0], word[1], len));
+      }
+    }
+  }
+
+  static size_t hash(const AtsPluginUtils::IpAddress& ip) { return hash(&ip.base); }
+
+  static bool equal(const AtsPluginUtils::IpAddress& k1, const AtsPluginUtils::IpAddress& k2) { return k1 == k2; }
+
+  static bool equal(const AtsPluginUtils::IpAddress& k1, const struct sockaddr* k2) { return k1.equals(k2); }
+
+  static AtsPluginUtils::IpAddress key(const struct sockaddr* addr) {
+    AtsPluginUtils::IpAddress ip;
+    ip.set(addr);
+    return ip;
+  }
+
+private:
+  // wyhash secrets.
+  static constexpr uint64_t WY_P0 = 0xa0761d6478bd642fULL;
+  static constexpr uint64_t WY_P1 = 0xe7037ed1a0b428dbULL;
+  static constexpr uint64_t WY_P2 = 0x8ebc6af09c88c6e3ULL;
+
+  // Fibonacci multiplier, odd: the low bits of the product stay a permutation of the CRC's low bits.
+  static constexpr uint64_t GOLDEN = 0x9E3779B97F4A7C15ULL;
+
+  __extension__ typedef unsigned __int128 uint128;
+
+  static uint64_t fold(uint64_t a, uint64_t b) {
+    const uint128 product = static_cast<uint128>(a) * static_cast<uint128>(b);
+    return static_cast<uint64_t>(product) ^ static_cast<uint64_t>(product >> 64);
+  }
+
+  // wyHash is wyhash's final round for inputs up to 16 bytes, the address length (family) salts it.
+  // The second round takes the words again, a word equal to its secret zeroes the first product only.
+  static size_t wyHash(uint64_t lo, uint64_t hi, size_t len) {
+    const uint128 product = static_cast<uint128>(lo ^ WY_P1) * static_cast<uint128>(hi ^ WY_P2);
+    return static_cast<size_t>(
+        fold(static_cast<uint64_t>(product) ^ lo ^ WY_P0 ^ len, static_cast<uint64_t>(product >> 64) ^ hi ^ WY_P1));
+  }
+
+  // crcHash spreads the 32 bits CRC over the 64 bits hash code, the high bits come out of the multiply.
+  static size_t crcHash(uint64_t lo, uint64_t hi, size_t len) {
+    uint32_t crc = detail::crc32c(static_cast<uint32_t>(len), lo);
+    if (len == sizeof(struct in6_addr)) {
+      crc = detail::crc32c(crc, hi);
+    }
+    return static_cast<size_t>(crc * GOLDEN);
+  }
+};
+
+}  // namespace vsdmars
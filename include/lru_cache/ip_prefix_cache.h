@@ -0,0 +1,305 @@
+/**
+ * @author shchang
+ */
+
+#pragma once
+#include <lru_cache/scale-lrucache.h>
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <utility>
+
+namespace LRUC {
+
+/**
+ * DeniedByInfoCode is the default IpPrefixCache denial predicate: a value with
+ * a non zero denialInfoCode is a denial.
+ */
+struct DeniedByInfoCode final {
+  template <class TValue>
+  bool operator()(const TValue& value) const {
+    return value.denialInfoCode != 0;
+  }
+};
+
+/**
+ * IpPrefixCache is a ScalableLRUCache of AtsPluginUtils::IpAddress keys
+ * aggregating IPv6 addresses rotated inside one prefix into a prefix entry:
+ *
+ *  /64: once threshold64 distinct addresses of a /64 are inserted denied, the
+ *       /64 gets an entry holding the denial inserted then.
+ *  /56: once threshold56 distinct addresses of a /56 are inserted denied, the
+ *       /56 gets an entry the same way.
+ *
+ * TIsDenied(const TValue&) tells denials from other verdicts. Only denials are
+ * counted and become prefix entries, other verdicts are always inserted
+ * exactly. A denied address inside an aggregated prefix is no longer inserted,
+ * thus an attacker rotating addresses inside a /64 or a /56 adds a bounded
+ * number of entries. Exact entries inserted before the aggregation stay until
+ * evicted. find() / visit() try the exact address, then its /64, then its /56.
+ * IPv4 addresses are cached exactly.
+ *
+ * Distinct addresses are counted per prefix in a LRU cache of prefixSize
+ * entries, each holding the address hashes of up to threshold addresses, thus
+ * an address denied again (e.g. once its exact entry is evicted) is counted
+ * once. A prefix whose count is evicted starts counting again. A prefix
+ * whose entry is evicted while its count survives is aggregated again by the
+ * next denial inside it.
+ *
+ */
+template <class TValue, class TIsDenied = DeniedByInfoCode,
+          class THash = tbb::tbb_hash_compare<AtsPluginUtils::IpAddress>,
+          template <class, class, class> class TMap = TbbHashMap>
+class IpPrefixCache final {
+private:
+  using IpAddress = AtsPluginUtils::IpAddress;
+  using Cache = ScalableLRUCache<IpAddress, TValue, THash, TMap>;
+
+  /**
+   * PrefixCount is the set of distinct address hashes of a prefix, up to
+   * capacity, filled in place by visit(). Slots fill in order and are never
+   * emptied, 0 marks an empty slot.
+   */
+  struct PrefixCount final {
+    std::unique_ptr<std::atomic<uint64_t>[]> hashes_;
+    uint32_t capacity_;
+
+    PrefixCount() : hashes_(), capacity_(0) {}
+    PrefixCount(uint32_t capacity, uint64_t addressHash)
+        : hashes_(new std::atomic<uint64_t>[capacity]), capacity_(capacity) {
+      for (uint32_t i = 0; i < capacity_; i++) {
+        hashes_[i].store(i == 0 ? addressHash : 0, std::memory_order_relaxed);
+      }
+    }
+    PrefixCount(const PrefixCount& rhs) : hashes_(new std::atomic<uint64_t>[rhs.capacity_]), capacity_(rhs.capacity_) {
+      for (uint32_t i = 0; i < capacity_; i++) {
+        hashes_[i].store(rhs.hashes_[i].load(std::memory_order_relaxed), std::memory_order_relaxed);
+      }
+    }
+    PrefixCount& operator=(const PrefixCount& rhs) {
+      PrefixCount copy{rhs};
+      std::swap(hashes_, copy.hashes_);
+      std::swap(capacity_, copy.capacity_);
+      return *this;
+    }
+
+    /**
+     * add adds addressHash (non 0) to the set, returns the distinct address
+     * count, capacity once the set is full.
+     */
+    uint32_t add(uint64_t addressHash) const {
+      uint32_t i = 0;
+      for (; i < capacity_; i++) {
+        uint64_t slot = hashes_[i].load(std::memory_order_relaxed);
+        if (slot == 0 && hashes_[i].compare_exchange_strong(slot, addressHash, std::memory_order_relaxed)) {
+          return i + 1;
+        }
+        // slot holds the hash of a concurrent add if the exchange failed.
+        if (slot == addressHash) {
+          break;
+        }
+      }
+
+      // known address, count the filled slots.
+      while (i < capacity_ && hashes_[i].load(std::memory_order_relaxed) != 0) {
+        i++;
+      }
+      return i;
+    }
+  };
+
+  using Counts = ScalableLRUCache<IpAddress, PrefixCount, THash, TMap>;
+
+  Cache exact_;
+  Cache prefixes_;
+  Counts counts_;
+  const uint32_t threshold64_;
+  const uint32_t threshold56_;
+
+private:
+  /**
+   * prefixKey returns the prefix key of an IPv6 address: host bits cleared and
+   * the prefix length stored in the last byte, /64 and /56 keys never equal.
+   */
+  static IpAddress prefixKey(const IpAddress& key, int prefixLen);
+
+  /**
+   * countAddress adds the address hashed to addressHash to the distinct
+   * addresses of prefix, counted up to threshold, returns the count, 0 if the
+   * count was evicted meanwhile.
+   */
+  uint32_t countAddress(const IpAddress& prefix, uint64_t addressHash, uint32_t threshold);
+
+public:
+  using ConstAccessor = typename Cache::ConstAccessor;
+
+  static constexpr int PREFIX_64 = 64;
+  static constexpr int PREFIX_56 = 56;
+
+  /**
+   * size: exact entries capacity.
+   * prefixSize: prefix entries capacity, and prefix counts capacity.
+   * threshold64 / threshold56: distinct addresses aggregating a /64 / a /56, 0 disables it.
+   * shardCount: shard count of each cache.
+   */
+  IpPrefixCache(size_t size, size_t prefixSize, uint32_t threshold64, uint32_t threshold56, size_t shardCount = 0);
+
+  IpPrefixCache(const IpPrefixCache&) = delete;
+  IpPrefixCache& operator=(const IpPrefixCache&) = delete;
+
+  /**
+   * erase removes the exact entry of key, the prefix entries covering it stay, see erasePrefixes().
+   */
+  size_t erase(const IpAddress& key) { return exact_.erase(key); }
+
+  /**
+   * erasePrefixes removes the /64 and /56 entries covering key and their counts.
+   */
+  size_t erasePrefixes(const IpAddress& key);
+
+  /**
+   * find looks up key, then its /64, then its /56.
+   */
+  bool find(ConstAccessor& caccessor, const IpAddress& key);
+
+  /**
+   * visit calls fn(const TValue&) on the entry find() would return.
+   */
+  template <typename TFn>
+  bool visit(const IpAddress& key, TFn&& fn);
+
+  /**
+   * insert inserts key/value unless key exists or, value being a denial, a
+   * prefix entry covers key, return true if inserted. Counts a denied key in
+   * its prefixes and aggregates them.
+   */
+  bool insert(const IpAddress& key, const TValue& value);
+
+  void clear() noexcept;
+
+  /**
+   * size returns the exact entry count, prefixSize the prefix entry count.
+   */
+  long long size() const { return exact_.size(); }
+  long long prefixSize() const { return prefixes_.size(); }
+
+  long long capacity() const { return exact_.capacity(); }
+};
+
+// ---- private member functions ----
+template <class TValue, class TIsDenied, class THash, template <class, class, class> class TMap>
+AtsPluginUtils::IpAddress IpPrefixCache<TValue, TIsDenied, THash, TMap>::prefixKey(const IpAddress& key, int prefixLen) {
+  IpAddress prefix;
+  prefix.base.sa_family = AF_INET6;
+  memcpy(prefix.v6.sin6_addr.s6_addr, key.v6.sin6_addr.s6_addr, static_cast<size_t>(prefixLen / 8));
+  prefix.v6.sin6_addr.s6_addr[15] = static_cast<uint8_t>(prefixLen);
+  return prefix;
+}
+
+template <class TValue, class TIsDenied, class THash, template <class, class, class> class TMap>
+uint32_t IpPrefixCache<TValue, TIsDenied, THash, TMap>::countAddress(const IpAddress& prefix, uint64_t addressHash,
+                                                                     uint32_t threshold) {
+  uint32_t count = 0;
+  auto add = [addressHash, &count](const PrefixCount& prefixCount) { count = prefixCount.add(addressHash); };
+
+  if (counts_.visit(prefix, add)) {
+    return count;
+  }
+  if (counts_.insert(prefix, PrefixCount{threshold, addressHash})) {
+    return 1;
+  }
+
+  // lost the insert race, count on the winner's entry.
+  counts_.visit(prefix, add);
+  return count;
+}
+// ---- private member functions end ----
+
+template <class TValue, class TIsDenied, class THash, template <class, class, class> class TMap>
+IpPrefixCache<TValue, TIsDenied, THash, TMap>::IpPrefixCache(size_t size, size_t prefixSize, uint32_t threshold64,
+                                                  uint32_t threshold56, size_t shardCount)
+    : exact_(size, shardCount),
+      prefixes_(prefixSize, shardCount),
+      counts_(prefixSize, shardCount),
+      threshold64_(threshold64),
+      threshold56_(threshold56) {}
+
+template <class TValue, class TIsDenied, class THash, template <class, class, class> class TMap>
+size_t IpPrefixCache<TValue, TIsDenied, THash, TMap>::erasePrefixes(const IpAddress& key) {
+  if (key.base.sa_family != AF_INET6) {
+    return 0;
+  }
+
+  size_t erased = 0;
+  for (int prefixLen : {PREFIX_64, PREFIX_56}) {
+    const IpAddress prefix = prefixKey(key, prefixLen);
+    erased += prefixes_.erase(prefix);
+    counts_.erase(prefix);
+  }
+  return erased;
+}
+
+template <class TValue, class TIsDenied, class THash, template <class, class, class> class TMap>
+bool IpPrefixCache<TValue, TIsDenied, THash, TMap>::find(ConstAccessor& caccessor, const IpAddress& key) {
+  if (exact_.find(caccessor, key)) {
+    return true;
+  }
+  if (key.base.sa_family != AF_INET6) {
+    return false;
+  }
+  return prefixes_.find(caccessor, prefixKey(key, PREFIX_64)) || prefixes_.find(caccessor, prefixKey(key, PREFIX_56));
+}
+
+template <class TValue, class TIsDenied, class THash, template <class, class, class> class TMap>
+template <typename TFn>
+bool IpPrefixCache<TValue, TIsDenied, THash, TMap>::visit(const IpAddress& key, TFn&& fn) {
+  if (exact_.visit(key, fn)) {
+    return true;
+  }
+  if (key.base.sa_family != AF_INET6) {
+    return false;
+  }
+  return prefixes_.visit(prefixKey(key, PREFIX_64), fn) || prefixes_.visit(prefixKey(key, PREFIX_56), fn);
+}
+
+template <class TValue, class TIsDenied, class THash, template <class, class, class> class TMap>
+bool IpPrefixCache<TValue, TIsDenied, THash, TMap>::insert(const IpAddress& key, const TValue& value) {
+  if (key.base.sa_family != AF_INET6 || !TIsDenied{}(value)) {
+    return exact_.insert(key, value);
+  }
+
+  const IpAddress prefix64 = prefixKey(key, PREFIX_64);
+  const IpAddress prefix56 = prefixKey(key, PREFIX_56);
+
+  auto covered = [](const TValue&) {};
+  if (prefixes_.visit(prefix64, covered) || prefixes_.visit(prefix56, covered)) {
+    return false;
+  }
+
+  if (!exact_.insert(key, value)) {
+    return false;
+  }
+
+  // a denial at or past the threshold aggregates the prefix, again if its
+  // entry was evicted while its count survived. Inserting an existing prefix
+  // entry is a no-op. 0 marks an empty PrefixCount slot.
+  const uint64_t hash = THash{}.hash(key);
+  const uint64_t addressHash = hash != 0 ? hash : 1;
+  if (threshold64_ != 0 && countAddress(prefix64, addressHash, threshold64_) >= threshold64_) {
+    prefixes_.insert(prefix64, value);
+  }
+  if (threshold56_ != 0 && countAddress(prefix56, addressHash, threshold56_) >= threshold56_) {
+    prefixes_.insert(prefix56, value);
+  }
+  return true;
+}
+
+template <class TValue, class TIsDenied, class THash, template <class, class, class> class TMap>
+void IpPrefixCache<TValue, TIsDenied, THash, TMap>::clear() noexcept {
+  exact_.clear();
+  prefixes_.clear();
+  counts_.clear();
+}
+}  // namespace LRUC
@@ -0,0 +1,249 @@
+/**
+ * @author shchang
+ *
+ */
+
+#pragma once
+#include <ats_type.h>
+#include <tbb/cache_aligned_allocator.h>
+
+// POSIX C header
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+namespace vsdmars {
+
+/**
+ * IpRangeIndex is a read-only index of sorted, disjoint IPv4 ranges to values
+ * (e.g. an allow / deny feed), for lists of millions of ranges changing
+ * rarely.
+ *
+ * The range starts are stored in Eytzinger (BFS) order: the search from the
+ * root goes to node 2k or 2k+1 without branching, and the 16 starts of the
+ * 4th level below the current node share a cache line (the starts are cache
+ * line aligned), prefetched while the 4 levels in between are read. A lookup
+ * thus waits on about log2(n)/4 memory reads where a binary search waits on
+ * log2(n).
+ *
+ * The index is built from Record arrays sorted by first, std::invalid_argument
+ * is thrown if ranges are not sorted, overlap or have first > last. load()
+ * builds it from a memory mapped file written by save(): FileHeader followed by
+ * the records, in host byte order.
+ *
+ * find() is thread-safe, it only reads. readThrough() serves a ScalableLRUCache
+ * miss from the index and fills the cache.
+ *
+ */
+template <class TValue>
+class IpRangeIndex final {
+  static_assert(std::is_trivially_copyable_v<TValue>, "IpRangeIndex values are read from files");
+
+public:
+  /**
+   * Record is the range [first, last] of IPv4 addresses in host byte order.
+   */
+  struct Record final {
+    uint32_t first;
+    uint32_t last;
+    TValue value;
+  };
+
+  /**
+   * FileHeader starts a file written by save().
+   */
+  struct FileHeader final {
+    char magic[8];
+    uint64_t count;
+    uint64_t recordSize;
+  };
+
+  static constexpr char MAGIC[8] = {'I', 'P', 'R', 'A', 'N', 'G', 'E', '1'};
+
+  IpRangeIndex() : firsts_(), lasts_(), values_() {}
+
+  IpRangeIndex(const Record* sorted, size_t count);
+
+  explicit IpRangeIndex(const std::vector<Record>& sorted) : IpRangeIndex(sorted.data(), sorted.size()) {}
+
+  /**
+   * load builds the index from the file at path, mapped read-only while
+   * building. Throws std::runtime_error if the file can't be read or is not a
+   * save() file of this Record type.
+   */
+  static IpRangeIndex load(const std::string& path);
+
+  /**
+   * save writes sorted records to the file at path, returns false on I/O error.
+   */
+  static bool save(const std::string& path, const std::vector<Record>& sorted);
+
+  /**
+   * find returns the value of the range holding ip (host byte order), nullptr
+   * if none does.
+   */
+  const TValue* find(uint32_t ip) const;
+
+  const TValue* find(const struct sockaddr* addr) const {
+    return addr->sa_family == AF_INET ? find(ntohl(reinterpret_cast<const struct sockaddr_in*>(addr)->sin_addr.s_addr))
+                                      : nullptr;
+  }
+
+  const TValue* find(const AtsPluginUtils::IpAddress& ip) const { return find(&ip.base); }
+
+  const TValue* find(std::string_view text) const {
+    const AtsPluginUtils::IpAddressText addr{text};
+    return find(&addr.base);
+  }
+
+  /**
+   * readThrough calls fn(const TValue&) on the value of key in cache (e.g. a
+   * ScalableLRUCache), on miss on the value of the range holding key, inserted
+   * into cache. Returns false if neither holds key, misses are not cached.
+   */
+  template <class TCache, class TFn>
+  bool readThrough(TCache& cache, const AtsPluginUtils::IpAddress& key, TFn&& fn) const {
+    if (cache.visit(key, fn)) {
+      return true;
+    }
+    const TValue* value = find(key);
+    if (value == nullptr) {
+      return false;
+    }
+    cache.insert(key, *value);
+    fn(*value);
+    return true;
+  }
+
+  /**
+   * size returns the range count.
+   */
+  size_t size() const { return lasts_.empty() ? 0 : lasts_.size() - 1; }
+
+private:
+  // Eytzinger order, node k at index k, index 0 unused.
+  std::vector<uint32_t, tbb::cache_aligned_allocator<uint32_t>> firsts_;
+  std::vector<uint32_t> lasts_;
+  std::vector<TValue> values_;
+
+  // fill places sorted[from..] in the subtree of node k in order, returns the next record.
+  size_t fill(const Record* sorted, size_t from, size_t k);
+};
+
+template <class TValue>
+IpRangeIndex<TValue>::IpRangeIndex(const Record* sorted, size_t count) : firsts_(), lasts_(), values_() {
+  for (size_t i = 0; i < count; i++) {
+    if (sorted[i].first > sorted[i].last || (i > 0 && sorted[i - 1].last >= sorted[i].first)) {
+      throw std::invalid_argument("IpRangeIndex: ranges are not sorted and disjoint");
+    }
+  }
+  if (count == 0) {
+    return;
+  }
+
+  firsts_.resize(count + 1);
+  lasts_.resize(count + 1);
+  values_.resize(count + 1);
+  fill(sorted, 0, 1);
+}
+
+template <class TValue>
+size_t IpRangeIndex<TValue>::fill(const Record* sorted, size_t from, size_t k) {
+  if (k < firsts_.size()) {
+    from = fill(sorted, from, 2 * k);
+    firsts_[k] = sorted[from].first;
+    lasts_[k] = sorted[from].last;
+    values_[k] = sorted[from].value;
+    from = fill(sorted, from + 1, 2 * k + 1);
+  }
+  return from;
+}
+
+template <class TValue>
+const TValue* IpRangeIndex<TValue>::find(uint32_t ip) const {
+  const size_t n = firsts_.size();
+  const uint32_t* firsts = firsts_.data();
+
+  // go right (bit 1) while the start is <= ip.
+  size_t k = 1;
+  while (k < n) {
+    __builtin_prefetch(firsts + std::min(16 * k, n - 1));
+    k = 2 * k + (firsts[k] <= ip ? 1 : 0);
+  }
+  // the last right turn is the range with the greatest start <= ip.
+  k >>= __builtin_ffsll(static_cast<long long>(k));
+  if (k == 0 || ip > lasts_[k]) {
+    return nullptr;
+  }
+  return &values_[k];
+}
+
+template <class TValue>
+IpRangeIndex<TValue> IpRangeIndex<TValue>::load(const std::string& path) {
+  const int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    throw std::runtime_error("IpRangeIndex: can't open " + path);
+  }
+
+  struct stat st {};
+  if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(FileHeader)) {
+    close(fd);
+    throw std::runtime_error("IpRangeIndex: not a range file " + path);
+  }
+
+  const size_t length = static_cast<size_t>(st.st_size);
+  void* mapped = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (mapped == MAP_FAILED) {
+    throw std::runtime_error("IpRangeIndex: can't map " + path);
+  }
+
+  FileHeader header;
+  memcpy(&header, mapped, sizeof(header));
+  if (memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || header.recordSize != sizeof(Record) ||
+      header.count > (length - sizeof(FileHeader)) / sizeof(Record)) {
+    munmap(mapped, length);
+    throw std::runtime_error("IpRangeIndex: not a range file of this record type " + path);
+  }
+
+  // the records follow the 24 bytes header, aligned for Record up to 8 bytes alignment.
+  static_assert(sizeof(FileHeader) % alignof(Record) == 0);
+  const auto* records = reinterpret_cast<const Record*>(static_cast<const char*>(mapped) + sizeof(FileHeader));
+  try {
+    IpRangeIndex index{records, static_cast<size_t>(header.count)};
+    munmap(mapped, length);
+    return index;
+  } catch (...) {
+    munmap(mapped, length);
+    throw;
+  }
+}
+
+template <class TValue>
+bool IpRangeIndex<TValue>::save(const std::string& path, const std::vector<Record>& sorted) {
+  FILE* file = fopen(path.c_str(), "wb");
+  if (file == nullptr) {
+    return false;
+  }
+
+  FileHeader header{};
+  memcpy(header.magic, MAGIC, sizeof(MAGIC));
+  header.count = sorted.size();
+  header.recordSize = sizeof(Record);
+  const bool written = fwrite(&header, sizeof(header), 1, file) == 1 &&
+                       fwrite(sorted.data(), sizeof(Record), sorted.size(), file) == sorted.size();
+  return fclose(file) == 0 && written;
+}
+
+}  // namespace vsdmars
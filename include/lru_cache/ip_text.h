@@ -0,0 +1,533 @@
+/**
+ * @author shchang
+ *
+ */
+#pragma once
+
+// POSIX C header
+#include <arpa/inet.h>
+#include <netinet/in.h>
+
+// CPP header
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#if defined(__SSSE3__)
+#include <tmmintrin.h>
+#endif
+
+namespace AtsPluginUtils {
+
+namespace detail {
+
+// decimal text of an octet, 3 chars copied and size kept.
+struct Octet {
+  char text[3];
+  uint8_t size;
+};
+
+constexpr std::array<Octet, 256> makeOctets() {
+  std::array<Octet, 256> octets{};
+  for (size_t i = 0; i < 256; i++) {
+    Octet& octet = octets[i];
+    if (i >= 100) {
+      octet = Octet{{static_cast<char>('0' + i / 100), static_cast<char>('0' + i / 10 % 10),
+                     static_cast<char>('0' + i % 10)},
+                    3};
+    } else if (i >= 10) {
+      octet = Octet{{static_cast<char>('0' + i / 10), static_cast<char>('0' + i % 10), 0}, 2};
+    } else {
+      octet = Octet{{static_cast<char>('0' + i), 0, 0}, 1};
+    }
+  }
+  return octets;
+}
+
+inline constexpr std::array<Octet, 256> OCTETS = makeOctets();
+
+#if defined(__SSSE3__)
+// shuffle of the 81 field length patterns (1 to 3 digits each), right aligning field i into bytes [4i, 4i + 3).
+struct V4Shuffle {
+  alignas(16) int8_t lane[81][16];
+};
+
+constexpr V4Shuffle makeV4Shuffle() {
+  V4Shuffle shuffle{};
+  for (size_t pattern = 0; pattern < 81; pattern++) {
+    size_t divisor = 27;
+    size_t start = 0;
+    for (size_t field = 0; field < 4; field++) {
+      const size_t size = (pattern / divisor) % 3 + 1;
+      for (size_t i = 0; i < 4; i++) {
+        shuffle.lane[pattern][field * 4 + i] = -1;
+      }
+      for (size_t i = 0; i < size; i++) {
+        shuffle.lane[pattern][field * 4 + 3 - size + i] = static_cast<int8_t>(start + i);
+      }
+      start += size + 1;
+      divisor /= 3;
+    }
+  }
+  return shuffle;
+}
+
+inline constexpr V4Shuffle V4_SHUFFLE = makeV4Shuffle();
+#endif
+}  // namespace detail
+
+/**
+ * IpText parses and formats IP address text without inet_pton / inet_ntop and without allocation.
+ *
+ * parse() accepts what inet_pton accepts: dotted-decimal IPv4 without leading zeros, IPv6 with at most one "::" and
+ * an optional dotted IPv4 tail. out is written only on success.
+ * The text is copied into zero padded blocks and classified 16 characters at a time with SSE2 into bit masks of
+ * digits, hex digits, dots and colons, the masks give the field boundaries. With SSSE3 the 4 IPv4 fields are gathered
+ * by a shuffle picked from the field lengths and converted with two multiply-adds, otherwise fields are converted
+ * scalar.
+ *
+ * format() writes what inet_ntop writes (longest zero run compressed, IPv4-mapped / IPv4-compatible addresses with a
+ * dotted tail) NUL-terminated into buf of size len, returns the text length, or 0 if len is smaller than
+ * INET_ADDRSTRLEN / INET6_ADDRSTRLEN.
+ *
+ */
+struct IpText final {
+  constexpr static size_t V4_MIN = 7;    // "0.0.0.0"
+  constexpr static size_t V4_MAX = 15;   // "255.255.255.255"
+  constexpr static size_t V6_MIN = 2;    // "::"
+  constexpr static size_t V6_MAX = INET6_ADDRSTRLEN - 1;
+
+  static bool parse(std::string_view text, struct in_addr* out) {
+    const size_t len = text.size();
+    if (len < V4_MIN || len > V4_MAX) {
+      return false;
+    }
+
+    alignas(16) char block[16];
+    copy(block, text.data(), len, 1);
+
+    Masks masks;
+    uint8_t nibble[16];
+    classify(block, 1, masks, nibble);
+    return parseV4(block, len, static_cast<uint32_t>(masks.digit), static_cast<uint32_t>(masks.dot), out);
+  }
+
+  static bool parse(std::string_view text, struct in6_addr* out) {
+    const size_t len = text.size();
+    if (len < V6_MIN || len > V6_MAX) {
+      return false;
+    }
+
+    const size_t blocks = (len + 15) / 16;
+    alignas(16) char block[48];
+    copy(block, text.data(), len, blocks);
+
+    // 4 zero nibbles ahead of the text, a group is read as the 4 nibbles ending at it.
+    Masks masks;
+    alignas(16) uint8_t nibbles[4 + 48] = {};
+    const uint8_t* nibble = nibbles + 4;
+    classify(block, blocks, masks, nibbles + 4);
+
+    const uint64_t all = (1ULL << len) - 1;
+    const uint64_t colon = masks.colon & all;
+    const uint64_t dot = masks.dot & all;
+    if (((masks.hex | colon | dot) & all) != all) {
+      return false;
+    }
+
+    // a dotted IPv4 tail follows the last colon.
+    size_t end = len;
+    if (dot != 0) {
+      if (colon == 0) {
+        return false;
+      }
+      end = static_cast<size_t>(64 - __builtin_clzll(colon));
+      if ((dot & ((1ULL << end) - 1)) != 0) {
+        return false;
+      }
+    }
+
+    uint16_t group[8];
+    size_t count = 0;
+    size_t gap = NO_GAP;
+    size_t pos = 0;
+
+    if (block[0] == ':') {
+      if (block[1] != ':') {
+        return false;
+      }
+      gap = 0;
+      pos = 2;
+    }
+
+    while (pos < end) {
+      const uint64_t rest = colon >> pos;
+      const size_t next = rest != 0 ? pos + static_cast<size_t>(__builtin_ctzll(rest)) : len;
+
+      // empty group, the "::".
+      if (next == pos) {
+        if (gap != NO_GAP) {
+          return false;
+        }
+        gap = count;
+        pos++;
+        continue;
+      }
+
+      if (next - pos > 4 || count == 8) {
+        return false;
+      }
+
+      // 1 to 4 nibbles, one per byte, packed into 16 bits.
+      uint32_t value;
+      memcpy(&value, nibble + next - 4, sizeof(value));
+      value = __builtin_bswap32(value) & static_cast<uint32_t>(~0ULL >> (64 - 8 * (next - pos)));
+      value = (value | (value >> 4)) & 0x00ff00ff;
+      group[count++] = static_cast<uint16_t>(value | (value >> 8));
+
+      if (next == len) {
+        break;
+      }
+
+      // a single trailing colon is allowed only before the IPv4 tail.
+      pos = next + 1;
+      if (pos == end && dot == 0) {
+        return false;
+      }
+    }
+
+    if (dot != 0) {
+      alignas(16) char tailBlock[16];
+      struct in_addr tail;
+      if (count > 6 || len - end > V4_MAX) {
+        return false;
+      }
+      copy(tailBlock, text.data() + end, len - end, 1);
+      if (!parseV4(tailBlock, len - end, static_cast<uint32_t>(masks.digit >> end), static_cast<uint32_t>(dot >> end),
+                   &tail)) {
+        return false;
+      }
+      uint8_t bytes[4];
+      memcpy(bytes, &tail.s_addr, sizeof(bytes));
+      group[count++] = static_cast<uint16_t>((bytes[0] << 8) | bytes[1]);
+      group[count++] = static_cast<uint16_t>((bytes[2] << 8) | bytes[3]);
+    }
+
+    uint8_t addr[16] = {};
+    if (gap == NO_GAP) {
+      if (count != 8) {
+        return false;
+      }
+      gap = count;
+    } else if (count == 8) {
+      // "::" expands to at least one zero group.
+      return false;
+    }
+
+    // groups after the gap are right aligned, the gap is zero filled.
+    const size_t after = count - gap;
+    for (size_t i = 0; i < count; i++) {
+      const size_t at = i < gap ? i : 8 - after + (i - gap);
+      addr[at * 2] = static_cast<uint8_t>(group[i] >> 8);
+      addr[at * 2 + 1] = static_cast<uint8_t>(group[i]);
+    }
+    memcpy(out, addr, sizeof(addr));
+    return true;
+  }
+
+  static size_t format(const struct in_addr& addr, char* buf, size_t len) {
+    if (len < INET_ADDRSTRLEN) {
+      return 0;
+    }
+
+    uint8_t bytes[4];
+    memcpy(bytes, &addr.s_addr, sizeof(bytes));
+    char* end = appendV4(buf, bytes);
+    *end = '\0';
+    return static_cast<size_t>(end - buf);
+  }
+
+  static size_t format(const struct in6_addr& addr, char* buf, size_t len) {
+    if (len < INET6_ADDRSTRLEN) {
+      return 0;
+    }
+
+    uint8_t bytes[16];
+    memcpy(bytes, &addr, sizeof(bytes));
+    uint16_t word[8];
+    for (size_t i = 0; i < 8; i++) {
+      word[i] = static_cast<uint16_t>((bytes[i * 2] << 8) | bytes[i * 2 + 1]);
+    }
+
+    // longest run of zero words (first one on ties), compressed only if it spans 2 words or more.
+    uint32_t run = zeroWords(bytes);
+    size_t runLen = 0;
+    uint32_t start = 0;
+    while (run != 0) {
+      start = run;
+      run &= run >> 1;
+      runLen++;
+    }
+    const size_t base = runLen >= 2 ? static_cast<size_t>(__builtin_ctz(start)) : 8;
+    if (runLen < 2) {
+      runLen = 0;
+    }
+
+    // IPv4-compatible (::a.b.c.d) and IPv4-mapped (::ffff:a.b.c.d) addresses keep the dotted tail.
+    const bool v4Tail = base == 0 && (runLen == 6 || (runLen == 5 && word[5] == 0xffff));
+
+    char* end = buf;
+    for (size_t i = 0; i < 8; i++) {
+      if (i >= base && i < base + runLen) {
+        if (i == base) {
+          *end++ = ':';
+        }
+        continue;
+      }
+      if (i != 0) {
+        *end++ = ':';
+      }
+      if (i == 6 && v4Tail) {
+        end = appendV4(end, bytes + 12);
+        break;
+      }
+      end = appendHex(end, word[i]);
+    }
+    if (runLen != 0 && base + runLen == 8) {
+      *end++ = ':';
+    }
+
+    *end = '\0';
+    return static_cast<size_t>(end - buf);
+  }
+
+private:
+  constexpr static size_t NO_GAP = ~size_t{0};
+
+  // one bit per character, bit i is the character i.
+  struct Masks {
+    uint64_t digit = 0;
+    uint64_t hex = 0;
+    uint64_t dot = 0;
+    uint64_t colon = 0;
+  };
+
+  /**
+   * copy writes len characters of text zero padded into 16 * blocks bytes of block.
+   * With SSE2 each block is assembled in a register and stored at once, the 16 bytes loads of classify() are then
+   * forwarded from the store, which a byte-wise memcpy prevents.
+   */
+  static void copy(char* block, const char* text, size_t len, size_t blocks) {
+#if defined(__SSE2__)
+    for (size_t b = 0; b < blocks; b++) {
+      const char* chunk = text + b * 16;
+      const size_t n = len - b * 16 < 16 ? len - b * 16 : 16;
+      __m128i chars;
+
+      if (n == 16) {
+        chars = _mm_loadu_si128(reinterpret_cast<const __m128i*>(chunk));
+      } else {
+        // overlapping loads of the first and last bytes, shifted into place.
+        uint64_t lo = 0;
+        uint64_t hi = 0;
+        if (n >= 8) {
+          memcpy(&lo, chunk, 8);
+          if (n > 8) {
+            memcpy(&hi, chunk + n - 8, 8);
+            hi >>= 8 * (16 - n);
+          }
+        } else if (n >= 4) {
+          uint32_t first;
+          uint32_t last;
+          memcpy(&first, chunk, 4);
+          memcpy(&last, chunk + n - 4, 4);
+          lo = first | (static_cast<uint64_t>(last) << (8 * (n - 4)));
+        } else if (n > 0) {
+          lo = static_cast<uint64_t>(static_cast<uint8_t>(chunk[0])) |
+               static_cast<uint64_t>(static_cast<uint8_t>(chunk[n / 2])) << (8 * (n / 2)) |
+               static_cast<uint64_t>(static_cast<uint8_t>(chunk[n - 1])) << (8 * (n - 1));
+        }
+        chars = _mm_set_epi64x(static_cast<long long>(hi), static_cast<long long>(lo));
+      }
+      _mm_store_si128(reinterpret_cast<__m128i*>(block + b * 16), chars);
+    }
+#else
+    memset(block, 0, blocks * 16);
+    memcpy(block, text, len);
+#endif
+  }
+
+  /**
+   * classify fills masks of 16 * blocks characters and the hex value of every hex digit into nibble.
+   */
+  static void classify(const char* block, size_t blocks, Masks& masks, uint8_t* nibble) {
+#if defined(__SSE2__)
+    const __m128i nine = _mm_set1_epi8(9);
+    const __m128i five = _mm_set1_epi8(5);
+    for (size_t b = 0; b < blocks; b++) {
+      const __m128i chars = _mm_load_si128(reinterpret_cast<const __m128i*>(block + b * 16));
+
+      // unsigned x <= limit is min(x, limit) == x.
+      const __m128i dec = _mm_sub_epi8(chars, _mm_set1_epi8('0'));
+      const __m128i isDigit = _mm_cmpeq_epi8(_mm_min_epu8(dec, nine), dec);
+      const __m128i alpha = _mm_sub_epi8(_mm_or_si128(chars, _mm_set1_epi8(0x20)), _mm_set1_epi8('a'));
+      const __m128i isAlpha = _mm_cmpeq_epi8(_mm_min_epu8(alpha, five), alpha);
+
+      const __m128i value = _mm_or_si128(_mm_and_si128(isDigit, dec),
+                                         _mm_and_si128(isAlpha, _mm_add_epi8(alpha, _mm_set1_epi8(10))));
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(nibble + b * 16), value);
+
+      const unsigned shift = static_cast<unsigned>(b * 16);
+      const auto bits = [shift](__m128i m) {
+        return static_cast<uint64_t>(static_cast<uint32_t>(_mm_movemask_epi8(m))) << shift;
+      };
+      masks.digit |= bits(isDigit);
+      masks.hex |= bits(_mm_or_si128(isDigit, isAlpha));
+      masks.dot |= bits(_mm_cmpeq_epi8(chars, _mm_set1_epi8('.')));
+      masks.colon |= bits(_mm_cmpeq_epi8(chars, _mm_set1_epi8(':')));
+    }
+#else
+    for (size_t i = 0; i < blocks * 16; i++) {
+      const uint8_t dec = static_cast<uint8_t>(block[i] - '0');
+      const uint8_t alpha = static_cast<uint8_t>((block[i] | 0x20) - 'a');
+      const uint64_t bit = 1ULL << i;
+
+      nibble[i] = 0;
+      if (dec <= 9) {
+        masks.digit |= bit;
+        masks.hex |= bit;
+        nibble[i] = dec;
+      } else if (alpha <= 5) {
+        masks.hex |= bit;
+        nibble[i] = static_cast<uint8_t>(alpha + 10);
+      } else if (block[i] == '.') {
+        masks.dot |= bit;
+      } else if (block[i] == ':') {
+        masks.colon |= bit;
+      }
+    }
+#endif
+  }
+
+  /**
+   * parseV4 converts len characters of dotted-decimal text, digit / dot are the masks of the text.
+   * 16 bytes from text are readable.
+   */
+  static bool parseV4(const char* text, size_t len, uint32_t digit, uint32_t dot, struct in_addr* out) {
+    if (len < V4_MIN || len > V4_MAX) {
+      return false;
+    }
+
+    const uint32_t all = (1U << len) - 1;
+    dot &= all;
+    if (((digit | dot) & all) != all) {
+      return false;
+    }
+
+    // field starts and lengths from exactly 3 dots, each field holds 1 to 3 digits.
+    size_t start[4];
+    size_t size[4];
+    start[0] = 0;
+    for (size_t i = 1; i < 4; i++) {
+      if (dot == 0) {
+        return false;
+      }
+      start[i] = static_cast<size_t>(__builtin_ctz(dot)) + 1;
+      dot &= dot - 1;
+      size[i - 1] = start[i] - start[i - 1] - 1;
+    }
+    if (dot != 0) {
+      return false;
+    }
+    size[3] = len - start[3];
+
+    for (size_t i = 0; i < 4; i++) {
+      if (size[i] - 1 >= 3 || (size[i] > 1 && text[start[i]] == '0')) {
+        return false;
+      }
+    }
+
+#if defined(__SSSE3__)
+    const size_t pattern = (size[0] - 1) * 27 + (size[1] - 1) * 9 + (size[2] - 1) * 3 + (size[3] - 1);
+    const __m128i digits = _mm_sub_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(text)), _mm_set1_epi8('0'));
+    const __m128i fields =
+        _mm_shuffle_epi8(digits, _mm_load_si128(reinterpret_cast<const __m128i*>(detail::V4_SHUFFLE.lane[pattern])));
+
+    // [hundreds, tens, ones, 0] per field, weighted to 2 shorts then summed to 1 int.
+    const __m128i pairs = _mm_maddubs_epi16(fields, _mm_setr_epi8(100, 10, 1, 0, 100, 10, 1, 0, 100, 10, 1, 0, 100, 10, 1, 0));
+    const __m128i values = _mm_madd_epi16(pairs, _mm_set1_epi16(1));
+    if (_mm_movemask_epi8(_mm_cmpgt_epi32(values, _mm_set1_epi32(255))) != 0) {
+      return false;
+    }
+
+    const __m128i packed =
+        _mm_shuffle_epi8(values, _mm_setr_epi8(0, 4, 8, 12, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1));
+    const uint32_t addr = static_cast<uint32_t>(_mm_cvtsi128_si32(packed));
+    memcpy(&out->s_addr, &addr, sizeof(addr));
+#else
+    uint8_t bytes[4];
+    for (size_t i = 0; i < 4; i++) {
+      unsigned value = 0;
+      for (size_t j = start[i]; j < start[i] + size[i]; j++) {
+        value = value * 10 + static_cast<unsigned>(text[j] - '0');
+      }
+      if (value > 255) {
+        return false;
+      }
+      bytes[i] = static_cast<uint8_t>(value);
+    }
+    memcpy(&out->s_addr, bytes, sizeof(bytes));
+#endif
+    return true;
+  }
+
+
+  // zeroWords returns one bit per zero 16 bits word of a big-endian IPv6 address.
+  static uint32_t zeroWords(const uint8_t* bytes) {
+#if defined(__SSE2__)
+    const __m128i words = _mm_loadu_si128(reinterpret_cast<const __m128i*>(bytes));
+    uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi16(words, _mm_setzero_si128())));
+    // 2 bits per word, keep one.
+    mask &= 0x5555;
+    mask = (mask | (mask >> 1)) & 0x3333;
+    mask = (mask | (mask >> 2)) & 0x0f0f;
+    mask = (mask | (mask >> 4)) & 0x00ff;
+    return mask;
+#else
+    uint32_t mask = 0;
+    for (size_t i = 0; i < 8; i++) {
+      if ((bytes[i * 2] | bytes[i * 2 + 1]) == 0) {
+        mask |= 1U << i;
+      }
+    }
+    return mask;
+#endif
+  }
+
+  static char* appendV4(char* end, const uint8_t* bytes) {
+    for (size_t i = 0; i < 4; i++) {
+      if (i != 0) {
+        *end++ = '.';
+      }
+      const detail::Octet& octet = detail::OCTETS[bytes[i]];
+      memcpy(end, octet.text, sizeof(octet.text));
+      end += octet.size;
+    }
+    return end;
+  }
+
+  static char* appendHex(char* end, uint16_t word) {
+    constexpr char HEX[] = "0123456789abcdef";
+    // number of hex digits without leading zeros, at least 1.
+    const int digits = word == 0 ? 1 : (32 - __builtin_clz(word) + 3) / 4;
+    for (int i = digits - 1; i >= 0; i--) {
+      *end++ = HEX[(word >> (i * 4)) & 0xf];
+    }
+    return end;
+  }
+};
+}  // namespace AtsPluginUtils
@@ -0,0 +1,408 @@
+/**
+ * @author shchang
+ *
+ */
+
+#pragma once
+#include <lru_cache/bitwise_copyable.h>
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <optional>
+#include <thread>
+#include <vector>
+
+namespace vsdmars {
+
+/**
+ * LockFreeClockCache is a CLOCK cache with the same API as LRUClockCache where
+ * find() is wait-free and insert() never serializes on a cache wide lock.
+ *
+ * Slots:
+ * Each slot owns a state word updated by CAS, packing the slot state
+ * (EMPTY / WRITING / VALID / REFERENCED) and a version bumped whenever the
+ * slot leaves VALID/REFERENCED. Readers copy the slot and validate the
+ * version afterwards (seqlock), thus TKey and TValue have to be bitwise
+ * copyable.
+ *
+ * Clock hand:
+ * An atomic hand any inserting thread advances. REFERENCED slots get a second
+ * chance (CAS to VALID), an EMPTY or VALID slot is claimed by CAS to WRITING.
+ *
+ * Index:
+ * Cache line sized buckets of 7 entries (32 bits hash tag, slot index) plus a
+ * spin lock word. find() probes one bucket without the lock, insert() and
+ * erase() take the bucket lock only for updating that bucket, which keeps a key
+ * indexed at most once. When a bucket is full the entry with the oldest slot
+ * is displaced: that key is evicted early, ahead of the clock hand and
+ * regardless of its reference bit, and its slot handed back to the clock.
+ *
+ * clear() clear the cache. Not thread safe.
+ *
+ * Type concepts:
+ * TKey type requires is_bitwise_copyable, Hash and EqualityComparable concept.
+ * TValue type requires is_bitwise_copyable and DefaultConstructible concept.
+ *
+ */
+template <typename TKey, typename TValue, typename THash = std::hash<TKey>, typename TKeyEqual = std::equal_to<TKey>>
+class LockFreeClockCache final {
+  static_assert(is_bitwise_copyable_v<TKey>, "TKey has to be bitwise copyable");
+  static_assert(is_bitwise_copyable_v<TValue>, "TValue has to be bitwise copyable");
+
+private:
+  // type defs
+  using Optional = std::optional<TValue>;
+
+  // slot states, lower 2 bits of slot state word, the rest is version.
+  enum : uint64_t { EMPTY = 0, WRITING = 1, VALID = 2, REFERENCED = 3 };
+  constexpr static uint64_t STATE_MASK = 3;
+
+  // index entries per bucket, the first word of bucket is the lock word.
+  constexpr static size_t BUCKET_ENTRIES = 7;
+
+  struct Slot final {
+    std::atomic<uint64_t> state_{EMPTY};
+    TKey key_{};
+    TValue value_{};
+  };
+
+  struct alignas(64) Bucket final {
+    std::atomic<uint64_t> lock_{0};
+    std::atomic<uint64_t> entries_[BUCKET_ENTRIES]{};
+  };
+
+  /**
+   * BucketLock is the RAII spin lock over Bucket::lock_.
+   */
+  class BucketLock final {
+  public:
+    explicit BucketLock(Bucket& bucket) : bucket_(bucket) {
+      while (bucket_.lock_.exchange(1, std::memory_order_acquire)) {
+        while (bucket_.lock_.load(std::memory_order_relaxed)) {
+          std::this_thread::yield();
+        }
+      }
+    }
+
+    ~BucketLock() { bucket_.lock_.store(0, std::memory_order_release); }
+
+    BucketLock(const BucketLock&) = delete;
+    BucketLock& operator=(const BucketLock&) = delete;
+
+  private:
+    Bucket& bucket_;
+  };
+
+private:
+  std::vector<Slot> slots_;
+  std::vector<Bucket> buckets_;
+  const size_t capacity_;
+  const unsigned bucketShift_;
+  std::atomic<size_t> hand_;
+  std::atomic<size_t> size_;
+
+private:
+  static constexpr uint64_t state(uint64_t word) { return word & STATE_MASK; }
+  static constexpr uint64_t version(uint64_t word) { return word >> 2; }
+  static constexpr uint64_t word(uint64_t ver, uint64_t st) { return (ver << 2) | st; }
+  static constexpr bool readable(uint64_t word) { return state(word) == VALID || state(word) == REFERENCED; }
+
+  // index entry: higher 32 bits hash tag, lower 32 bits slot index + 1, 0 as empty entry.
+  static constexpr uint64_t entry(size_t hash, size_t slotIdx) {
+    return (static_cast<uint64_t>(hash) & 0xffffffff00000000ULL) | (slotIdx + 1);
+  }
+  static constexpr bool tagMatch(uint64_t e, size_t hash) {
+    return e != 0 && (e >> 32) == (static_cast<uint64_t>(hash) >> 32);
+  }
+  static constexpr size_t slotIdx(uint64_t e) { return static_cast<size_t>(e & 0xffffffff) - 1; }
+
+  // Fibonacci hashing, spreads weak low-order bits over the buckets.
+  Bucket& bucket(size_t hash) {
+    return buckets_[(static_cast<uint64_t>(hash) * 0x9E3779B97F4A7C15ULL) >> bucketShift_];
+  }
+
+  /**
+   * indexed returns the entry position of key inside bucket, -1 if not found.
+   * Caller holds the bucket lock, keys of indexed readable slots are stable.
+   */
+  int indexed(Bucket& b, size_t hash, const TKey& key);
+
+  /**
+   * claimSlot advances the clock hand until a slot is claimed as WRITING.
+   * Returns the slot index and removes the victim's index entry.
+   */
+  size_t claimSlot();
+
+public:
+  explicit LockFreeClockCache(size_t size);
+
+  ~LockFreeClockCache() noexcept = default;
+
+  LockFreeClockCache(const LockFreeClockCache& other) = delete;
+  LockFreeClockCache& operator=(const LockFreeClockCache&) = delete;
+
+  size_t size() const { return size_.load(); }
+  constexpr size_t capacity() const noexcept { return capacity_; }
+
+  void clear() noexcept;
+  size_t erase(const TKey& key);
+  Optional find(const TKey& key);
+
+  /**
+   * visit calls fn(const TValue&) on a validated copy of the stored value,
+   * the slot may be rewritten concurrently thus no reference to it is handed
+   * out. Returns true if key exist.
+   */
+  template <typename TFn>
+  bool visit(const TKey& key, TFn&& fn);
+  bool insert(const TKey& key, const TValue& value);
+};
+
+// ---- private member functions ----
+template <typename TKey, typename TValue, typename THash, typename TKeyEqual>
+int LockFreeClockCache<TKey, TValue, THash, TKeyEqual>::indexed(Bucket& b, size_t hash, const TKey& key) {
+  for (size_t i = 0; i < BUCKET_ENTRIES; i++) {
+    uint64_t e = b.entries_[i].load(std::memory_order_relaxed);
+    if (!tagMatch(e, hash)) {
+      continue;
+    }
+
+    // WRITING slot is an evicted victim waiting for its entry to be removed.
+    Slot& slot = slots_[slotIdx(e)];
+    if (readable(slot.state_.load(std::memory_order_acquire)) && TKeyEqual{}(slot.key_, key)) {
+      return static_cast<int>(i);
+    }
+  }
+
+  return -1;
+}
+
+template <typename TKey, typename TValue, typename THash, typename TKeyEqual>
+size_t LockFreeClockCache<TKey, TValue, THash, TKeyEqual>::claimSlot() {
+  size_t spins = 0;
+
+  while (true) {
+    size_t idx = hand_.fetch_add(1, std::memory_order_relaxed) % capacity_;
+    Slot& slot = slots_[idx];
+    uint64_t w = slot.state_.load(std::memory_order_acquire);
+
+    switch (state(w)) {
+      case REFERENCED:
+        // second chance
+        slot.state_.compare_exchange_strong(w, word(version(w), VALID), std::memory_order_relaxed);
+        break;
+      case EMPTY:
+        if (slot.state_.compare_exchange_strong(w, word(version(w) + 1, WRITING), std::memory_order_acq_rel)) {
+          return idx;
+        }
+        break;
+      case VALID:
+        if (slot.state_.compare_exchange_strong(w, word(version(w) + 1, WRITING), std::memory_order_acq_rel)) {
+          // slot owned, victim key is stable until the slot is rewritten.
+          size_t hash = THash{}(slot.key_);
+          Bucket& b = bucket(hash);
+          BucketLock lock(b);
+
+          for (auto& e : b.entries_) {
+            uint64_t value = e.load(std::memory_order_relaxed);
+            if (value != 0 && slotIdx(value) == idx) {
+              e.store(0, std::memory_order_release);
+              size_--;
+              break;
+            }
+          }
+          return idx;
+        }
+        break;
+      default:  // WRITING
+        break;
+    }
+
+    // every slot is being written or referenced, let the other threads progress.
+    if (++spins % (capacity_ * 2) == 0) {
+      std::this_thread::yield();
+    }
+  }
+}
+// ---- private member functions end ----
+
+template <typename TKey, typename TValue, typename THash, typename TKeyEqual>
+LockFreeClockCache<TKey, TValue, THash, TKeyEqual>::LockFreeClockCache(size_t size)
+    : slots_(size),
+      buckets_([size] {
+        // average 2 entries per bucket keeps displacement rare.
+        // at least 2 buckets, Fibonacci hashing shifts by less than 64 bits.
+        size_t cnt = 2;
+        while (cnt * 2 < size) {
+          cnt <<= 1;
+        }
+        return cnt;
+      }()),
+      capacity_(size),
+      bucketShift_([this] {
+        unsigned bits = 0;
+        while ((size_t{1} << bits) < buckets_.size()) {
+          bits++;
+        }
+        return 64 - bits;
+      }()),
+      hand_(0),
+      size_(0) {}
+
+template <typename TKey, typename TValue, typename THash, typename TKeyEqual>
+void LockFreeClockCache<TKey, TValue, THash, TKeyEqual>::clear() noexcept {
+  for (auto& b : buckets_) {
+    for (auto& e : b.entries_) {
+      e.store(0, std::memory_order_relaxed);
+    }
+  }
+
+  for (auto& slot : slots_) {
+    uint64_t w = slot.state_.load(std::memory_order_relaxed);
+    slot.state_.store(word(version(w) + 1, EMPTY), std::memory_order_release);
+  }
+
+  hand_ = 0;
+  size_ = 0;
+}
+
+template <typename TKey, typename TValue, typename THash, typename TKeyEqual>
+size_t LockFreeClockCache<TKey, TValue, THash, TKeyEqual>::erase(const TKey& key) {
+  size_t hash = THash{}(key);
+  Bucket& b = bucket(hash);
+  BucketLock lock(b);
+
+  int pos = indexed(b, hash, key);
+  if (pos < 0) {
+    return 0;
+  }
+
+  Slot& slot = slots_[slotIdx(b.entries_[pos].load(std::memory_order_relaxed))];
+  b.entries_[pos].store(0, std::memory_order_release);
+  size_--;
+
+  // readers holding the removed entry fail version validation.
+  // CAS fails only if the clock hand claimed the slot meanwhile.
+  uint64_t w = slot.state_.load(std::memory_order_acquire);
+  while (readable(w) && !slot.state_.compare_exchange_weak(w, word(version(w) + 1, EMPTY), std::memory_order_acq_rel)) {
+  }
+
+  return 1;
+}
+
+template <typename TKey, typename TValue, typename THash, typename TKeyEqual>
+typename LockFreeClockCache<TKey, TValue, THash, TKeyEqual>::Optional
+LockFreeClockCache<TKey, TValue, THash, TKeyEqual>::find(const TKey& key) {
+  Optional result;
+  visit(key, [&result](const TValue& value) { result = value; });
+  return result;
+}
+
+template <typename TKey, typename TValue, typename THash, typename TKeyEqual>
+template <typename TFn>
+bool LockFreeClockCache<TKey, TValue, THash, TKeyEqual>::visit(const TKey& key, TFn&& fn) {
+  size_t hash = THash{}(key);
+  Bucket& b = bucket(hash);
+
+  for (auto& e : b.entries_) {
+    uint64_t value = e.load(std::memory_order_acquire);
+    if (!tagMatch(value, hash)) {
+      continue;
+    }
+
+    Slot& slot = slots_[slotIdx(value)];
+    uint64_t w1 = slot.state_.load(std::memory_order_acquire);
+    if (!readable(w1)) {
+      continue;
+    }
+
+    // seqlock read, result is discarded if the slot changed meanwhile.
+    bool matched = TKeyEqual{}(slot.key_, key);
+    TValue copy;
+    std::memcpy(static_cast<void*>(&copy), static_cast<const void*>(&slot.value_), sizeof(TValue));
+
+    std::atomic_thread_fence(std::memory_order_acquire);
+    uint64_t w2 = slot.state_.load(std::memory_order_relaxed);
+
+    if (!matched || !readable(w2) || version(w1) != version(w2)) {
+      continue;
+    }
+
+    if (state(w2) == VALID) {
+      // single attempt, losing the race still leaves the slot referenced or evicted.
+      slot.state_.compare_exchange_strong(w2, word(version(w2), REFERENCED), std::memory_order_relaxed);
+    }
+
+    fn(static_cast<const TValue&>(copy));
+    return true;
+  }
+
+  return false;
+}
+
+template <typename TKey, typename TValue, typename THash, typename TKeyEqual>
+bool LockFreeClockCache<TKey, TValue, THash, TKeyEqual>::insert(const TKey& key, const TValue& value) {
+  size_t hash = THash{}(key);
+  Bucket& b = bucket(hash);
+
+  {
+    BucketLock lock(b);
+    if (indexed(b, hash, key) >= 0) {
+      return false;
+    }
+  }
+
+  size_t idx = claimSlot();
+  Slot& slot = slots_[idx];
+  uint64_t ver = version(slot.state_.load(std::memory_order_relaxed));
+
+  std::atomic_thread_fence(std::memory_order_release);
+  slot.key_ = key;
+  slot.value_ = value;
+
+  BucketLock lock(b);
+
+  // key inserted by another thread after the first check.
+  if (indexed(b, hash, key) >= 0) {
+    slot.state_.store(word(ver + 1, EMPTY), std::memory_order_release);
+    return false;
+  }
+
+  slot.state_.store(word(ver, VALID), std::memory_order_release);
+
+  // prefer an empty entry, otherwise displace the entry farthest behind the clock hand.
+  size_t pos = 0;
+  size_t oldest = 0;
+  for (size_t i = 0; i < BUCKET_ENTRIES; i++) {
+    uint64_t e = b.entries_[i].load(std::memory_order_relaxed);
+    if (e == 0) {
+      pos = i;
+      break;
+    }
+
+    size_t age = (idx + capacity_ - slotIdx(e)) % capacity_;
+    if (age > oldest) {
+      oldest = age;
+      pos = i;
+    }
+  }
+
+  uint64_t displaced = b.entries_[pos].exchange(entry(hash, idx), std::memory_order_acq_rel);
+  if (displaced == 0) {
+    size_++;
+  } else {
+    // displaced slot is no longer reachable, hand it back to the clock.
+    Slot& dslot = slots_[slotIdx(displaced)];
+    uint64_t w = dslot.state_.load(std::memory_order_acquire);
+    while (readable(w) &&
+           !dslot.state_.compare_exchange_weak(w, word(version(w) + 1, EMPTY), std::memory_order_acq_rel)) {
+    }
+  }
+
+  return true;
+}
+
+}  // namespace vsdmars
@@ -4,17 +4,139 @@
  */
 
 #pragma once
+#include <lru_cache/bitwise_copyable.h>
+#include <lru_cache/lrucache_map.h>
 
+#include <algorithm>
 #include <atomic>
+#include <cstdint>
+#include <cstring>
 #include <memory>
 #include <mutex>
 #include <new>
-#include <tbb/concurrent_hash_map.h>
+#include <string_view>
 #include <thread>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
 namespace vsdmars {
 
+/**
+ * HashedKey pairs a key with its pre-computed hash code so the hash is
+ * calculated once per operation and reused for shard selection, bucket
+ * selection and as a cheap tag compared before the full key comparison.
+ *
+ * THash is the TBB::HashCompare type used for producing the hash code.
+ *
+ */
+template <typename TKey, typename THash>
+struct HashedKey final {
+  TKey key_;
+  size_t hash_;
+
+  HashedKey() : key_(), hash_(0) {}
+
+  // explicit to avoid hashing the key behind the caller's back.
+  explicit HashedKey(const TKey& key) : key_(key), hash_(THash{}.hash(key)) {}
+
+  HashedKey(const TKey& key, size_t hash) : key_(key), hash_(hash) {}
+};
+
+/**
+ * HashedLookup pairs a heterogeneous lookup form of the key (e.g. const
+ * sockaddr* for AtsPluginUtils::IpAddress) with its hash code. THash declares
+ * is_transparent and hashes / compares the form against TKey directly, so the
+ * lookup never constructs a TKey.
+ *
+ */
+template <typename TLookup>
+struct HashedLookup final {
+  TLookup key_;
+  size_t hash_{0};
+};
+
+/**
+ * IsLookup tells whether TLookup is a heterogeneous lookup form of TKey for
+ * THash: THash is transparent and hashes TLookup, which is not convertible to
+ * TKey (those are looked up as TKey).
+ *
+ */
+template <typename TKey, typename THash, typename TLookup, typename = void>
+struct IsLookup : std::false_type {};
+
+template <typename TKey, typename THash, typename TLookup>
+struct IsLookup<TKey, THash, TLookup,
+                std::void_t<typename THash::is_transparent, decltype(THash{}.hash(std::declval<const TLookup&>()))>>
+    : std::bool_constant<!std::is_convertible_v<const TLookup&, TKey>> {};
+
+/**
+ * hashLookup hashes a heterogeneous lookup form once with THash.
+ */
+template <typename THash, typename TLookup>
+HashedLookup<std::decay_t<const TLookup>> hashLookup(const TLookup& key) {
+  return HashedLookup<std::decay_t<const TLookup>>{key, THash{}.hash(key)};
+}
+
+/**
+ * IsTextLookup tells whether THash looks TText (e.g. std::string_view) up as
+ * text: THash declares TextKey, the text parsed once per lookup (e.g.
+ * AtsPluginUtils::IpAddressText), false if the text is not a key, whose
+ * lookup() is a heterogeneous lookup form of the key.
+ *
+ */
+template <typename THash, typename TText, typename = void>
+struct IsTextLookup : std::false_type {};
+
+template <typename THash, typename TText>
+struct IsTextLookup<THash, TText, std::void_t<typename THash::TextKey>>
+    : std::bool_constant<std::is_convertible_v<const TText&, std::string_view>> {};
+
+/**
+ * HashedKeyCompare is the TBB::HashCompare type for HashedKey.
+ * hash() returns the stored hash code without touching the key, equal()
+ * compares the hash codes first and falls back to THash::equal only when they
+ * match.
+ *
+ * It is transparent, HashedLookup is hashed and compared against HashedKey
+ * directly, e.g. by the heterogeneous find of tbb::concurrent_hash_map.
+ *
+ */
+template <typename TKey, typename THash>
+struct HashedKeyCompare final {
+  using is_transparent = void;
+
+  size_t hash(const HashedKey<TKey, THash>& k) const { return k.hash_; }
+
+  bool equal(const HashedKey<TKey, THash>& k1, const HashedKey<TKey, THash>& k2) const {
+    return k1.hash_ == k2.hash_ && THash{}.equal(k1.key_, k2.key_);
+  }
+
+  template <typename TLookup>
+  size_t hash(const HashedLookup<TLookup>& k) const {
+    return k.hash_;
+  }
+
+  template <typename TLookup>
+  bool equal(const HashedKey<TKey, THash>& k1, const HashedLookup<TLookup>& k2) const {
+    return k1.hash_ == k2.hash_ && THash{}.equal(k1.key_, k2.key_);
+  }
+
+  template <typename TLookup>
+  bool equal(const HashedLookup<TLookup>& k1, const HashedKey<TKey, THash>& k2) const {
+    return equal(k2, k1);
+  }
+
+  /**
+   * key builds the HashedKey of a heterogeneous lookup through THash::key,
+   * for containers which only find the key type (pre-oneTBB).
+   */
+  template <typename TLookup>
+  HashedKey<TKey, THash> key(const HashedLookup<TLookup>& k) const {
+    return HashedKey<TKey, THash>{THash{}.key(k.key_), k.hash_};
+  }
+};
+
 /**
  * LRUCache is a thread-safe Least Recently Used cache with defined size.
  *
@@ -37,6 +159,32 @@ namespace vsdmars {
  *
  * Internal double-linked list is guarded with mutex for modifying the list.
  *
+ * find(), insert() and erase() have overloads taking LRUCache::HashedKey
+ * which carries the key's pre-computed hash code, caller holds the hash code
+ * and the cache never hashes the key again.
+ *
+ * find() and visit() also take other forms of the key if THash is transparent
+ * (see HashedLookup), e.g. const sockaddr* or address text for
+ * AtsPluginUtils::IpAddress.
+ *
+ * TMap selects the hash-map backend, see lrucache_map.h:
+ *  TbbHashMap: tbb::concurrent_hash_map, lookup holds the bucket read lock.
+ *  TbbUnorderedMap: tbb::concurrent_unordered_map, lock-free lookup.
+ *  OpenAddressingMap: fixed-size linear probing table, lock-free lookup.
+ *  SwissMap: SIMD probed Swiss table under a single word reader-writer lock.
+ * The backends trade lookup cost against insert/erase cost, pick the one
+ * measured fastest for the deployment's read/write mix.
+ *
+ * Optimistic read:
+ * For bitwise copyable TValue of at most 2 cache lines over a backend whose
+ * lookup takes no lock (HasLockFreeLookup), each entry carries a sequence
+ * counter and update() overwrites the value in place, making the sequence odd
+ * meanwhile. find() and visit() copy the value and retry until the sequence
+ * didn't move, readers write no shared memory but the LRU list under its try
+ * lock. The backend keeps the entry alive during the lookup, thus find() takes
+ * no shared_ptr to the list node either. Backends holding a lock during the
+ * lookup (e.g. TbbHashMap) keep the locked copy.
+ *
  * Type concepts:
  * TKey type requires TBB::HashCompare concept.
  * TValue type requires CopyInsertable concept.
@@ -66,20 +214,31 @@ namespace vsdmars {
  *
  */
 
-template <typename TKey, typename TValue, typename THash = tbb::tbb_hash_compare<TKey>>
+template <typename TKey, typename TValue, typename THash = tbb::tbb_hash_compare<TKey>,
+          template <class, class, class> class TMap = TbbHashMap>
 class LRUCache final {
+public:
+  using HashedKey = vsdmars::HashedKey<TKey, THash>;
+
+  template <typename TLookup>
+  using EnableLookup = std::enable_if_t<IsLookup<TKey, THash, TLookup>::value>;
+
+  template <typename TText>
+  using EnableText = std::enable_if_t<IsTextLookup<THash, TText>::value, int>;
+
 private:
   // forward declaration
   struct Value;
   struct ListNode;
 
   // type defs
-  using HashMap = tbb::concurrent_hash_map<TKey, Value, THash>;
-  using HashMapConstAccessor = typename HashMap::const_accessor;
-  using HashMapAccessor = typename HashMap::accessor;
-  using HashMapValuePair = typename HashMap::value_type;
+  using HashMap = TMap<HashedKey, Value, HashedKeyCompare<TKey, THash>>;
   using ListMutex = std::mutex;
 
+public:
+  constexpr static bool OptimisticRead =
+      is_bitwise_copyable_v<TValue> && sizeof(TValue) <= 128 && HasLockFreeLookup<HashMap>::value;
+
 private:
   // static data members
   // used for judging a node exist inside the double-linked list.
@@ -94,13 +253,13 @@ private:
   struct ListNode final {
     ListNode* prev_;
     ListNode* next_;
-    TKey key_;
+    HashedKey key_;
 
     constexpr ListNode() : prev_(NullNodePtr), next_(nullptr) {}
 
     // explicit to avoid unintended conversions with UDT.
     // https://isocpp.github.io/CppCoreGuidelines/CppCoreGuidelines#Rc-explicit
-    explicit constexpr ListNode(const TKey& key) : prev_(NullNodePtr), next_(nullptr), key_(key) {}
+    explicit constexpr ListNode(const HashedKey& key) : prev_(NullNodePtr), next_(nullptr), key_(key) {}
 
     // false if node is not in cache's double-linked list.
     constexpr bool inList() const { return prev_ != NullNodePtr; }
@@ -111,13 +270,37 @@ private:
    * listNode_ as back-reference to node to the double-linked list,
    * which contains hash-table key.
    *
+   * value_ is overwritten in place by update() and read by load() under seq_,
+   * see OptimisticRead. Copies are made while no update() runs, seq_ is not
+   * copied.
+   *
    */
   struct Value final {
     std::shared_ptr<ListNode> listNode_;
-    TValue value_;
+    mutable TValue value_;
+    // odd while store() overwrites value_.
+    mutable std::atomic<uint32_t> seq_;
+
+    Value() : listNode_(), value_(), seq_(0) {}
+    Value(const TValue& value, std::shared_ptr<ListNode> node) : listNode_(node), value_(value), seq_(0) {}
+    Value(const Value& other) : listNode_(other.listNode_), value_(other.value_), seq_(0) {}
+
+    Value& operator=(const Value& other) {
+      listNode_ = other.listNode_;
+      value_ = other.value_;
+      return *this;
+    }
 
-    Value() = default;
-    Value(const TValue& value, std::shared_ptr<ListNode> node) : listNode_(node), value_(value) {}
+    /**
+     * load copies value_ into out, retried while store() runs.
+     * Writes no shared memory.
+     */
+    void load(TValue& out) const;
+
+    /**
+     * store overwrites value_, concurrent store() calls are serialized by seq_.
+     */
+    void store(const TValue& value) const;
   };
 
 private:
@@ -135,7 +318,7 @@ private:
   ListNode tail_;
 
   /**
-   * oneTBB concurrent_hash_map
+   * hash-map backend
    *
    */
   HashMap hashMap_;
@@ -176,9 +359,8 @@ private:
 
 public:
   /**
-   * ConstAccessor is a helper type wraped over
-   * tbb::concurrent_hash_map::const_accessor with operator overloaded to
-   * retrieve value stored in the hash-table based on key.
+   * ConstAccessor is a helper type with operator overloaded to retrieve the
+   * value copied from the hash-table based on key.
    *
    */
   struct ConstAccessor final {
@@ -189,33 +371,38 @@ public:
 
     constexpr const TValue* operator->() const { return get(); }
 
-    constexpr bool empty() const { return constAccessor_.empty(); }
+    // no hash-map lock is held after find returns.
+    constexpr bool empty() const { return true; }
 
     constexpr const TValue* get() const { return &value_; }
 
-    constexpr void release() { constAccessor_.release(); }
-
-  private:
-    /**
-     * copy TValue from concurrent_hash_map thus caller could release read lock
-     * early.
-     *
-     */
-    void setValue() { value_ = constAccessor_->second.value_; }
+    constexpr void release() {}
 
   private:
-    friend class LRUCache;  // for LRUCache member function to access
-                            // tbb::concurrent_hash_map::const_accessor
-    HashMapConstAccessor constAccessor_;
+    friend class LRUCache;  // for LRUCache member function to set value_
     TValue value_;
   };
 
+private:
+  /**
+   * findKey / visitKey implement find / visit for HashedKey and HashedLookup,
+   * optimistically if OptimisticRead.
+   *
+   */
+  template <typename TProbe>
+  bool findKey(ConstAccessor& ac, const TProbe& key);
+
+  template <typename TProbe, typename TFn>
+  bool visitKey(const TProbe& key, TFn&& fn);
+
+public:
   /**
    * size: initial size for the cache.
    * The size should be tunable at run-time TODO(shchang)
    *
-   * bucketCount: used for initial setup the tbb:concurrent_hash_map, the bucket
-   * size will grow depends on internal oneTBB algorithm.
+   * bucketCount: used for initial setup the TBB backends' hash map, the bucket
+   * size will grow depends on internal oneTBB algorithm. OpenAddressingMap is
+   * sized from size instead.
    */
   explicit LRUCache(int size, size_t bucketCount = std::thread::hardware_concurrency() * 8);
 
@@ -229,7 +416,20 @@ public:
    * returns number of elements removed (0 or 1).
    *
    */
-  size_t erase(const TKey& key);
+  size_t erase(const TKey& key) { return erase(HashedKey{key}); }
+  size_t erase(const HashedKey& key);
+
+  /**
+   * eraseRange removes every key inside range along with its value.
+   * returns number of elements removed.
+   *
+   * TMap has to index its keys in order and provide
+   * keysIn(const TRange&, std::vector<TKey>&), e.g. OrderedIpMap with a Cidr
+   * range. Thread-safe, keys inserted inside range meanwhile may stay.
+   *
+   */
+  template <typename TRange>
+  size_t eraseRange(const TRange& range);
 
   /**
    * find finds data inside hash-table through provided key.
@@ -239,7 +439,64 @@ public:
    * find updates key access frequency.
    *
    */
-  bool find(ConstAccessor& ac, const TKey& key);
+  bool find(ConstAccessor& ac, const TKey& key) { return find(ac, HashedKey{key}); }
+  bool find(ConstAccessor& ac, const HashedKey& key) { return findKey(ac, key); }
+
+  /**
+   * Heterogeneous find takes another form of the key THash hashes and compares
+   * directly (see HashedLookup), no TKey is constructed.
+   *
+   */
+  template <typename TLookup, typename = EnableLookup<TLookup>>
+  bool find(ConstAccessor& ac, const TLookup& key) {
+    return find(ac, hashLookup<THash>(key));
+  }
+  template <typename TLookup>
+  bool find(ConstAccessor& ac, const HashedLookup<TLookup>& key) {
+    return findKey(ac, key);
+  }
+
+  /**
+   * Text find parses the text once into THash::TextKey and finds its lookup
+   * form (see IsTextLookup), text which is not a key is never found.
+   *
+   */
+  template <typename TText, EnableText<TText> = 0>
+  bool find(ConstAccessor& ac, const TText& text) {
+    const typename THash::TextKey parsed{std::string_view{text}};
+    return parsed && find(ac, hashLookup<THash>(parsed.lookup()));
+  }
+
+  /**
+   * visit calls fn(const TValue&) on the value stored in the hash-table while
+   * the backend keeps it alive, nothing is copied. If OptimisticRead fn gets a
+   * validated copy instead, see update().
+   * Return true if key exist, otherwise false.
+   *
+   * fn must not access the cache. visit updates key access frequency.
+   *
+   */
+  template <typename TFn>
+  bool visit(const TKey& key, TFn&& fn) {
+    return visit(HashedKey{key}, std::forward<TFn>(fn));
+  }
+  template <typename TFn>
+  bool visit(const HashedKey& key, TFn&& fn) {
+    return visitKey(key, std::forward<TFn>(fn));
+  }
+  template <typename TLookup, typename TFn, typename = EnableLookup<TLookup>>
+  bool visit(const TLookup& key, TFn&& fn) {
+    return visit(hashLookup<THash>(key), std::forward<TFn>(fn));
+  }
+  template <typename TLookup, typename TFn>
+  bool visit(const HashedLookup<TLookup>& key, TFn&& fn) {
+    return visitKey(key, std::forward<TFn>(fn));
+  }
+  template <typename TText, typename TFn, EnableText<TText> = 0>
+  bool visit(const TText& text, TFn&& fn) {
+    const typename THash::TextKey parsed{std::string_view{text}};
+    return parsed && visit(hashLookup<THash>(parsed.lookup()), std::forward<TFn>(fn));
+  }
 
   /**
    * insert key/value into cache. Both key and value is copied into the cache.
@@ -249,7 +506,19 @@ public:
    * return false. Otherwise return true.
    *
    */
-  bool insert(const TKey& key, const TValue& value);
+  bool insert(const TKey& key, const TValue& value) { return insert(HashedKey{key}, value); }
+  bool insert(const HashedKey& key, const TValue& value);
+
+  /**
+   * update overwrites the value of an existing key in place, concurrent
+   * find() and visit() of the key retry meanwhile (see OptimisticRead).
+   * update doesn't change key access frequency.
+   *
+   * Return false if key doesn't exist. Requires OptimisticRead.
+   *
+   */
+  bool update(const TKey& key, const TValue& value) { return update(HashedKey{key}, value); }
+  bool update(const HashedKey& key, const TValue& value);
 
   /**
    * clear erases all elements from the container.
@@ -272,13 +541,51 @@ public:
   constexpr int capacity() const { return capacity_; }
 };
 
-template <class TKey, class TValue, class THash>
-typename LRUCache<TKey, TValue, THash>::ListNode* const LRUCache<TKey, TValue, THash>::NullNodePtr =
+template <class TKey, class TValue, class THash, template <class, class, class> class TMap>
+typename LRUCache<TKey, TValue, THash, TMap>::ListNode* const LRUCache<TKey, TValue, THash, TMap>::NullNodePtr =
     reinterpret_cast<ListNode*>(-1);
 
 // ---- private member functions ----
-template <class TKey, class TValue, class THash>
-void LRUCache<TKey, TValue, THash>::unlink(ListNode* node) {
+template <class TKey, class TValue, class THash, template <class, class, class> class TMap>
+void LRUCache<TKey, TValue, THash, TMap>::Value::load(TValue& out) const {
+  while (true) {
+    const uint32_t seq = seq_.load(std::memory_order_acquire);
+    if ((seq & 1) == 0) {
+      // seqlock read, the copy is discarded if store() ran meanwhile.
+#if defined(__SANITIZE_THREAD__)
+      AnnotateIgnoreReadsBegin(__FILE__, __LINE__);
+#endif
+      std::memcpy(static_cast<void*>(&out), static_cast<const void*>(&value_), sizeof(TValue));
+#if defined(__SANITIZE_THREAD__)
+      AnnotateIgnoreReadsEnd(__FILE__, __LINE__);
+#endif
+
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (seq_.load(std::memory_order_relaxed) == seq) {
+        return;
+      }
+    }
+    std::this_thread::yield();
+  }
+}
+
+template <class TKey, class TValue, class THash, template <class, class, class> class TMap>
+void LRUCache<TKey, TValue, THash, TMap>::Value::store(const TValue& value) const {
+  uint32_t seq = seq_.load(std::memory_order_relaxed);
+  while ((seq & 1) != 0 || !seq_.compare_exchange_weak(seq, seq + 1, std::memory_order_acquire)) {
+    if ((seq & 1) != 0) {
+      std::this_thread::yield();
+      seq = seq_.load(std::memory_order_relaxed);
+    }
+  }
+
+  std::atomic_thread_fence(std::memory_order_release);
+  std::memcpy(static_cast<void*>(&value_), static_cast<const void*>(&value), sizeof(TValue));
+  seq_.store(seq + 2, std::memory_order_release);
+}
+
+template <class TKey, class TValue, class THash, template <class, class, class> class TMap>
+void LRUCache<TKey, TValue, THash, TMap>::unlink(ListNode* node) {
   ListNode* prev = node->prev_;
   ListNode* next = node->next_;
   prev->next_ = next;
@@ -289,8 +596,8 @@ void LRUCache<TKey, TValue, THash>::unlink(ListNode* node) {
   node->prev_ = NullNodePtr;
 }
 
-template <class TKey, class TValue, class THash>
-void LRUCache<TKey, TValue, THash>::append(ListNode* node) {
+template <class TKey, class TValue, class THash, template <class, class, class> class TMap>
+void LRUCache<TKey, TValue, THash, TMap>::append(ListNode* node) {
   ListNode* prevLatestNode = tail_.prev_;
 
   node->next_ = &tail_;
@@ -300,64 +607,55 @@ void LRUCache<TKey, TValue, THash>::append(ListNode* node) {
   prevLatestNode->next_ = node;
 }
 
-template <class TKey, class TValue, class THash>
-void LRUCache<TKey, TValue, THash>::popFront() {
-  ListNode* candidate{nullptr};
+template <class TKey, class TValue, class THash, template <class, class, class> class TMap>
+void LRUCache<TKey, TValue, THash, TMap>::popFront() {
+  HashedKey key;
 
   {
     std::unique_lock<ListMutex> lock(listMutex_);
-    candidate = head_.next_;
+    ListNode* candidate = head_.next_;
 
     if (candidate == &tail_) {
       return;
     }
 
     unlink(candidate);
-  }
-
-  HashMapConstAccessor accessor;
-  if (!hashMap_.find(accessor, candidate->key_)) {
-    return;
+    // the node is owned by the hash-map value, copy the key before it's erased.
+    key = candidate->key_;
   }
 
   // erase issues lock, do not call this API inside linked-list lock.
   // https://github.com/jckarter/tbb/blob/0343100743d23f707a9001bc331988a31778c9f4/include/tbb/concurrent_hash_map.h#L1093
-  hashMap_.erase(accessor);
+  hashMap_.erase(key);
 }
 
 // ---- private member functions end ----
 
-template <class TKey, class TValue, class THash>
-LRUCache<TKey, TValue, THash>::LRUCache(int size, size_t bucketCount)
-    : hashMap_(bucketCount), currentSize_(0), capacity_(size) {
+template <class TKey, class TValue, class THash, template <class, class, class> class TMap>
+LRUCache<TKey, TValue, THash, TMap>::LRUCache(int size, size_t bucketCount)
+    : hashMap_(static_cast<size_t>(std::max(size, 0)), bucketCount), currentSize_(0), capacity_(size) {
   head_.prev_ = nullptr;
   head_.next_ = &tail_;
   tail_.prev_ = &head_;
 }
 
-template <class TKey, class TValue, class THash>
-size_t LRUCache<TKey, TValue, THash>::erase(const TKey& key) {
+template <class TKey, class TValue, class THash, template <class, class, class> class TMap>
+size_t LRUCache<TKey, TValue, THash, TMap>::erase(const HashedKey& key) {
   std::shared_ptr<ListNode> found_node;
   bool marked = false;
 
   // fine-grained read lock for hash_map
-  {
-    HashMapConstAccessor accessor;
-    if (!hashMap_.find(accessor, key)) {
-      return 0;
-    } else {
-      found_node = accessor->second.listNode_;
-    }
+  if (!hashMap_.visit(key, [&found_node](const Value& value) { found_node = value.listNode_; })) {
+    return 0;
   }
 
   {
+    // list membership is only read under the list lock, unlink() writes it.
+    std::unique_lock<ListMutex> lock(listMutex_);
     if (found_node->inList()) {
-      std::unique_lock<ListMutex> lock(listMutex_);
-      if (found_node->inList()) {
-        unlink(found_node.get());
-        currentSize_--;
-        marked = true;
-      }
+      unlink(found_node.get());
+      currentSize_--;
+      marked = true;
     }
   }
 
@@ -370,23 +668,39 @@ size_t LRUCache<TKey, TValue, THash>::erase(const TKey& key) {
   return 1;
 }
 
-template <class TKey, class TValue, class THash>
-bool LRUCache<TKey, TValue, THash>::find(ConstAccessor& caccessor, const TKey& key) {
+template <class TKey, class TValue, class THash, template <class, class, class> class TMap>
+template <typename TRange>
+size_t LRUCache<TKey, TValue, THash, TMap>::eraseRange(const TRange& range) {
+  // the backend's index lock is released before erase takes the list lock.
+  std::vector<TKey> keys;
+  hashMap_.keysIn(range, keys);
+
+  size_t erased = 0;
+  for (const TKey& key : keys) {
+    erased += erase(key);
+  }
+  return erased;
+}
+
+template <class TKey, class TValue, class THash, template <class, class, class> class TMap>
+template <typename TProbe>
+bool LRUCache<TKey, TValue, THash, TMap>::findKey(ConstAccessor& caccessor, const TProbe& key) {
+  if constexpr (OptimisticRead) {
+    // no lock to release, the backend keeps the node alive during visit.
+    return visitKey(key, [&caccessor](const TValue& value) { caccessor.value_ = value; });
+  }
+
   std::shared_ptr<ListNode> found_node;
 
-  {
-    // fine-grained read lock on hash_map
-    if (!hashMap_.find(caccessor.constAccessor_, key)) {
-      caccessor.constAccessor_.release();  // manual release, reference object can't count on RAII
-      return false;
-    } else {
-      // copy value from hash_map
-      caccessor.setValue();
-      // shared owner-ship for listNode. ref cnt increased, decrease when
-      // found_node out of the scope.
-      found_node = caccessor.constAccessor_->second.listNode_;
-      caccessor.constAccessor_.release();  // manual release, reference object can't count on RAII
-    }
+  // fine-grained read protection on hash_map, released once the value is copied.
+  if (!hashMap_.visit(key, [&caccessor, &found_node](const Value& value) {
+        // copy value from hash_map
+        caccessor.value_ = value.value_;
+        // shared owner-ship for listNode. ref cnt increased, decrease when
+        // found_node out of the scope.
+        found_node = value.listNode_;
+      })) {
+    return false;
   }
 
   {
@@ -406,18 +720,38 @@ bool LRUCache<TKey, TValue, THash>::find(ConstAccessor& caccessor, const TKey& k
   return true;
 }
 
-template <class TKey, class TValue, class THash>
-bool LRUCache<TKey, TValue, THash>::insert(const TKey& key, const TValue& value) {
-  std::shared_ptr<ListNode> node = std::make_shared<ListNode>(key);
-  HashMapValuePair hashMapValue{key, Value{value, node}};
+template <class TKey, class TValue, class THash, template <class, class, class> class TMap>
+template <typename TProbe, typename TFn>
+bool LRUCache<TKey, TValue, THash, TMap>::visitKey(const TProbe& key, TFn&& fn) {
+  // fine-grained read protection on hash_map, node stays alive while it's held.
+  return hashMap_.visit(key, [this, &fn](const Value& value) {
+    if constexpr (OptimisticRead) {
+      TValue copy;
+      value.load(copy);
+      fn(static_cast<const TValue&>(copy));
+    } else {
+      fn(value.value_);
+    }
 
-  {
-    // fine-grained write lock for hash_map, prevents other lock acquires
-    // hash_map
-    HashMapAccessor accessor;
-    if (!hashMap_.insert(accessor, hashMapValue)) {
-      return false;
+    // try lock never blocks while holding the read protection.
+    // If lock can't be obtained, skip updating the LRU linked list.
+    ListNode* node = value.listNode_.get();
+    std::unique_lock<ListMutex> lock{listMutex_, std::try_to_lock};
+    if (lock && node->inList()) {
+      unlink(node);
+      append(node);
     }
+  });
+}
+
+template <class TKey, class TValue, class THash, template <class, class, class> class TMap>
+bool LRUCache<TKey, TValue, THash, TMap>::insert(const HashedKey& key, const TValue& value) {
+  std::shared_ptr<ListNode> node = std::make_shared<ListNode>(key);
+
+  // fine-grained write lock for hash_map, prevents other lock acquires
+  // hash_map
+  if (!hashMap_.insert(key, Value{value, node})) {
+    return false;
   }
 
   int size = currentSize_.load();
@@ -446,8 +780,16 @@ bool LRUCache<TKey, TValue, THash>::insert(const TKey& key, const TValue& value)
   return true;
 }
 
-template <class TKey, class TValue, class THash>
-void LRUCache<TKey, TValue, THash>::clear() noexcept {
+template <class TKey, class TValue, class THash, template <class, class, class> class TMap>
+bool LRUCache<TKey, TValue, THash, TMap>::update(const HashedKey& key, const TValue& value) {
+  static_assert(OptimisticRead, "update requires OptimisticRead, see LRUCache");
+
+  // the backend keeps the entry alive, readers validate against its sequence.
+  return hashMap_.visit(key, [&value](const Value& entry) { entry.store(value); });
+}
+
+template <class TKey, class TValue, class THash, template <class, class, class> class TMap>
+void LRUCache<TKey, TValue, THash, TMap>::clear() noexcept {
   hashMap_.clear();
 
   head_.next_ = &tail_;
@@ -0,0 +1,640 @@
+/**
+ * @author shchang
+ *
+ */
+
+#pragma once
+#include <lru_cache/distributed_shared_mutex.h>
+#include <lru_cache/spin_shared_mutex.h>
+#include <lru_cache/swiss_table.h>
+
+#include <tbb/concurrent_hash_map.h>
+#include <tbb/concurrent_unordered_map.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace vsdmars {
+
+/**
+ * Hash-map backends of LRUCache, selected through LRUCache's TMap template
+ * parameter.
+ *
+ * A backend is a class template Map<TKey, TValue, THashCompare> providing:
+ *  Map(size_t capacity, size_t bucketCount)
+ *  template <typename TFn> bool visit(const TKey& key, TFn&& fn)
+ *    calls fn(const TValue&) while the value can't be reclaimed,
+ *    returns false if key doesn't exist. fn must not access the map.
+ *    visit also takes the HashedLookup of a heterogeneous lookup (see
+ *    lrucache.h), which THashCompare hashes and compares against TKey.
+ *    TBB containers without heterogeneous find (pre-oneTBB) build TKey with
+ *    THashCompare::key.
+ *  bool insert(const TKey& key, const TValue& value)
+ *    returns false if key already exists.
+ *  bool erase(const TKey& key)
+ *    returns false if key doesn't exist.
+ *  void clear() noexcept
+ *    not thread-safe.
+ * and optionally:
+ *  constexpr static bool LockFreeLookup
+ *    true if visit() writes no memory shared with other threads (e.g. a bucket
+ *    lock), LRUCache then reads small values optimistically, see
+ *    LRUCache::OptimisticRead.
+ *
+ * THashCompare type requires TBB::HashCompare concept.
+ *
+ */
+
+/**
+ * HasLockFreeLookup tells whether TMap declares LockFreeLookup true.
+ */
+template <typename TMap, typename = void>
+struct HasLockFreeLookup : std::false_type {};
+
+template <typename TMap>
+struct HasLockFreeLookup<TMap, std::void_t<decltype(TMap::LockFreeLookup)>>
+    : std::bool_constant<TMap::LockFreeLookup> {};
+
+/**
+ * TbbHashMap adapts tbb::concurrent_hash_map.
+ *
+ * visit() holds the bucket's reader lock, thus every lookup writes to the
+ * bucket lock's cache line.
+ *
+ */
+template <typename TKey, typename TValue, typename THashCompare>
+class TbbHashMap final {
+private:
+  using HashMap = tbb::concurrent_hash_map<TKey, TValue, THashCompare>;
+
+  HashMap map_;
+
+private:
+  // FindsProbe tells whether concurrent_hash_map finds TProbe, oneTBB finds a HashedLookup by the transparent THashCompare.
+  template <typename TProbe, typename = void>
+  struct FindsProbe : std::false_type {};
+
+  template <typename TProbe>
+  struct FindsProbe<TProbe, std::void_t<decltype(std::declval<HashMap&>().find(
+                                std::declval<typename HashMap::const_accessor&>(), std::declval<const TProbe&>()))>>
+      : std::true_type {};
+
+public:
+  TbbHashMap(size_t /* capacity */, size_t bucketCount) : map_(bucketCount) {}
+
+  TbbHashMap(const TbbHashMap&) = delete;
+  TbbHashMap& operator=(const TbbHashMap&) = delete;
+
+  // TProbe is TKey or a HashedLookup, built into TKey if concurrent_hash_map can't find it.
+  template <typename TProbe, typename TFn>
+  bool visit(const TProbe& key, TFn&& fn) {
+    typename HashMap::const_accessor accessor;
+    bool found;
+    if constexpr (FindsProbe<TProbe>::value) {
+      found = map_.find(accessor, key);
+    } else {
+      found = map_.find(accessor, THashCompare{}.key(key));
+    }
+    if (!found) {
+      return false;
+    }
+
+    fn(accessor->second);
+    return true;
+  }
+
+  bool insert(const TKey& key, const TValue& value) { return map_.insert(typename HashMap::value_type{key, value}); }
+
+  bool erase(const TKey& key) { return map_.erase(key); }
+
+  void clear() noexcept { map_.clear(); }
+};
+
+/**
+ * RetireList holds nodes unlinked from a map until no reader can reach them.
+ *
+ * The owning map reclaims the nodes while holding its DistributedSharedMutex
+ * exclusively, readers access nodes only under the shared lock.
+ *
+ */
+template <typename TNode>
+class RetireList final {
+private:
+  std::mutex mutex_;
+  std::vector<TNode*> nodes_;
+  std::atomic<size_t> size_{0};
+
+public:
+  RetireList() : mutex_(), nodes_() {}
+  ~RetireList() noexcept { reclaim(); }
+
+  RetireList(const RetireList&) = delete;
+  RetireList& operator=(const RetireList&) = delete;
+
+  void retire(TNode* node) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    nodes_.push_back(node);
+    size_.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  size_t size() const { return size_.load(std::memory_order_relaxed); }
+
+  /**
+   * reclaim deletes all retired nodes.
+   * Caller guarantees no reader can reach them.
+   */
+  void reclaim() noexcept {
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (TNode* node : nodes_) {
+      delete node;
+    }
+    nodes_.clear();
+    size_.store(0, std::memory_order_relaxed);
+  }
+};
+
+/**
+ * TbbUnorderedMap adapts tbb::concurrent_unordered_map, whose lookup takes no
+ * lock.
+ *
+ * concurrent_unordered_map only supports concurrent insert and lookup, thus
+ * erase() detaches the value from its key and retires it, the key stays as
+ * tombstone and is reused by the next insert of the same key. Once retired
+ * values exceed the capacity, tombstones are erased and retired values are
+ * reclaimed under the exclusive lock of DistributedSharedMutex, every other
+ * operation holds its shared lock.
+ *
+ */
+template <typename TKey, typename TValue, typename THashCompare>
+class TbbUnorderedMap final {
+private:
+  // transparent, THashCompare hashes and compares HashedLookup too.
+  struct KeyEqual final {
+    using is_transparent = void;
+
+    template <typename TProbe>
+    bool operator()(const TKey& k1, const TProbe& k2) const {
+      return THashCompare{}.equal(k1, k2);
+    }
+  };
+
+  struct Hasher final {
+    using transparent_key_equal = KeyEqual;
+
+    template <typename TProbe>
+    size_t operator()(const TProbe& key) const {
+      return THashCompare{}.hash(key);
+    }
+  };
+
+  // nullptr if the key is erased.
+  using Slot = std::atomic<TValue*>;
+  using HashMap = tbb::concurrent_unordered_map<TKey, Slot, Hasher, KeyEqual>;
+
+  HashMap map_;
+  DistributedSharedMutex mutex_;
+  RetireList<TValue> retired_;
+  const size_t purgeThreshold_;
+
+private:
+  // FindsProbe tells whether concurrent_unordered_map finds TProbe, oneTBB finds a HashedLookup by the transparent KeyEqual.
+  template <typename TProbe, typename = void>
+  struct FindsProbe : std::false_type {};
+
+  template <typename TProbe>
+  struct FindsProbe<TProbe, std::void_t<decltype(std::declval<HashMap&>().find(std::declval<const TProbe&>()))>>
+      : std::true_type {};
+
+  /**
+   * purge erases tombstones and reclaims retired values.
+   */
+  void purge();
+
+public:
+  constexpr static bool LockFreeLookup = true;
+
+  TbbUnorderedMap(size_t capacity, size_t bucketCount)
+      : map_(bucketCount), mutex_(), retired_(), purgeThreshold_(std::max<size_t>(capacity, 64)) {}
+
+  ~TbbUnorderedMap() noexcept { clear(); }
+
+  TbbUnorderedMap(const TbbUnorderedMap&) = delete;
+  TbbUnorderedMap& operator=(const TbbUnorderedMap&) = delete;
+
+  // TProbe is TKey or a HashedLookup.
+  template <typename TProbe, typename TFn>
+  bool visit(const TProbe& key, TFn&& fn);
+
+  bool insert(const TKey& key, const TValue& value);
+
+  bool erase(const TKey& key);
+
+  void clear() noexcept;
+};
+
+template <typename TKey, typename TValue, typename THashCompare>
+void TbbUnorderedMap<TKey, TValue, THashCompare>::purge() {
+  std::unique_lock<DistributedSharedMutex> lock(mutex_);
+
+  // purged by another thread.
+  if (retired_.size() <= purgeThreshold_) {
+    return;
+  }
+
+  for (auto it = map_.begin(); it != map_.end();) {
+    if (it->second.load(std::memory_order_relaxed) == nullptr) {
+      it = map_.unsafe_erase(it);
+    } else {
+      ++it;
+    }
+  }
+
+  retired_.reclaim();
+}
+
+template <typename TKey, typename TValue, typename THashCompare>
+template <typename TProbe, typename TFn>
+bool TbbUnorderedMap<TKey, TValue, THashCompare>::visit(const TProbe& key, TFn&& fn) {
+  std::shared_lock<DistributedSharedMutex> lock(mutex_);
+
+  typename HashMap::iterator it;
+  if constexpr (FindsProbe<TProbe>::value) {
+    it = map_.find(key);
+  } else {
+    it = map_.find(THashCompare{}.key(key));
+  }
+  if (it == map_.end()) {
+    return false;
+  }
+
+  TValue* value = it->second.load(std::memory_order_acquire);
+  if (value == nullptr) {
+    return false;
+  }
+
+  fn(*value);
+  return true;
+}
+
+template <typename TKey, typename TValue, typename THashCompare>
+bool TbbUnorderedMap<TKey, TValue, THashCompare>::insert(const TKey& key, const TValue& value) {
+  auto node = std::make_unique<TValue>(value);
+  std::shared_lock<DistributedSharedMutex> lock(mutex_);
+
+  auto it = map_.find(key);
+  if (it == map_.end()) {
+    it = map_.emplace(std::piecewise_construct, std::forward_as_tuple(key), std::forward_as_tuple(nullptr)).first;
+  }
+
+  // tombstone or newly emplaced key, a concurrent insert of the same key wins the race.
+  TValue* expected = nullptr;
+  if (!it->second.compare_exchange_strong(expected, node.get(), std::memory_order_acq_rel)) {
+    return false;
+  }
+
+  node.release();
+  return true;
+}
+
+template <typename TKey, typename TValue, typename THashCompare>
+bool TbbUnorderedMap<TKey, TValue, THashCompare>::erase(const TKey& key) {
+  {
+    std::shared_lock<DistributedSharedMutex> lock(mutex_);
+
+    auto it = map_.find(key);
+    if (it == map_.end()) {
+      return false;
+    }
+
+    TValue* value = it->second.exchange(nullptr, std::memory_order_acq_rel);
+    if (value == nullptr) {
+      return false;
+    }
+
+    retired_.retire(value);
+  }
+
+  if (retired_.size() > purgeThreshold_) {
+    purge();
+  }
+
+  return true;
+}
+
+template <typename TKey, typename TValue, typename THashCompare>
+void TbbUnorderedMap<TKey, TValue, THashCompare>::clear() noexcept {
+  for (auto& entry : map_) {
+    delete entry.second.load(std::memory_order_relaxed);
+  }
+
+  map_.clear();
+  retired_.reclaim();
+}
+
+/**
+ * OpenAddressingMap is a fixed-size linear probing table of node pointers.
+ *
+ * The table holds 4 buckets per entry of capacity (at least 16), sized once at
+ * construction. visit() is lock-free besides the shared lock of
+ * DistributedSharedMutex, which only writes to the calling thread's reader
+ * slot.
+ *
+ * insert() claims the first empty bucket of the probe sequence with CAS, a
+ * concurrent insert of the same key loses the CAS and finds the key. erase()
+ * replaces the node with a tombstone and retires the node. Once half of the
+ * buckets are used, the table is rebuilt without tombstones and retired nodes
+ * are reclaimed under the exclusive lock.
+ *
+ * insert() returns false if the table is full of live entries even after a
+ * purge, which only happens when the owner holds far more entries than its
+ * capacity.
+ *
+ */
+template <typename TKey, typename TValue, typename THashCompare>
+class OpenAddressingMap final {
+private:
+  struct Node final {
+    TKey key_;
+    TValue value_;
+  };
+
+  using Bucket = std::atomic<Node*>;
+
+  std::vector<Bucket> buckets_;
+  const size_t mask_;
+  const int shift_;
+  // buckets not empty, live or tombstone.
+  std::atomic<size_t> used_{0};
+  const size_t maxUsed_;
+  DistributedSharedMutex mutex_;
+  RetireList<Node> retired_;
+
+private:
+  static Node* tombstone() { return reinterpret_cast<Node*>(alignof(Node)); }
+
+  static size_t bucketCount(size_t capacity) {
+    size_t count = 16;
+    while (count < capacity * 4) {
+      count <<= 1;
+    }
+    return count;
+  }
+
+  // Fibonacci hashing, the higher bits of the product select the home bucket.
+  template <typename TProbe>
+  size_t home(const TProbe& key) const {
+    return static_cast<size_t>((static_cast<uint64_t>(THashCompare{}.hash(key)) * 0x9E3779B97F4A7C15ULL) >> shift_);
+  }
+
+  /**
+   * purge rebuilds the table without tombstones and reclaims retired nodes.
+   * Returns false if the live entries leave no bucket to reserve.
+   */
+  bool purge();
+
+public:
+  constexpr static bool LockFreeLookup = true;
+
+  OpenAddressingMap(size_t capacity, size_t /* bucketCount */);
+
+  ~OpenAddressingMap() noexcept { clear(); }
+
+  OpenAddressingMap(const OpenAddressingMap&) = delete;
+  OpenAddressingMap& operator=(const OpenAddressingMap&) = delete;
+
+  // TProbe is TKey or a HashedLookup.
+  template <typename TProbe, typename TFn>
+  bool visit(const TProbe& key, TFn&& fn);
+
+  bool insert(const TKey& key, const TValue& value);
+
+  bool erase(const TKey& key);
+
+  void clear() noexcept;
+};
+
+template <typename TKey, typename TValue, typename THashCompare>
+OpenAddressingMap<TKey, TValue, THashCompare>::OpenAddressingMap(size_t capacity, size_t)
+    : buckets_(bucketCount(capacity)),
+      mask_(buckets_.size() - 1),
+      shift_(64 - __builtin_ctzll(buckets_.size())),
+      maxUsed_(buckets_.size() / 2),
+      mutex_(),
+      retired_() {}
+
+template <typename TKey, typename TValue, typename THashCompare>
+bool OpenAddressingMap<TKey, TValue, THashCompare>::purge() {
+  std::unique_lock<DistributedSharedMutex> lock(mutex_);
+
+  // purged by another thread.
+  if (used_.load(std::memory_order_relaxed) < maxUsed_) {
+    return true;
+  }
+
+  std::vector<Node*> live;
+  for (auto& bucket : buckets_) {
+    Node* node = bucket.load(std::memory_order_relaxed);
+    if (node != nullptr && node != tombstone()) {
+      live.push_back(node);
+    }
+    bucket.store(nullptr, std::memory_order_relaxed);
+  }
+
+  for (Node* node : live) {
+    size_t i = home(node->key_);
+    while (buckets_[i].load(std::memory_order_relaxed) != nullptr) {
+      i = (i + 1) & mask_;
+    }
+    buckets_[i].store(node, std::memory_order_relaxed);
+  }
+
+  used_.store(live.size(), std::memory_order_relaxed);
+  retired_.reclaim();
+  return live.size() < maxUsed_;
+}
+
+template <typename TKey, typename TValue, typename THashCompare>
+template <typename TProbe, typename TFn>
+bool OpenAddressingMap<TKey, TValue, THashCompare>::visit(const TProbe& key, TFn&& fn) {
+  std::shared_lock<DistributedSharedMutex> lock(mutex_);
+
+  // at most half of the buckets are used, an empty bucket terminates the probe.
+  for (size_t i = home(key);; i = (i + 1) & mask_) {
+    Node* node = buckets_[i].load(std::memory_order_acquire);
+    if (node == nullptr) {
+      return false;
+    }
+
+    if (node != tombstone() && THashCompare{}.equal(node->key_, key)) {
+      fn(node->value_);
+      return true;
+    }
+  }
+}
+
+template <typename TKey, typename TValue, typename THashCompare>
+bool OpenAddressingMap<TKey, TValue, THashCompare>::insert(const TKey& key, const TValue& value) {
+  auto node = std::make_unique<Node>(Node{key, value});
+
+  // concurrent inserts may use up the reservations between the check and the
+  // reservation, a failed reservation purges and retries.
+  while (used_.load(std::memory_order_relaxed) < maxUsed_ || purge()) {
+    std::shared_lock<DistributedSharedMutex> lock(mutex_);
+    bool reserved = true;
+
+    // empty buckets only turn into nodes and nodes into tombstones, thus every
+    // insert of the same key races for the same first empty bucket.
+    for (size_t i = home(key); reserved; i = (i + 1) & mask_) {
+      Node* cur = buckets_[i].load(std::memory_order_acquire);
+
+      while (cur == nullptr) {
+        // reserve the bucket first, probes must keep an empty bucket.
+        if (used_.fetch_add(1, std::memory_order_relaxed) >= maxUsed_) {
+          used_.fetch_sub(1, std::memory_order_relaxed);
+          reserved = false;
+          break;
+        }
+
+        if (buckets_[i].compare_exchange_strong(cur, node.get(), std::memory_order_acq_rel)) {
+          node.release();
+          return true;
+        }
+
+        // cur holds the node of a concurrent insert.
+        used_.fetch_sub(1, std::memory_order_relaxed);
+      }
+
+      if (reserved && cur != tombstone() && THashCompare{}.equal(cur->key_, key)) {
+        return false;
+      }
+    }
+  }
+
+  // the live entries alone use up the reservations.
+  return false;
+}
+
+template <typename TKey, typename TValue, typename THashCompare>
+bool OpenAddressingMap<TKey, TValue, THashCompare>::erase(const TKey& key) {
+  std::shared_lock<DistributedSharedMutex> lock(mutex_);
+
+  for (size_t i = home(key);; i = (i + 1) & mask_) {
+    Node* node = buckets_[i].load(std::memory_order_acquire);
+    if (node == nullptr) {
+      return false;
+    }
+
+    if (node != tombstone() && THashCompare{}.equal(node->key_, key)) {
+      // tombstones are never reused, CAS fails only if erased concurrently.
+      if (!buckets_[i].compare_exchange_strong(node, tombstone(), std::memory_order_acq_rel)) {
+        return false;
+      }
+
+      retired_.retire(node);
+      return true;
+    }
+  }
+}
+
+template <typename TKey, typename TValue, typename THashCompare>
+void OpenAddressingMap<TKey, TValue, THashCompare>::clear() noexcept {
+  for (auto& bucket : buckets_) {
+    Node* node = bucket.load(std::memory_order_relaxed);
+    if (node != nullptr && node != tombstone()) {
+      delete node;
+    }
+    bucket.store(nullptr, std::memory_order_relaxed);
+  }
+
+  used_.store(0, std::memory_order_relaxed);
+  retired_.reclaim();
+}
+
+/**
+ * SwissMap is a SwissTable of key/value pairs guarded by SpinSharedMutex.
+ *
+ * Keys and values are stored inline in the table slots, lookup compares the
+ * hash tag of 16 slots with one SIMD compare and touches one control line and
+ * one slot line in common case. visit() takes the shared side of the single
+ * word lock, insert() and erase() take it exclusively. ScalableLRUCache gives
+ * every shard its own SwissMap, spreading the lock over shards.
+ *
+ * The table is sized for capacity and doubles if the owner overshoots it.
+ *
+ */
+template <typename TKey, typename TValue, typename THashCompare>
+class SwissMap final {
+private:
+  using Slot = std::pair<TKey, TValue>;
+
+  SpinSharedMutex mutex_;
+  SwissTable<Slot> table_;
+
+private:
+  template <typename TProbe>
+  static uint64_t hash(const TProbe& key) {
+    return THashCompare{}.hash(key);
+  }
+
+  template <typename TProbe>
+  size_t find(const TProbe& key, uint64_t keyHash) const {
+    return table_.find(keyHash, [&key](const Slot& slot) { return THashCompare{}.equal(slot.first, key); });
+  }
+
+public:
+  SwissMap(size_t capacity, size_t /* bucketCount */) : mutex_(), table_(capacity) {}
+
+  SwissMap(const SwissMap&) = delete;
+  SwissMap& operator=(const SwissMap&) = delete;
+
+  // TProbe is TKey or a HashedLookup.
+  template <typename TProbe, typename TFn>
+  bool visit(const TProbe& key, TFn&& fn) {
+    const uint64_t keyHash = hash(key);
+    std::shared_lock<SpinSharedMutex> lock(mutex_);
+
+    size_t pos = find(key, keyHash);
+    if (pos == SwissTable<Slot>::NPOS) {
+      return false;
+    }
+
+    fn(table_.slot(pos).second);
+    return true;
+  }
+
+  bool insert(const TKey& key, const TValue& value) {
+    const uint64_t keyHash = hash(key);
+    std::unique_lock<SpinSharedMutex> lock(mutex_);
+
+    if (find(key, keyHash) != SwissTable<Slot>::NPOS) {
+      return false;
+    }
+
+    table_.insert(keyHash, Slot{key, value}, [](const Slot& slot) { return hash(slot.first); });
+    return true;
+  }
+
+  bool erase(const TKey& key) {
+    const uint64_t keyHash = hash(key);
+    std::unique_lock<SpinSharedMutex> lock(mutex_);
+
+    size_t pos = find(key, keyHash);
+    if (pos == SwissTable<Slot>::NPOS) {
+      return false;
+    }
+
+    table_.erase(pos);
+    return true;
+  }
+
+  void clear() noexcept { table_.clear(); }
+};
+}  // namespace vsdmars
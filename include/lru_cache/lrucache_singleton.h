@@ -26,8 +26,17 @@
 
 #include <lru_cache/clock_lru_cache.h>
 #include <lru_cache/clock_lru_cache_hash.h>
+#include <lru_cache/cidr_index.h>
+#include <lru_cache/ip_family_map.h>
+#include <lru_cache/ip_hash.h>
+#include <lru_cache/ip_prefix_cache.h>
+#include <lru_cache/ip_range_index.h>
 #include <lru_cache/lrucache_tbb.h>
+#include <lru_cache/ordered_ip_map.h>
+#include <lru_cache/rate_limit_cache.h>
 #include <lru_cache/scale-lrucache.h>
+#include <lru_cache/scale_clock_cache.h>
+#include <lru_cache/snapshot-cache.h>
 
 namespace AtsPluginUtils {
 inline namespace lrucache_v1 {
@@ -69,6 +78,71 @@ struct CacheValue<CACHE_VALUE_TYPE::TIME_ENTITY_LOOKUP_INFO> {
  */
 using IPTimeEntityCache = LRUC::ScalableLRUCache<IpAddress, CacheValue<CACHE_VALUE_TYPE::TIME_ENTITY_LOOKUP_INFO>>;
 
+/**
+ * IPFamilyTimeEntityCache is IPTimeEntityCache routing on sa_family, see
+ * LRUC::IpFamilyMap: IPv4 entries are indexed by their 4 bytes address, IPv6
+ * entries by 16 bytes PackedIpKey, both families share each shard's capacity
+ * and LRU eviction.
+ *
+ */
+using IPFamilyTimeEntityCache = LRUC::ScalableLRUCache<IpAddress, CacheValue<CACHE_VALUE_TYPE::TIME_ENTITY_LOOKUP_INFO>,
+                                                       LRUC::IpFamilyHashCompare, LRUC::IpFamilyMap>;
+
+/**
+ * IPPrefixTimeEntityCache is IPTimeEntityCache aggregating IPv6 address
+ * rotation into /64 and /56 entries, see LRUC::IpPrefixCache.
+ *
+ */
+using IPPrefixTimeEntityCache = LRUC::IpPrefixCache<CacheValue<CACHE_VALUE_TYPE::TIME_ENTITY_LOOKUP_INFO>>;
+
+/**
+ * IPOrderedTimeEntityCache is IPTimeEntityCache indexing its keys in address
+ * order, eraseRange(LRUC::Cidr) drops every entry inside a block, see
+ * LRUC::OrderedIpMap.
+ *
+ */
+using IPOrderedTimeEntityCache =
+    LRUC::ScalableLRUCache<IpAddress, CacheValue<CACHE_VALUE_TYPE::TIME_ENTITY_LOOKUP_INFO>,
+                           tbb::tbb_hash_compare<IpAddress>, LRUC::OrderedIpMap>;
+
+/**
+ * IPCidrIndex is the longest prefix match index of a static CIDR blocklist,
+ * used alongside IPTimeEntityCache with the same value type:
+ *
+ * key: LRUC::Cidr
+ * value: AtsPluginUtils::CacheValue<CACHE_VALUE_TYPE::TIME_ENTITY_LOOKUP_INFO>
+ *
+ */
+using IPCidrIndex = LRUC::CidrIndex<CacheValue<CACHE_VALUE_TYPE::TIME_ENTITY_LOOKUP_INFO>>;
+
+/**
+ * IPRangeIndex is the index of a sorted IPv4 range feed, read through by
+ * IPTimeEntityCache with the same value type:
+ *
+ * key: [first, last] IPv4 range
+ * value: AtsPluginUtils::CacheValue<CACHE_VALUE_TYPE::TIME_ENTITY_LOOKUP_INFO>
+ *
+ */
+using IPRangeIndex = LRUC::IpRangeIndex<CacheValue<CACHE_VALUE_TYPE::TIME_ENTITY_LOOKUP_INFO>>;
+
+/**
+ * IPRateLimitCache counts the request rate of each IP address over a sliding
+ * window, the counting behind IPTimeEntityCache verdicts, see
+ * LRUC::RateLimitCache.
+ *
+ */
+using IPRateLimitCache = LRUC::RateLimitCache<IpAddress>;
+
+/**
+ * IPTimeEntitySnapshot is the read-mostly mode of IPTimeEntityCache for
+ * blocklists reloaded periodically, writer publishes the whole list at once:
+ *
+ * key: AtsPluginUtils::IpAddress
+ * value: AtsPluginUtils::CacheValue<CACHE_VALUE_TYPE::TIME_ENTITY_LOOKUP_INFO>
+ *
+ */
+using IPTimeEntitySnapshot = LRUC::SnapshotCache<IpAddress, CacheValue<CACHE_VALUE_TYPE::TIME_ENTITY_LOOKUP_INFO>>;
+
 }  // namespace lrucache_v1
 }  // namespace AtsPluginUtils
 
@@ -96,3 +170,11 @@ void init_ip_time_entity_cache(size_t capacity, size_t shardCnt);
  *
  */
 AtsPluginUtils::IPTimeEntityCache& get_ip_time_entity_cache();
+
+/**
+ * get_ip_time_entity_snapshot returns single instance of the read-mostly
+ * snapshot cache across plug-ins. The snapshot is empty until the first
+ * IPTimeEntitySnapshot::publish call.
+ *
+ */
+AtsPluginUtils::IPTimeEntitySnapshot& get_ip_time_entity_snapshot();
@@ -14,6 +14,7 @@
 
 namespace tbb {
 using IpAddress = AtsPluginUtils::IpAddress;
+using PackedIpKey = AtsPluginUtils::PackedIpKey;
 
 //  twang_mix64
 //
@@ -38,26 +39,38 @@ constexpr uint64_t twang_mix64(uint64_t key) noexcept {
  * Official document:
  * https://spec.oneapi.com/versions/latest/elements/oneTBB/source/named_requirements/containers/hash_compare.html
  *
+ * It is transparent: const sockaddr* is hashed and compared against IpAddress
+ * directly, address text is parsed once into TextKey and looked up as const
+ * sockaddr*, see LRUCache heterogeneous find. key() builds the IpAddress for
+ * pre-oneTBB containers, which find the key type only.
+ *
  */
 template <>
 struct tbb_hash_compare<IpAddress> {
-  static std::size_t hash(const IpAddress& k) {
-    size_t seed = twang_mix64(k.base.sa_family);
+  using is_transparent = void;
+  using TextKey = AtsPluginUtils::IpAddressText;
+
+  static std::size_t hash(const IpAddress& k) { return hash(&k.base); }
+
+  static std::size_t hash(const struct sockaddr* k) {
+    size_t seed = familySeed(k->sa_family);
 
-    switch (k.base.sa_family) {
+    switch (k->sa_family) {
       case AF_INET:
-        boost::hash_combine(seed, twang_mix64(k.v4.sin_addr.s_addr));
+        boost::hash_combine(seed, twang_mix64(reinterpret_cast<const struct sockaddr_in*>(k)->sin_addr.s_addr));
         break;
       case AF_INET6: {
         // The IPv6 address is 16 bytes long.
         // Combine it in blocks of sizeof(size_t) bytes each.
         static_assert(sizeof(struct in6_addr) % sizeof(size_t) == 0);
 
-        const size_t* p = reinterpret_cast<const size_t*>(k.v6.sin6_addr.s6_addr);
+        const auto* addr = reinterpret_cast<const struct sockaddr_in6*>(k)->sin6_addr.s6_addr;
         constexpr auto in6_addr_size = sizeof(struct in6_addr);
 
-        for (auto amtHashed = 0UL; amtHashed < in6_addr_size; amtHashed += sizeof(*p), ++p) {
-          boost::hash_combine(seed, twang_mix64(*p));
+        for (auto amtHashed = 0UL; amtHashed < in6_addr_size; amtHashed += sizeof(size_t)) {
+          size_t block;
+          memcpy(&block, addr + amtHashed, sizeof(block));
+          boost::hash_combine(seed, twang_mix64(block));
         }
       }
     }
@@ -65,7 +78,60 @@ struct tbb_hash_compare<IpAddress> {
     return seed;
   }
 
+  /**
+   * hashMany writes hash(keys[i]) into hashes[i] for count keys, for bulk loads and multi-key lookups.
+   * Each key runs both the IPv4 and the IPv6 rounds without branching on the family, the family picks the result,
+   * thus consecutive keys hash in parallel in the pipeline whatever the mix of families. The hash codes are identical
+   * to hash(), shard and bucket placement do not change.
+   */
+  static void hashMany(const IpAddress* keys, std::size_t count, std::size_t* hashes) {
+    for (std::size_t i = 0; i < count; i++) {
+      const IpAddress& k = keys[i];
+      const bool isV4 = k.base.sa_family == AF_INET;
+      const bool isV6 = k.base.sa_family == AF_INET6;
+
+      uint64_t block[2];
+      memcpy(block, k.v6.sin6_addr.s6_addr, sizeof(block));
+
+      const size_t seed = familySeed(k.base.sa_family);
+      size_t v4 = seed;
+      boost::hash_combine(v4, twang_mix64(isV4 ? k.v4.sin_addr.s_addr : block[0]));
+      size_t v6 = v4;
+      boost::hash_combine(v6, twang_mix64(block[1]));
+
+      hashes[i] = isV6 ? v6 : isV4 ? v4 : seed;
+    }
+  }
+
   static bool equal(const IpAddress& k1, const IpAddress& k2) { return k1 == k2; }
+
+  static bool equal(const IpAddress& k1, const struct sockaddr* k2) { return k1.equals(k2); }
+
+  static IpAddress key(const struct sockaddr* k) {
+    IpAddress ip;
+    ip.set(k);
+    return ip;
+  }
+
+private:
+  // familySeed is twang_mix64 of the family, constant for IPv4 and IPv6.
+  static uint64_t familySeed(sa_family_t family) {
+    constexpr uint64_t V4_SEED = twang_mix64(AF_INET);
+    constexpr uint64_t V6_SEED = twang_mix64(AF_INET6);
+    return family == AF_INET ? V4_SEED : family == AF_INET6 ? V6_SEED : twang_mix64(family);
+  }
+};
+
+/**
+ * tbb_hash_compare<PackedIpKey> is the compact counterpart of tbb_hash_compare<IpAddress>,
+ * hashing the 16 bytes address in two multiply-fold rounds.
+ *
+ */
+template <>
+struct tbb_hash_compare<PackedIpKey> {
+  static std::size_t hash(const PackedIpKey& k) { return k.hash(); }
+
+  static bool equal(const PackedIpKey& k1, const PackedIpKey& k2) { return k1 == k2; }
 };
 
 }  // namespace tbb
@@ -0,0 +1,268 @@
+/**
+ * @author shchang
+ */
+
+#pragma once
+#include <lru_cache/scale-lrucache.h>
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace LRUC {
+
+/**
+ * NearLRUCache is a ScalableLRUCache fronted by a small per-thread direct-mapped
+ * cache (near cache).
+ *
+ * find() looks up the calling thread's near cache first, a hit never writes to
+ * memory shared with other threads. On miss the backing ScalableLRUCache is
+ * looked up and the found value is copied into the near cache.
+ *
+ * Coherence:
+ * Each shard of the backing cache owns an invalidation epoch. erase() bumps the
+ * owning shard's epoch after the key is removed, insert() after the key is
+ * inserted, clear() bumps all of them. A near cache entry is only served while
+ * it was filled under the current epoch of its shard, thus an erased key is
+ * never returned once erase() returns, and a key evicted then inserted again
+ * is never returned with its old value once insert() returns.
+ *
+ * Entries evicted by the backing cache's LRU policy are not invalidated and may
+ * still be served from the near cache until their slot is overwritten or the
+ * shard's epoch moves. Near cache hits do not update the backing cache's access
+ * frequency.
+ *
+ * The near cache storage is thread_local per template instantiation. A thread
+ * accessing another NearLRUCache instance of the same type resets its near
+ * cache, use one instance per type for the best hit ratio.
+ *
+ * nearStats() returns the calling thread's near cache hit/miss counters.
+ *
+ * NearSize: near cache slot count, power of 2.
+ *
+ */
+template <class TKey, class TValue, class THash = tbb::tbb_hash_compare<TKey>, size_t NearSize = 64>
+class NearLRUCache final {
+  static_assert(NearSize > 0 && (NearSize & (NearSize - 1)) == 0, "NearSize must be power of 2");
+
+private:
+  using Backing = ScalableLRUCache<TKey, TValue, THash>;
+
+  /**
+   * Epoch is a cache line sized invalidation counter, one per shard.
+   */
+  struct alignas(64) Epoch final {
+    std::atomic<uint64_t> value_{0};
+  };
+
+  /**
+   * NearEntry is a near cache slot, valid while epoch_ equals its shard's epoch.
+   */
+  struct NearEntry final {
+    bool valid_ = false;
+    uint64_t epoch_ = 0;
+    size_t hash_ = 0;
+    TKey key_{};
+    TValue value_{};
+  };
+
+  /**
+   * NearStore is the calling thread's near cache, owned by the NearLRUCache
+   * instance with id owner_.
+   */
+  struct NearStore final {
+    uint64_t owner_ = 0;
+    uint64_t hits_ = 0;
+    uint64_t misses_ = 0;
+    std::array<NearEntry, NearSize> entries_{};
+  };
+
+  // instance id 0 is reserved for un-owned NearStore.
+  inline static std::atomic<uint64_t> nextId_{1};
+
+  Backing cache_;
+  std::vector<Epoch> epochs_;
+  const uint64_t id_;
+
+private:
+  /**
+   * nearStore returns the calling thread's NearStore, reset if it was owned by
+   * another instance.
+   */
+  NearStore& nearStore();
+
+public:
+  using HashedKey = typename Backing::HashedKey;
+
+  /**
+   * NearStats is the near cache hit/miss counter of a thread.
+   */
+  struct NearStats final {
+    uint64_t hits;
+    uint64_t misses;
+  };
+
+  /**
+   * ConstAccessor stores a copy of the found value.
+   */
+  struct ConstAccessor final {
+    constexpr ConstAccessor() = default;
+    constexpr ConstAccessor(const ConstAccessor&) = delete;
+
+    constexpr const TValue& operator*() const { return *get(); }
+
+    constexpr const TValue* operator->() const { return get(); }
+
+    constexpr const TValue* get() const { return &value_; }
+
+  private:
+    friend class NearLRUCache;
+    TValue value_{};
+  };
+
+  /**
+   * size: backing ScalableLRUCache capacity.
+   * shard_count: backing ScalableLRUCache shard count.
+   */
+  explicit NearLRUCache(size_t size, size_t shardCount = 0);
+
+  NearLRUCache(const NearLRUCache&) = delete;
+  NearLRUCache& operator=(const NearLRUCache&) = delete;
+
+  size_t erase(const TKey& key) { return erase(HashedKey{key}); }
+  size_t erase(const HashedKey& key);
+
+  bool find(ConstAccessor& caccessor, const TKey& key) { return find(caccessor, HashedKey{key}); }
+  bool find(ConstAccessor& caccessor, const HashedKey& key);
+
+  /**
+   * visit calls fn(const TValue&) on the near cache entry, filled from the
+   * backing cache on miss.
+   */
+  template <typename TFn>
+  bool visit(const TKey& key, TFn&& fn) {
+    return visit(HashedKey{key}, std::forward<TFn>(fn));
+  }
+  template <typename TFn>
+  bool visit(const HashedKey& key, TFn&& fn);
+
+  bool insert(const TKey& key, const TValue& value) { return insert(HashedKey{key}, value); }
+  bool insert(const HashedKey& key, const TValue& value);
+
+  /**
+   * clear is not thread-safe, same as ScalableLRUCache::clear.
+   */
+  void clear() noexcept;
+
+  long long size() const { return cache_.size(); }
+  int size(size_t shardIdx) const { return cache_.size(shardIdx); }
+
+  long long capacity() const { return cache_.capacity(); }
+  int capacity(size_t shardIdx) const { return cache_.capacity(shardIdx); }
+
+  size_t shardCount() const { return cache_.shardCount(); }
+
+  NearStats nearStats();
+};
+
+// ---- private member functions ----
+template <class TKey, class TValue, class THash, size_t NearSize>
+typename NearLRUCache<TKey, TValue, THash, NearSize>::NearStore&
+NearLRUCache<TKey, TValue, THash, NearSize>::nearStore() {
+  thread_local NearStore store;
+
+  if (store.owner_ != id_) {
+    for (auto& entry : store.entries_) {
+      entry.valid_ = false;
+    }
+    store.owner_ = id_;
+    store.hits_ = 0;
+    store.misses_ = 0;
+  }
+
+  return store;
+}
+// ---- private member functions end ----
+
+template <class TKey, class TValue, class THash, size_t NearSize>
+NearLRUCache<TKey, TValue, THash, NearSize>::NearLRUCache(size_t size, size_t shardCount)
+    : cache_(size, shardCount), epochs_(cache_.shardCount()), id_(nextId_++) {}
+
+template <class TKey, class TValue, class THash, size_t NearSize>
+size_t NearLRUCache<TKey, TValue, THash, NearSize>::erase(const HashedKey& key) {
+  size_t erased = cache_.erase(key);
+
+  // bump after erase, a reader loaded the new epoch is guaranteed to miss the
+  // erased key in the backing cache.
+  epochs_[cache_.shardIndex(key)].value_.fetch_add(1, std::memory_order_release);
+
+  return erased;
+}
+
+template <class TKey, class TValue, class THash, size_t NearSize>
+bool NearLRUCache<TKey, TValue, THash, NearSize>::insert(const HashedKey& key, const TValue& value) {
+  if (!cache_.insert(key, value)) {
+    return false;
+  }
+
+  // the key may have been evicted with its value still in near caches, bump
+  // after insert as erase() does.
+  epochs_[cache_.shardIndex(key)].value_.fetch_add(1, std::memory_order_release);
+
+  return true;
+}
+
+template <class TKey, class TValue, class THash, size_t NearSize>
+bool NearLRUCache<TKey, TValue, THash, NearSize>::find(ConstAccessor& caccessor, const HashedKey& key) {
+  return visit(key, [&caccessor](const TValue& value) { caccessor.value_ = value; });
+}
+
+template <class TKey, class TValue, class THash, size_t NearSize>
+template <typename TFn>
+bool NearLRUCache<TKey, TValue, THash, NearSize>::visit(const HashedKey& key, TFn&& fn) {
+  NearStore& store = nearStore();
+  NearEntry& entry = store.entries_[key.hash_ & (NearSize - 1)];
+
+  // load epoch before looking up the backing cache, see erase().
+  uint64_t epoch = epochs_[cache_.shardIndex(key)].value_.load(std::memory_order_acquire);
+
+  if (entry.valid_ && entry.epoch_ == epoch && entry.hash_ == key.hash_ && THash{}.equal(entry.key_, key.key_)) {
+    store.hits_++;
+    fn(entry.value_);
+    return true;
+  }
+
+  store.misses_++;
+
+  if (!cache_.visit(key, [&entry](const TValue& value) { entry.value_ = value; })) {
+    return false;
+  }
+
+  entry.valid_ = true;
+  entry.epoch_ = epoch;
+  entry.hash_ = key.hash_;
+  entry.key_ = key.key_;
+  fn(entry.value_);
+
+  return true;
+}
+
+template <class TKey, class TValue, class THash, size_t NearSize>
+void NearLRUCache<TKey, TValue, THash, NearSize>::clear() noexcept {
+  cache_.clear();
+
+  for (auto& epoch : epochs_) {
+    epoch.value_.fetch_add(1, std::memory_order_release);
+  }
+}
+
+template <class TKey, class TValue, class THash, size_t NearSize>
+typename NearLRUCache<TKey, TValue, THash, NearSize>::NearStats
+NearLRUCache<TKey, TValue, THash, NearSize>::nearStats() {
+  NearStore& store = nearStore();
+
+  return NearStats{store.hits_, store.misses_};
+}
+}  // namespace LRUC
@@ -0,0 +1,295 @@
+/**
+ * @author shchang
+ *
+ */
+
+#pragma once
+#include <ats_type.h>
+#include <lru_cache/cidr_index.h>
+#include <lru_cache/lrucache.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace vsdmars {
+
+/**
+ * SortedBlockSet is an ordered set of trivially copyable keys laid out as a
+ * B+tree of height two: sorted blocks of up to 2 * BLOCK keys, found by a
+ * binary search over the contiguous array of their first keys. A lookup
+ * touches two arrays instead of chasing log2(n) tree nodes, an insert or
+ * erase moves at most 2 * BLOCK keys.
+ *
+ * A full block splits in two, a block below BLOCK / 2 keys merges into its
+ * neighbour if they fit in one block, an empty block is removed.
+ *
+ * Not thread-safe.
+ *
+ */
+template <typename T>
+class SortedBlockSet final {
+private:
+  static constexpr size_t BLOCK = 64;
+
+  std::vector<T> firsts_;
+  std::vector<std::vector<T>> blocks_;
+
+private:
+  // blockOf returns the block which holds key if any key does, 0 for keys before the first.
+  size_t blockOf(const T& key) const {
+    const auto it = std::upper_bound(firsts_.begin(), firsts_.end(), key);
+    return it == firsts_.begin() ? 0 : static_cast<size_t>(std::distance(firsts_.begin(), it)) - 1;
+  }
+
+  void merge(size_t i);
+
+public:
+  SortedBlockSet() : firsts_(), blocks_() {}
+
+  bool insert(const T& key);
+
+  bool erase(const T& key);
+
+  /**
+   * forRange calls fn(const T&) on the keys in [first, last] in order.
+   */
+  template <typename TFn>
+  void forRange(const T& first, const T& last, TFn&& fn) const;
+
+  void clear() noexcept {
+    firsts_.clear();
+    blocks_.clear();
+  }
+};
+
+template <typename T>
+void SortedBlockSet<T>::merge(size_t i) {
+  auto& block = blocks_[i];
+  auto& next = blocks_[i + 1];
+  if (block.size() + next.size() > 2 * BLOCK) {
+    return;
+  }
+  block.insert(block.end(), next.begin(), next.end());
+  firsts_.erase(firsts_.begin() + static_cast<std::ptrdiff_t>(i) + 1);
+  blocks_.erase(blocks_.begin() + static_cast<std::ptrdiff_t>(i) + 1);
+}
+
+template <typename T>
+bool SortedBlockSet<T>::insert(const T& key) {
+  if (blocks_.empty()) {
+    firsts_.push_back(key);
+    blocks_.emplace_back(1, key);
+    return true;
+  }
+
+  const size_t i = blockOf(key);
+  auto& block = blocks_[i];
+  const auto pos = std::lower_bound(block.begin(), block.end(), key);
+  if (pos != block.end() && !(key < *pos)) {
+    return false;
+  }
+  block.insert(pos, key);
+  firsts_[i] = block.front();
+
+  if (block.size() > 2 * BLOCK) {
+    std::vector<T> upper(block.begin() + BLOCK, block.end());
+    block.resize(BLOCK);
+    firsts_.insert(firsts_.begin() + static_cast<std::ptrdiff_t>(i) + 1, upper.front());
+    blocks_.insert(blocks_.begin() + static_cast<std::ptrdiff_t>(i) + 1, std::move(upper));
+  }
+  return true;
+}
+
+template <typename T>
+bool SortedBlockSet<T>::erase(const T& key) {
+  if (blocks_.empty()) {
+    return false;
+  }
+
+  const size_t i = blockOf(key);
+  auto& block = blocks_[i];
+  const auto pos = std::lower_bound(block.begin(), block.end(), key);
+  if (pos == block.end() || key < *pos) {
+    return false;
+  }
+  block.erase(pos);
+
+  if (block.empty()) {
+    firsts_.erase(firsts_.begin() + static_cast<std::ptrdiff_t>(i));
+    blocks_.erase(blocks_.begin() + static_cast<std::ptrdiff_t>(i));
+    return true;
+  }
+  firsts_[i] = block.front();
+  if (block.size() < BLOCK / 2) {
+    if (i + 1 < blocks_.size()) {
+      merge(i);
+    } else if (i > 0) {
+      merge(i - 1);
+    }
+  }
+  return true;
+}
+
+template <typename T>
+template <typename TFn>
+void SortedBlockSet<T>::forRange(const T& first, const T& last, TFn&& fn) const {
+  for (size_t i = blocks_.empty() ? 0 : blockOf(first); i < blocks_.size(); i++) {
+    const auto& block = blocks_[i];
+    for (auto it = std::lower_bound(block.begin(), block.end(), first); it != block.end(); ++it) {
+      if (last < *it) {
+        return;
+      }
+      fn(*it);
+    }
+  }
+}
+
+/**
+ * OrderedIpMap is the LRUCache hash-map backend (see lrucache_map.h) for
+ * AtsPluginUtils::IpAddress keys keeping an ordered index of the keys beside
+ * a TbbHashMap, so LRUCache::eraseRange() drops every key inside a Cidr in
+ * O(log n + k) instead of scanning the map.
+ *
+ * The index holds IPv4 keys ordered by address, other keys by their 16 bytes
+ * address, in SortedBlockSets. insert() / erase() / clear() update the map and
+ * the index under one mutex, keysIn() reads the index under it, thus evictions
+ * (LRUCache erases through the backend) keep the index exact. LRUCache
+ * already serializes writes of a shard on its list lock, lookups go to the
+ * TbbHashMap only and never take the mutex.
+ *
+ * TKey is AtsPluginUtils::IpAddress or HashedKey<AtsPluginUtils::IpAddress, THash>.
+ *
+ */
+template <typename TKey, typename TValue, typename THashCompare>
+class OrderedIpMap final {
+private:
+  using IpAddress = AtsPluginUtils::IpAddress;
+  using V6Key = std::pair<uint64_t, uint64_t>;
+
+  TbbHashMap<TKey, TValue, THashCompare> map_;
+
+  // guards map_ writes along with v4_ / v6_.
+  std::mutex mutex_;
+  SortedBlockSet<uint32_t> v4_;
+  SortedBlockSet<V6Key> v6_;
+
+private:
+  static const IpAddress& address(const IpAddress& key) { return key; }
+
+  template <typename THash>
+  static const IpAddress& address(const HashedKey<IpAddress, THash>& key) {
+    return key.key_;
+  }
+
+  // host byte order, thus ordered by address bytes.
+  static uint32_t v4Key(const IpAddress& ip) { return ntohl(ip.v4.sin_addr.s_addr); }
+
+  static V6Key v6Key(const IpAddress& ip) {
+    uint64_t words[2];
+    memcpy(words, ip.v6.sin6_addr.s6_addr, sizeof(words));
+    return {__builtin_bswap64(words[0]), __builtin_bswap64(words[1])};
+  }
+
+  /**
+   * index inserts (insert true) or erases the key of ip, caller holds mutex_.
+   */
+  void index(const IpAddress& ip, bool insert);
+
+public:
+  OrderedIpMap(size_t capacity, size_t bucketCount) : map_(capacity, bucketCount), mutex_(), v4_(), v6_() {}
+
+  OrderedIpMap(const OrderedIpMap&) = delete;
+  OrderedIpMap& operator=(const OrderedIpMap&) = delete;
+
+  // TProbe is TKey or a HashedLookup.
+  template <typename TProbe, typename TFn>
+  bool visit(const TProbe& key, TFn&& fn) {
+    return map_.visit(key, std::forward<TFn>(fn));
+  }
+
+  bool insert(const TKey& key, const TValue& value) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (!map_.insert(key, value)) {
+      return false;
+    }
+    index(address(key), true);
+    return true;
+  }
+
+  bool erase(const TKey& key) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (!map_.erase(key)) {
+      return false;
+    }
+    index(address(key), false);
+    return true;
+  }
+
+  /**
+   * keysIn appends the keys inside cidr to keys, in address order.
+   */
+  void keysIn(const Cidr& cidr, std::vector<IpAddress>& keys);
+
+  void clear() noexcept {
+    std::unique_lock<std::mutex> lock(mutex_);
+    map_.clear();
+    v4_.clear();
+    v6_.clear();
+  }
+};
+
+// ---- private member functions ----
+template <typename TKey, typename TValue, typename THashCompare>
+void OrderedIpMap<TKey, TValue, THashCompare>::index(const IpAddress& ip, bool insert) {
+  if (ip.base.sa_family == AF_INET) {
+    if (insert) {
+      v4_.insert(v4Key(ip));
+    } else {
+      v4_.erase(v4Key(ip));
+    }
+  } else if (ip.base.sa_family == AF_INET6) {
+    if (insert) {
+      v6_.insert(v6Key(ip));
+    } else {
+      v6_.erase(v6Key(ip));
+    }
+  }
+}
+// ---- private member functions end ----
+
+template <typename TKey, typename TValue, typename THashCompare>
+void OrderedIpMap<TKey, TValue, THashCompare>::keysIn(const Cidr& cidr, std::vector<IpAddress>& keys) {
+  const int len = cidr.prefixLen;
+  std::unique_lock<std::mutex> lock(mutex_);
+
+  if (cidr.address.base.sa_family == AF_INET) {
+    const uint32_t hostMask = len >= 32 ? 0 : ~0U >> len;
+    const uint32_t first = v4Key(cidr.address) & ~hostMask;
+    v4_.forRange(first, first | hostMask, [&keys](uint32_t key) {
+      struct sockaddr_in addr {};
+      addr.sin_family = AF_INET;
+      addr.sin_addr.s_addr = htonl(key);
+      keys.emplace_back(reinterpret_cast<const struct sockaddr*>(&addr));
+    });
+  } else if (cidr.address.base.sa_family == AF_INET6) {
+    const uint64_t hiMask = len >= 64 ? 0 : ~0ULL >> len;
+    const uint64_t loMask = len >= 128 ? 0 : len <= 64 ? ~0ULL : ~0ULL >> (len - 64);
+    const V6Key address = v6Key(cidr.address);
+    const V6Key first{address.first & ~hiMask, address.second & ~loMask};
+    const V6Key last{first.first | hiMask, first.second | loMask};
+    v6_.forRange(first, last, [&keys](const V6Key& key) {
+      struct sockaddr_in6 addr {};
+      addr.sin6_family = AF_INET6;
+      const uint64_t words[2] = {__builtin_bswap64(key.first), __builtin_bswap64(key.second)};
+      memcpy(addr.sin6_addr.s6_addr, words, sizeof(words));
+      keys.emplace_back(reinterpret_cast<const struct sockaddr*>(&addr));
+    });
+  }
+}
+
+}  // namespace vsdmars
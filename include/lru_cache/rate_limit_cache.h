@@ -0,0 +1,197 @@
+/**
+ * @author shchang
+ */
+
+#pragma once
+#include <lru_cache/scale-lrucache.h>
+
+#include <atomic>
+#include <cstdint>
+#include <stdexcept>
+
+namespace LRUC {
+
+/**
+ * RateLimitCache is a ScalableLRUCache of per-key request rates, answering
+ * "is key over limit requests per window?" in one lookup.
+ *
+ * Each key holds a sliding window counter: the request counts of the current
+ * and of the previous fixed window. The rate at time now is
+ *
+ *   previous * (window - elapsed) / window + current
+ *
+ * elapsed being the time since the current window started. The counter is a
+ * single 64 bits atomic updated in place by compare-and-swap inside visit(),
+ * the entry is never copied out and in, so concurrent hits of a key need no
+ * lock besides the shard's own. Keys share the sharding and LRU eviction of
+ * ScalableLRUCache, an evicted key starts counting again.
+ *
+ * Time is in the caller's unit (e.g. milliseconds), the same for window and
+ * now. Counts saturate at MAX_COUNT per window.
+ *
+ * The counter keeps the low 32 bits of the window number (now / window) and
+ * compares them wrap-aware, any now (e.g. epoch milliseconds) works. A key
+ * idle for 2^31 windows or more may have its old counts taken as current, it
+ * is usually evicted long before.
+ *
+ */
+template <class TKey, class THash = tbb::tbb_hash_compare<TKey>,
+          template <class, class, class> class TMap = TbbHashMap>
+class RateLimitCache final {
+private:
+  /**
+   * RateCounter packs window number (low 32 bits) | previous count (16 bits) |
+   * current count (16 bits), updated in place by visit().
+   */
+  struct RateCounter final {
+    mutable std::atomic<uint64_t> state_;
+
+    explicit RateCounter(uint64_t state) : state_(state) {}
+    RateCounter(const RateCounter& rhs) : state_(rhs.state_.load(std::memory_order_relaxed)) {}
+    RateCounter& operator=(const RateCounter& rhs) {
+      state_.store(rhs.state_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+      return *this;
+    }
+  };
+
+  using Counters = ScalableLRUCache<TKey, RateCounter, THash, TMap>;
+
+  static constexpr int COUNT_BITS = 16;
+
+  Counters counters_;
+  const uint32_t limit_;
+  const int64_t window_;
+
+private:
+  static uint64_t pack(uint32_t windowNum, uint64_t previous, uint64_t current) {
+    return static_cast<uint64_t>(windowNum) << (2 * COUNT_BITS) | previous << COUNT_BITS | current;
+  }
+
+  /**
+   * advance returns state moved to windowNum: unchanged in the same or a
+   * newer window (a caller read now before a concurrent caller's newer now),
+   * current becoming previous in the next one, both cleared later.
+   */
+  static uint64_t advance(uint64_t state, uint32_t windowNum);
+
+  /**
+   * windowOf returns the low 32 bits of the window number of now.
+   */
+  uint32_t windowOf(int64_t now) const { return static_cast<uint32_t>(now / window_); }
+
+  /**
+   * rateOf returns the sliding window rate at now of state, already advanced to now's window.
+   */
+  double rateOf(uint64_t state, int64_t now) const;
+
+public:
+  static constexpr uint32_t MAX_COUNT = (1U << COUNT_BITS) - 1;
+
+  using HashedKey = typename Counters::HashedKey;
+
+  /**
+   * size: keys capacity.
+   * limit: requests allowed per window, at most MAX_COUNT.
+   * window: sliding window length, > 0, in the caller's time unit.
+   * shardCount: shard count.
+   * Throws std::invalid_argument if limit or window is out of range.
+   */
+  RateLimitCache(size_t size, uint32_t limit, int64_t window, size_t shardCount = 0);
+
+  RateLimitCache(const RateLimitCache&) = delete;
+  RateLimitCache& operator=(const RateLimitCache&) = delete;
+
+  /**
+   * hit counts one request of key at now (>= 0), returns true if the rate
+   * including it is over limit. Requests over limit are counted too, a key
+   * flooding stays over limit until it slows down.
+   */
+  bool hit(const TKey& key, int64_t now) { return hit(HashedKey{key}, now); }
+  bool hit(const HashedKey& key, int64_t now);
+
+  /**
+   * rate returns the request rate of key at now without counting, 0 if key has no counter.
+   */
+  double rate(const TKey& key, int64_t now) { return rate(HashedKey{key}, now); }
+  double rate(const HashedKey& key, int64_t now);
+
+  size_t erase(const TKey& key) { return counters_.erase(key); }
+
+  void clear() noexcept { counters_.clear(); }
+
+  long long size() const { return counters_.size(); }
+  long long capacity() const { return counters_.capacity(); }
+
+  uint32_t limit() const { return limit_; }
+  int64_t window() const { return window_; }
+};
+
+// ---- private member functions ----
+template <class TKey, class THash, template <class, class, class> class TMap>
+uint64_t RateLimitCache<TKey, THash, TMap>::advance(uint64_t state, uint32_t windowNum) {
+  // window numbers wrap at 32 bits, compare their distance.
+  const auto stateWindow = static_cast<uint32_t>(state >> (2 * COUNT_BITS));
+  const auto distance = static_cast<int32_t>(windowNum - stateWindow);
+  if (distance <= 0) {
+    return state;
+  }
+  if (distance == 1) {
+    return pack(windowNum, state & MAX_COUNT, 0);
+  }
+  return pack(windowNum, 0, 0);
+}
+
+template <class TKey, class THash, template <class, class, class> class TMap>
+double RateLimitCache<TKey, THash, TMap>::rateOf(uint64_t state, int64_t now) const {
+  const uint64_t previous = state >> COUNT_BITS & MAX_COUNT;
+  const uint64_t current = state & MAX_COUNT;
+  const int64_t remaining = window_ - now % window_;
+  return static_cast<double>(previous) * static_cast<double>(remaining) / static_cast<double>(window_) +
+         static_cast<double>(current);
+}
+// ---- private member functions end ----
+
+template <class TKey, class THash, template <class, class, class> class TMap>
+RateLimitCache<TKey, THash, TMap>::RateLimitCache(size_t size, uint32_t limit, int64_t window, size_t shardCount)
+    : counters_(size, shardCount), limit_(limit), window_(window) {
+  if (limit > MAX_COUNT || window <= 0) {
+    throw std::invalid_argument("RateLimitCache: limit or window out of range");
+  }
+}
+
+template <class TKey, class THash, template <class, class, class> class TMap>
+bool RateLimitCache<TKey, THash, TMap>::hit(const HashedKey& key, int64_t now) {
+  const uint32_t windowNum = windowOf(now);
+  uint64_t counted = 0;
+  auto increment = [windowNum, &counted](const RateCounter& counter) {
+    uint64_t state = counter.state_.load(std::memory_order_relaxed);
+    uint64_t next;
+    do {
+      next = advance(state, windowNum);
+      if ((next & MAX_COUNT) != MAX_COUNT) {
+        next++;
+      }
+    } while (!counter.state_.compare_exchange_weak(state, next, std::memory_order_relaxed));
+    counted = next;
+  };
+
+  if (!counters_.visit(key, increment)) {
+    counted = pack(windowNum, 0, 1);
+    if (!counters_.insert(key, RateCounter{counted})) {
+      // lost the insert race, count on the winner's entry.
+      counters_.visit(key, increment);
+    }
+  }
+  return rateOf(counted, now) > static_cast<double>(limit_);
+}
+
+template <class TKey, class THash, template <class, class, class> class TMap>
+double RateLimitCache<TKey, THash, TMap>::rate(const HashedKey& key, int64_t now) {
+  const uint32_t windowNum = windowOf(now);
+  double result = 0;
+  counters_.visit(key, [this, windowNum, now, &result](const RateCounter& counter) {
+    result = rateOf(advance(counter.state_.load(std::memory_order_relaxed), windowNum), now);
+  });
+  return result;
+}
+}  // namespace LRUC
@@ -10,10 +10,11 @@
 
 namespace LRUC {
 
-template <class TKey, class TValue, class THash = tbb::tbb_hash_compare<TKey>>
+template <class TKey, class TValue, class THash = tbb::tbb_hash_compare<TKey>,
+          template <class, class, class> class TMap = TbbHashMap>
 class ScalableLRUCache final {
 private:
-  using Shard = LRUCache<TKey, TValue, THash>;
+  using Shard = LRUCache<TKey, TValue, THash, TMap>;
   using ShardPtr = std::unique_ptr<Shard>;
 
   std::vector<ShardPtr> shards_;
@@ -22,12 +23,26 @@ private:
 
 private:
   /**
-   * shard returns a Shard (LRUCache instance) based on key.
+   * shard returns a Shard (LRUCache instance) based on key's pre-computed hash code.
    */
-  Shard& shard(const TKey& key);
+  Shard& shard(const typename Shard::HashedKey& key);
+
+  /**
+   * shardIndexOf returns the index of the shard owning hash code.
+   */
+  size_t shardIndexOf(size_t hash) const;
 
 public:
   using ConstAccessor = typename Shard::ConstAccessor;
+  using HashedKey = typename Shard::HashedKey;
+
+  template <typename TLookup>
+  using EnableLookup = typename Shard::template EnableLookup<TLookup>;
+
+  template <typename TText>
+  using EnableText = typename Shard::template EnableText<TText>;
+
+  constexpr static bool OptimisticRead = Shard::OptimisticRead;
 
   /**
    * size: ScalableLRUCache capacity. And each internal LRUCache's capacity can be changed at runtime TODO(shchang)
@@ -40,11 +55,78 @@ public:
   ScalableLRUCache(const ScalableLRUCache&) = delete;
   ScalableLRUCache& operator=(const ScalableLRUCache&) = delete;
 
-  size_t erase(const TKey& key);
+  /**
+   * TKey overloads hash the key once, the same hash code is used for shard
+   * selection and inside the shard. HashedKey overloads reuse the caller's
+   * hash code, see HashedKey in lrucache.h.
+   */
+  size_t erase(const TKey& key) { return erase(HashedKey{key}); }
+  size_t erase(const HashedKey& key);
+
+  /**
+   * eraseRange removes every key inside range from each shard, see
+   * LRUCache::eraseRange.
+   */
+  template <typename TRange>
+  size_t eraseRange(const TRange& range);
+
+  bool find(ConstAccessor& caccessor, const TKey& key) { return find(caccessor, HashedKey{key}); }
+  bool find(ConstAccessor& caccessor, const HashedKey& key);
 
-  bool find(ConstAccessor& caccessor, const TKey& key);
+  /**
+   * Heterogeneous find / visit hash the other form of the key once, see LRUCache.
+   */
+  template <typename TLookup, typename = EnableLookup<TLookup>>
+  bool find(ConstAccessor& caccessor, const TLookup& key) {
+    return find(caccessor, hashLookup<THash>(key));
+  }
+  template <typename TLookup>
+  bool find(ConstAccessor& caccessor, const HashedLookup<TLookup>& key) {
+    return shards_[shardIndexOf(key.hash_)]->find(caccessor, key);
+  }
 
-  bool insert(const TKey& key, const TValue& value);
+  /**
+   * Text find / visit parse the text once, see LRUCache.
+   */
+  template <typename TText, EnableText<TText> = 0>
+  bool find(ConstAccessor& caccessor, const TText& text) {
+    const typename THash::TextKey parsed{std::string_view{text}};
+    return parsed && find(caccessor, hashLookup<THash>(parsed.lookup()));
+  }
+
+  /**
+   * visit calls fn(const TValue&) on the stored value, see LRUCache::visit.
+   */
+  template <typename TFn>
+  bool visit(const TKey& key, TFn&& fn) {
+    return visit(HashedKey{key}, std::forward<TFn>(fn));
+  }
+  template <typename TFn>
+  bool visit(const HashedKey& key, TFn&& fn) {
+    return shard(key).visit(key, std::forward<TFn>(fn));
+  }
+  template <typename TLookup, typename TFn, typename = EnableLookup<TLookup>>
+  bool visit(const TLookup& key, TFn&& fn) {
+    return visit(hashLookup<THash>(key), std::forward<TFn>(fn));
+  }
+  template <typename TLookup, typename TFn>
+  bool visit(const HashedLookup<TLookup>& key, TFn&& fn) {
+    return shards_[shardIndexOf(key.hash_)]->visit(key, std::forward<TFn>(fn));
+  }
+  template <typename TText, typename TFn, EnableText<TText> = 0>
+  bool visit(const TText& text, TFn&& fn) {
+    const typename THash::TextKey parsed{std::string_view{text}};
+    return parsed && visit(hashLookup<THash>(parsed.lookup()), std::forward<TFn>(fn));
+  }
+
+  bool insert(const TKey& key, const TValue& value) { return insert(HashedKey{key}, value); }
+  bool insert(const HashedKey& key, const TValue& value);
+
+  /**
+   * update overwrites the value of an existing key in place, see LRUCache::update.
+   */
+  bool update(const TKey& key, const TValue& value) { return update(HashedKey{key}, value); }
+  bool update(const HashedKey& key, const TValue& value) { return shard(key).update(key, value); }
 
   void clear() noexcept;
 
@@ -55,25 +137,23 @@ public:
   int capacity(size_t shardIdx) const;
 
   size_t shardCount() const;
+
+  /**
+   * shardIndex returns the index of the shard owning key.
+   */
+  size_t shardIndex(const HashedKey& key) const;
 };
 
 // ---- private member functions ----
-template <class TKey, class TValue, class THash>
-typename ScalableLRUCache<TKey, TValue, THash>::Shard& ScalableLRUCache<TKey, TValue, THash>::shard(const TKey& key) {
-  THash hashObj{};
-  // lower 16 bits counted as hash key
-  constexpr int shift = std::numeric_limits<size_t>::digits - 16;
-
-  // According to intel TBB doc:
-  // Good performance depends on having good pseudo-randomness in the low-order bits of the hash code.
-  size_t h = (hashObj.hash(key) >> shift) % shardCount_;
-
-  return *shards_[h];
+template <class TKey, class TValue, class THash, template <class, class, class> class TMap>
+typename ScalableLRUCache<TKey, TValue, THash, TMap>::Shard& ScalableLRUCache<TKey, TValue, THash, TMap>::shard(
+    const HashedKey& key) {
+  return *shards_[shardIndex(key)];
 }
 // ---- private member functions end ----
 
-template <class TKey, class TValue, class THash>
-ScalableLRUCache<TKey, TValue, THash>::ScalableLRUCache(size_t size, size_t shard_count)
+template <class TKey, class TValue, class THash, template <class, class, class> class TMap>
+ScalableLRUCache<TKey, TValue, THash, TMap>::ScalableLRUCache(size_t size, size_t shard_count)
     : cacheSize_(size), shardCount_(shard_count > 0 ? shard_count : std::thread::hardware_concurrency()) {
   const size_t bucket_count = std::thread::hardware_concurrency() * 8;
 
@@ -85,30 +165,40 @@ ScalableLRUCache<TKey, TValue, THash>::ScalableLRUCache(size_t size, size_t shar
   }
 }
 
-template <class TKey, class TValue, class THash>
-size_t ScalableLRUCache<TKey, TValue, THash>::erase(const TKey& key) {
+template <class TKey, class TValue, class THash, template <class, class, class> class TMap>
+size_t ScalableLRUCache<TKey, TValue, THash, TMap>::erase(const HashedKey& key) {
   return shard(key).erase(key);
 }
 
-template <class TKey, class TValue, class THash>
-bool ScalableLRUCache<TKey, TValue, THash>::find(ConstAccessor& caccessor, const TKey& key) {
+template <class TKey, class TValue, class THash, template <class, class, class> class TMap>
+template <typename TRange>
+size_t ScalableLRUCache<TKey, TValue, THash, TMap>::eraseRange(const TRange& range) {
+  size_t erased = 0;
+  for (size_t i = 0; i < shardCount_; i++) {
+    erased += shards_[i]->eraseRange(range);
+  }
+  return erased;
+}
+
+template <class TKey, class TValue, class THash, template <class, class, class> class TMap>
+bool ScalableLRUCache<TKey, TValue, THash, TMap>::find(ConstAccessor& caccessor, const HashedKey& key) {
   return shard(key).find(caccessor, key);
 }
 
-template <class TKey, class TValue, class THash>
-bool ScalableLRUCache<TKey, TValue, THash>::insert(const TKey& key, const TValue& value) {
+template <class TKey, class TValue, class THash, template <class, class, class> class TMap>
+bool ScalableLRUCache<TKey, TValue, THash, TMap>::insert(const HashedKey& key, const TValue& value) {
   return shard(key).insert(key, value);
 }
 
-template <class TKey, class TValue, class THash>
-void ScalableLRUCache<TKey, TValue, THash>::clear() noexcept {
+template <class TKey, class TValue, class THash, template <class, class, class> class TMap>
+void ScalableLRUCache<TKey, TValue, THash, TMap>::clear() noexcept {
   for (size_t i = 0; i < shardCount_; i++) {
     shards_[i]->clear();
   }
 }
 
-template <class TKey, class TValue, class THash>
-long long ScalableLRUCache<TKey, TValue, THash>::size() const {
+template <class TKey, class TValue, class THash, template <class, class, class> class TMap>
+long long ScalableLRUCache<TKey, TValue, THash, TMap>::size() const {
   long long size = 0;
   for (size_t i = 0; i < shardCount_; i++) {
     size += shards_[i]->size();
@@ -116,8 +206,8 @@ long long ScalableLRUCache<TKey, TValue, THash>::size() const {
   return size;
 }
 
-template <class TKey, class TValue, class THash>
-int ScalableLRUCache<TKey, TValue, THash>::size(size_t shard_idx) const {
+template <class TKey, class TValue, class THash, template <class, class, class> class TMap>
+int ScalableLRUCache<TKey, TValue, THash, TMap>::size(size_t shard_idx) const {
   if (shard_idx < shardCount_) {
     return shards_[shard_idx]->size();
   }
@@ -125,8 +215,8 @@ int ScalableLRUCache<TKey, TValue, THash>::size(size_t shard_idx) const {
   return 0;
 }
 
-template <class TKey, class TValue, class THash>
-long long ScalableLRUCache<TKey, TValue, THash>::capacity() const {
+template <class TKey, class TValue, class THash, template <class, class, class> class TMap>
+long long ScalableLRUCache<TKey, TValue, THash, TMap>::capacity() const {
   long long size = 0;
   for (size_t i = 0; i < shardCount_; i++) {
     size += shards_[i]->capacity();
@@ -135,8 +225,8 @@ long long ScalableLRUCache<TKey, TValue, THash>::capacity() const {
   return size;
 }
 
-template <class TKey, class TValue, class THash>
-int ScalableLRUCache<TKey, TValue, THash>::capacity(size_t shard_idx) const {
+template <class TKey, class TValue, class THash, template <class, class, class> class TMap>
+int ScalableLRUCache<TKey, TValue, THash, TMap>::capacity(size_t shard_idx) const {
   if (shard_idx < shardCount_) {
     return shards_[shard_idx]->capacity();
   }
@@ -144,8 +234,24 @@ int ScalableLRUCache<TKey, TValue, THash>::capacity(size_t shard_idx) const {
   return 0;
 }
 
-template <class TKey, class TValue, class THash>
-size_t ScalableLRUCache<TKey, TValue, THash>::shardCount() const {
+template <class TKey, class TValue, class THash, template <class, class, class> class TMap>
+size_t ScalableLRUCache<TKey, TValue, THash, TMap>::shardCount() const {
   return shardCount_;
 }
+
+template <class TKey, class TValue, class THash, template <class, class, class> class TMap>
+size_t ScalableLRUCache<TKey, TValue, THash, TMap>::shardIndex(const HashedKey& key) const {
+  return shardIndexOf(key.hash_);
+}
+
+template <class TKey, class TValue, class THash, template <class, class, class> class TMap>
+size_t ScalableLRUCache<TKey, TValue, THash, TMap>::shardIndexOf(size_t hash) const {
+  // higher 16 bits counted as hash key
+  constexpr int shift = std::numeric_limits<size_t>::digits - 16;
+
+  // According to intel TBB doc:
+  // Good performance depends on having good pseudo-randomness in the low-order bits of the hash code.
+  // The low-order bits are left to the shard's concurrent_hash_map bucket selection.
+  return (hash >> shift) % shardCount_;
+}
 }  // namespace LRUC
@@ -0,0 +1,180 @@
+/**
+ * @author shchang
+ *
+ */
+
+#pragma once
+#include <lru_cache/clock_lru_cache.h>
+
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace vsdmars {
+
+/**
+ * ScalableClockCache splits the capacity into LRUClockCache shards, each shard
+ * owns its own shared_mutex thus threads accessing different shards never
+ * contend.
+ *
+ * Capacity split and shard routing follow ScalableLRUCache: shard 0 takes the
+ * remainder, shard index is taken from the higher 16 bits of the hash code and
+ * the lower bits are left to the shard's hash map.
+ *
+ * Shard count is clamped to the capacity, a shard always holds at least one
+ * slot.
+ *
+ * CounterBits, TMutex: see LRUClockCache.
+ *
+ */
+template <typename TKey, typename TValue, typename THash = std::hash<TKey>,
+          typename TKeyEqual = std::equal_to<TKey>, size_t CounterBits = 2,
+          typename TMutex = std::shared_mutex>
+class ScalableClockCache final {
+private:
+  // type defs
+  using Shard =
+      LRUClockCache<TKey, TValue, THash, TKeyEqual, CounterBits, TMutex>;
+  using ShardPtr = std::unique_ptr<Shard>;
+  using Optional = std::optional<TValue>;
+
+private:
+  std::vector<ShardPtr> shards_;
+  const size_t cacheSize_;
+  size_t shardCount_;
+
+private:
+  /**
+   * shard returns the Shard (LRUClockCache instance) owning key.
+   */
+  Shard &shard(const TKey &key) { return *shards_[shardIndex(key)]; }
+
+public:
+  /**
+   * size: ScalableClockCache capacity.
+   * shardCount: shard count, hardware concurrency if 0.
+   */
+  explicit ScalableClockCache(size_t size, size_t shardCount = 0);
+
+  ~ScalableClockCache() noexcept = default;
+
+  ScalableClockCache(const ScalableClockCache &other) = delete;
+  ScalableClockCache &operator=(const ScalableClockCache &) = delete;
+
+  size_t erase(const TKey &key) { return shard(key).erase(key); }
+  Optional find(const TKey &key) { return shard(key).find(key); }
+
+  /**
+   * visit calls fn(const TValue &) on the stored value, see
+   * LRUClockCache::visit.
+   */
+  template <typename TFn> bool visit(const TKey &key, TFn &&fn) {
+    return shard(key).visit(key, std::forward<TFn>(fn));
+  }
+
+  bool insert(const TKey &key, const TValue &value) {
+    return shard(key).insert(key, value);
+  }
+
+  /**
+   * clear is not thread-safe, same as LRUClockCache::clear.
+   */
+  void clear() noexcept;
+
+  size_t size() const;
+  size_t size(size_t shardIdx) const;
+
+  size_t capacity() const noexcept { return cacheSize_; }
+  size_t capacity(size_t shardIdx) const;
+
+  size_t shardCount() const noexcept { return shardCount_; }
+
+  /**
+   * shardIndex returns the index of the shard owning key.
+   */
+  size_t shardIndex(const TKey &key) const;
+};
+
+template <typename TKey, typename TValue, typename THash, typename TKeyEqual,
+          size_t CounterBits, typename TMutex>
+ScalableClockCache<TKey, TValue, THash, TKeyEqual, CounterBits, TMutex>::
+    ScalableClockCache(size_t size, size_t shardCount)
+    : shards_(), cacheSize_(size),
+      shardCount_(shardCount > 0 ? shardCount
+                                 : std::thread::hardware_concurrency()) {
+  shardCount_ = std::clamp<size_t>(shardCount_, 1, std::max<size_t>(size, 1));
+
+  size_t cap = cacheSize_ / shardCount_;
+  size_t modular = cacheSize_ % shardCount_;
+
+  for (size_t i = 0; i < shardCount_; i++) {
+    shards_.emplace_back(
+        std::make_unique<Shard>(i != 0 ? cap : (cap + modular)));
+  }
+}
+
+template <typename TKey, typename TValue, typename THash, typename TKeyEqual,
+          size_t CounterBits, typename TMutex>
+void ScalableClockCache<TKey, TValue, THash, TKeyEqual, CounterBits,
+                        TMutex>::clear() noexcept {
+  for (auto &shard : shards_) {
+    shard->clear();
+  }
+}
+
+template <typename TKey, typename TValue, typename THash, typename TKeyEqual,
+          size_t CounterBits, typename TMutex>
+size_t
+ScalableClockCache<TKey, TValue, THash, TKeyEqual, CounterBits,
+                   TMutex>::size() const {
+  size_t size = 0;
+  for (const auto &shard : shards_) {
+    size += shard->size();
+  }
+
+  return size;
+}
+
+template <typename TKey, typename TValue, typename THash, typename TKeyEqual,
+          size_t CounterBits, typename TMutex>
+size_t ScalableClockCache<TKey, TValue, THash, TKeyEqual, CounterBits,
+                          TMutex>::size(
+    size_t shardIdx) const {
+  if (shardIdx < shardCount_) {
+    return shards_[shardIdx]->size();
+  }
+
+  return 0;
+}
+
+template <typename TKey, typename TValue, typename THash, typename TKeyEqual,
+          size_t CounterBits, typename TMutex>
+size_t
+ScalableClockCache<TKey, TValue, THash, TKeyEqual, CounterBits,
+                   TMutex>::capacity(
+    size_t shardIdx) const {
+  if (shardIdx < shardCount_) {
+    return shards_[shardIdx]->capacity();
+  }
+
+  return 0;
+}
+
+template <typename TKey, typename TValue, typename THash, typename TKeyEqual,
+          size_t CounterBits, typename TMutex>
+size_t
+ScalableClockCache<TKey, TValue, THash, TKeyEqual, CounterBits,
+                   TMutex>::shardIndex(
+    const TKey &key) const {
+  // higher 16 bits counted as hash key, see ScalableLRUCache::shardIndex.
+  constexpr int shift = std::numeric_limits<size_t>::digits - 16;
+
+  return (THash{}(key) >> shift) % shardCount_;
+}
+
+} // namespace vsdmars
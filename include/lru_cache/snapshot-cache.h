@@ -0,0 +1,405 @@
+/**
+ * @author shchang
+ */
+
+#pragma once
+
+#include <tbb/concurrent_hash_map.h>
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace LRUC {
+
+/**
+ * RcuDomain is a process wide epoch based reclamation domain.
+ *
+ * Readers enter a read-side critical section through ReadGuard, which only
+ * writes to the calling thread's own cache line sized reader slot.
+ * synchronize() waits until every reader entered before the call has left its
+ * critical section, after which memory unpublished before the call can be
+ * reclaimed.
+ *
+ * A thread claims a free reader slot on its first read and releases it on
+ * thread exit, a released slot is claimed again by the next new thread. Slots
+ * come in blocks of BlockReaders, a block is appended once every slot is
+ * claimed, thus a read never fails however many threads read. Blocks live as
+ * long as the process, their count is bounded by the peak reader thread count.
+ *
+ */
+class RcuDomain final {
+public:
+  constexpr static size_t BlockReaders = 512;
+
+  static RcuDomain& instance() {
+    static RcuDomain domain;
+    return domain;
+  }
+
+  /**
+   * ReadGuard marks the calling thread inside read-side critical section
+   * during its lifetime. Nested guards are allowed.
+   */
+  class ReadGuard final {
+  public:
+    explicit ReadGuard(RcuDomain& domain);
+    ~ReadGuard();
+
+    ReadGuard(const ReadGuard&) = delete;
+    ReadGuard& operator=(const ReadGuard&) = delete;
+
+  private:
+    struct Local;
+    Local& local_;
+    friend class RcuDomain;
+  };
+
+  /**
+   * synchronize waits for the grace period, i.e. all readers entered before the
+   * call have left. Must not be called inside read-side critical section.
+   */
+  void synchronize();
+
+private:
+  // reader slot epoch when reader is outside read-side critical section.
+  constexpr static uint64_t IDLE = 0;
+
+  struct alignas(64) ReaderSlot final {
+    std::atomic<bool> used_{false};
+    std::atomic<uint64_t> epoch_{IDLE};
+  };
+
+  /**
+   * SlotBlock is a block of reader slots, blocks are linked through next_ and
+   * never unlinked.
+   */
+  struct SlotBlock final {
+    std::array<ReaderSlot, BlockReaders> slots_{};
+    std::atomic<SlotBlock*> next_{nullptr};
+  };
+
+  RcuDomain() = default;
+
+  ReadGuard::Local& local();
+
+  /**
+   * claim returns a free reader slot marked used, appending a block if none is free.
+   */
+  ReaderSlot* claim();
+
+  std::atomic<uint64_t> epoch_{1};
+  SlotBlock head_{};
+};
+
+/**
+ * Local is the calling thread's claimed reader slot, released on thread exit.
+ */
+struct RcuDomain::ReadGuard::Local final {
+  ReaderSlot* slot_ = nullptr;
+  int depth_ = 0;
+
+  Local() = default;
+  Local(const Local&) = delete;
+  Local& operator=(const Local&) = delete;
+
+  ~Local() {
+    if (slot_) {
+      slot_->used_.store(false);
+    }
+  }
+};
+
+inline RcuDomain::ReadGuard::ReadGuard(RcuDomain& domain) : local_(domain.local()) {
+  if (local_.depth_++ == 0) {
+    local_.slot_->epoch_.store(domain.epoch_.load());
+  }
+}
+
+inline RcuDomain::ReadGuard::~ReadGuard() {
+  if (--local_.depth_ == 0) {
+    local_.slot_->epoch_.store(IDLE);
+  }
+}
+
+inline RcuDomain::ReadGuard::Local& RcuDomain::local() {
+  thread_local ReadGuard::Local local;
+
+  if (local.slot_ == nullptr) {
+    local.slot_ = claim();
+  }
+
+  return local;
+}
+
+inline RcuDomain::ReaderSlot* RcuDomain::claim() {
+  for (SlotBlock* block = &head_;;) {
+    for (auto& slot : block->slots_) {
+      bool used = false;
+      if (slot.used_.compare_exchange_strong(used, true)) {
+        return &slot;
+      }
+    }
+
+    SlotBlock* next = block->next_.load(std::memory_order_acquire);
+    if (next == nullptr) {
+      // threads racing to append keep the first block linked.
+      auto* fresh = new SlotBlock;
+      if (block->next_.compare_exchange_strong(next, fresh, std::memory_order_acq_rel)) {
+        next = fresh;
+      } else {
+        delete fresh;
+      }
+    }
+    block = next;
+  }
+}
+
+inline void RcuDomain::synchronize() {
+  // readers entered with an epoch older than target may still hold memory
+  // unpublished before this call.
+  const uint64_t target = epoch_.fetch_add(1) + 1;
+
+  for (SlotBlock* block = &head_; block != nullptr; block = block->next_.load(std::memory_order_acquire)) {
+    for (auto& slot : block->slots_) {
+      while (true) {
+        uint64_t epoch = slot.epoch_.load();
+        if (epoch == IDLE || epoch >= target) {
+          break;
+        }
+        std::this_thread::yield();
+      }
+    }
+  }
+}
+
+/**
+ * SnapshotCache is a read-mostly cache holding an immutable snapshot of
+ * key/value entries, e.g. blocklist reloaded every few minutes and read
+ * millions of times per second.
+ *
+ * find() is lock-free and refcount-free: it reads the current snapshot through
+ * an atomic pointer inside RcuDomain read-side critical section, which writes
+ * only to the calling thread's own reader slot.
+ *
+ * publish() builds the next snapshot off-line from the given entries, swaps it
+ * in and reclaims the previous snapshot once RcuDomain's grace period elapsed.
+ * Concurrent publish() calls are serialized.
+ *
+ * Snapshot is a densely packed open-addressing table: entries are stored
+ * contiguously, the bucket array holds 32 bits hash tag and entry index and is
+ * sized to keep load factor at most 0.5, lookup touches one bucket line and one
+ * entry line in common case.
+ *
+ * Type concepts:
+ * TKey type requires TBB::HashCompare concept.
+ * TValue type requires CopyInsertable concept.
+ *
+ */
+template <class TKey, class TValue, class THash = tbb::tbb_hash_compare<TKey>>
+class SnapshotCache final {
+public:
+  using Entries = std::vector<std::pair<TKey, TValue>>;
+
+private:
+  /**
+   * Snapshot is the immutable table published by SnapshotCache.
+   */
+  class Snapshot final {
+  public:
+    explicit Snapshot(const Entries& entries);
+
+    /**
+     * find returns pointer to the value of key, nullptr if not found.
+     */
+    const TValue* find(const TKey& key) const;
+
+    size_t size() const { return entries_.size(); }
+
+  private:
+    constexpr static uint32_t EMPTY = std::numeric_limits<uint32_t>::max();
+
+    struct Bucket final {
+      uint32_t tag_;
+      uint32_t idx_;
+    };
+
+    // higher 32 bits of hash code, the lower bits select the bucket.
+    static uint32_t tag(size_t hash) {
+      return static_cast<uint32_t>(hash >> (std::numeric_limits<size_t>::digits - 32));
+    }
+
+    Entries entries_;
+    std::vector<Bucket> buckets_;
+    size_t mask_;
+  };
+
+public:
+  /**
+   * ConstAccessor stores a copy of the found value.
+   */
+  struct ConstAccessor final {
+    constexpr ConstAccessor() = default;
+    constexpr ConstAccessor(const ConstAccessor&) = delete;
+
+    constexpr const TValue& operator*() const { return *get(); }
+
+    constexpr const TValue* operator->() const { return get(); }
+
+    constexpr const TValue* get() const { return &value_; }
+
+  private:
+    friend class SnapshotCache;
+    TValue value_{};
+  };
+
+  SnapshotCache() : snapshot_(new Snapshot(Entries{})), publishMutex_() {}
+
+  /**
+   * Not thread-safe, no reader or writer may access the cache during destruction.
+   */
+  ~SnapshotCache() noexcept { delete snapshot_.load(); }
+
+  SnapshotCache(const SnapshotCache&) = delete;
+  SnapshotCache& operator=(const SnapshotCache&) = delete;
+
+  /**
+   * find finds key in the current snapshot.
+   * ConstAccessor stores a copy of the found result.
+   * Return true if key exist, otherwise false.
+   *
+   */
+  bool find(ConstAccessor& caccessor, const TKey& key) const;
+
+  /**
+   * visit calls fn(const TValue&) on the value inside the current snapshot,
+   * the snapshot is not reclaimed until fn returns.
+   * Return true if key exist, otherwise false.
+   *
+   */
+  template <typename TFn>
+  bool visit(const TKey& key, TFn&& fn) const;
+
+  /**
+   * publish replaces the current snapshot with entries.
+   * For duplicated keys the first entry wins.
+   * Blocks until the previous snapshot is reclaimed, must not be called from
+   * read-side critical section.
+   *
+   */
+  void publish(const Entries& entries);
+
+  /**
+   * size returns the current snapshot size.
+   *
+   */
+  size_t size() const;
+
+private:
+  std::atomic<const Snapshot*> snapshot_;
+  std::mutex publishMutex_;
+};
+
+template <class TKey, class TValue, class THash>
+SnapshotCache<TKey, TValue, THash>::Snapshot::Snapshot(const Entries& entries) : entries_(), buckets_(), mask_(0) {
+  size_t bucketCount = 2;
+  while (bucketCount < entries.size() * 2) {
+    bucketCount <<= 1;
+  }
+
+  buckets_.assign(bucketCount, Bucket{0, EMPTY});
+  mask_ = bucketCount - 1;
+  entries_.reserve(entries.size());
+
+  THash hashObj{};
+  for (const auto& entry : entries) {
+    size_t hash = hashObj.hash(entry.first);
+    uint32_t entryTag = tag(hash);
+    bool duplicated = false;
+    size_t i = hash & mask_;
+
+    for (; buckets_[i].idx_ != EMPTY; i = (i + 1) & mask_) {
+      if (buckets_[i].tag_ == entryTag && hashObj.equal(entries_[buckets_[i].idx_].first, entry.first)) {
+        duplicated = true;
+        break;
+      }
+    }
+
+    if (!duplicated) {
+      buckets_[i] = Bucket{entryTag, static_cast<uint32_t>(entries_.size())};
+      entries_.push_back(entry);
+    }
+  }
+}
+
+template <class TKey, class TValue, class THash>
+const TValue* SnapshotCache<TKey, TValue, THash>::Snapshot::find(const TKey& key) const {
+  THash hashObj{};
+  size_t hash = hashObj.hash(key);
+  uint32_t keyTag = tag(hash);
+
+  // load factor <= 0.5 guarantees an empty bucket terminates the probe.
+  for (size_t i = hash & mask_; buckets_[i].idx_ != EMPTY; i = (i + 1) & mask_) {
+    if (buckets_[i].tag_ == keyTag) {
+      const auto& entry = entries_[buckets_[i].idx_];
+      if (hashObj.equal(entry.first, key)) {
+        return &entry.second;
+      }
+    }
+  }
+
+  return nullptr;
+}
+
+template <class TKey, class TValue, class THash>
+bool SnapshotCache<TKey, TValue, THash>::find(ConstAccessor& caccessor, const TKey& key) const {
+  RcuDomain::ReadGuard guard{RcuDomain::instance()};
+
+  const TValue* value = snapshot_.load()->find(key);
+  if (value == nullptr) {
+    return false;
+  }
+
+  caccessor.value_ = *value;
+  return true;
+}
+
+template <class TKey, class TValue, class THash>
+template <typename TFn>
+bool SnapshotCache<TKey, TValue, THash>::visit(const TKey& key, TFn&& fn) const {
+  RcuDomain::ReadGuard guard{RcuDomain::instance()};
+
+  const TValue* value = snapshot_.load()->find(key);
+  if (value == nullptr) {
+    return false;
+  }
+
+  fn(*value);
+  return true;
+}
+
+template <class TKey, class TValue, class THash>
+void SnapshotCache<TKey, TValue, THash>::publish(const Entries& entries) {
+  // build off-line, outside of the publish lock.
+  auto next = std::make_unique<const Snapshot>(entries);
+
+  std::unique_lock<std::mutex> lock(publishMutex_);
+  const Snapshot* prev = snapshot_.exchange(next.release());
+
+  RcuDomain::instance().synchronize();
+  delete prev;
+}
+
+template <class TKey, class TValue, class THash>
+size_t SnapshotCache<TKey, TValue, THash>::size() const {
+  RcuDomain::ReadGuard guard{RcuDomain::instance()};
+
+  return snapshot_.load()->size();
+}
+}  // namespace LRUC
@@ -0,0 +1,90 @@
+/**
+ * @author shchang
+ *
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+
+namespace vsdmars {
+
+/**
+ * SpinSharedMutex is a single word reader-writer spin lock meeting the
+ * SharedMutex requirements.
+ *
+ * The word holds the reader count and a writer bit. A writer raises the bit
+ * then waits until readers drained, readers arriving while the bit is raised
+ * back off, thus writers are not starved by a continuous stream of readers.
+ * Waiters yield instead of blocking in the kernel.
+ *
+ * Suited to short critical sections, e.g. guarding a SwissTable shard, where
+ * the uncontended cost of a single atomic RMW matters.
+ *
+ */
+class SpinSharedMutex final {
+private:
+  constexpr static uint32_t WRITER = 1U << 31;
+
+  std::atomic<uint32_t> state_{0};
+
+public:
+  SpinSharedMutex() = default;
+
+  SpinSharedMutex(const SpinSharedMutex &) = delete;
+  SpinSharedMutex &operator=(const SpinSharedMutex &) = delete;
+
+  void lock() {
+    uint32_t state = state_.load(std::memory_order_relaxed);
+    while ((state & WRITER) != 0 ||
+           !state_.compare_exchange_weak(state, state | WRITER,
+                                         std::memory_order_acquire)) {
+      if ((state & WRITER) != 0) {
+        std::this_thread::yield();
+        state = state_.load(std::memory_order_relaxed);
+      }
+    }
+
+    while (state_.load(std::memory_order_acquire) != WRITER) {
+      std::this_thread::yield();
+    }
+  }
+
+  bool try_lock() {
+    uint32_t state = 0;
+    return state_.compare_exchange_strong(state, WRITER,
+                                          std::memory_order_acquire);
+  }
+
+  void unlock() { state_.fetch_and(~WRITER, std::memory_order_release); }
+
+  void lock_shared() {
+    uint32_t state = state_.load(std::memory_order_relaxed);
+    while ((state & WRITER) != 0 ||
+           !state_.compare_exchange_weak(state, state + 1,
+                                         std::memory_order_acquire)) {
+      if ((state & WRITER) != 0) {
+        std::this_thread::yield();
+        state = state_.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  bool try_lock_shared() {
+    uint32_t state = state_.load(std::memory_order_relaxed);
+    while ((state & WRITER) == 0) {
+      if (state_.compare_exchange_weak(state, state + 1,
+                                       std::memory_order_acquire)) {
+        return true;
+      }
+    }
+
+    return false;
+  }
+
+  void unlock_shared() { state_.fetch_sub(1, std::memory_order_release); }
+};
+
+} // namespace vsdmars
@@ -0,0 +1,346 @@
+/**
+ * @author shchang
+ *
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace vsdmars {
+
+/**
+ * SwissGroup matches 16 control bytes of SwissTable at once, with SSE2 or
+ * NEON when the compiler targets them, otherwise scalar.
+ *
+ * A match is a bit mask holding one set bit per matched control byte, the
+ * byte index is ctz(mask) >> Shift.
+ *
+ */
+struct SwissGroup final {
+  constexpr static size_t Width = 16;
+
+  // control byte states, a full slot holds the 7 bits hash tag (h2).
+  constexpr static uint8_t EMPTY = 0x80;
+  constexpr static uint8_t DELETED = 0xFE;
+
+#if defined(__ARM_NEON)
+  // vshrn narrows each byte compare to 4 bits, one bit kept per byte.
+  constexpr static int Shift = 2;
+#else
+  constexpr static int Shift = 0;
+#endif
+
+  using Mask = uint64_t;
+
+  static size_t first(Mask mask) {
+    return static_cast<size_t>(__builtin_ctzll(mask)) >> Shift;
+  }
+
+  // match returns the control bytes equal to h2.
+  static Mask match(const uint8_t *ctrl, uint8_t h2);
+  static Mask matchEmpty(const uint8_t *ctrl) { return match(ctrl, EMPTY); }
+  // EMPTY and DELETED are the only states with the high bit set.
+  static Mask matchEmptyOrDeleted(const uint8_t *ctrl);
+};
+
+#if defined(__SSE2__)
+inline SwissGroup::Mask SwissGroup::match(const uint8_t *ctrl, uint8_t h2) {
+  __m128i group = _mm_loadu_si128(reinterpret_cast<const __m128i *>(ctrl));
+  __m128i eq = _mm_cmpeq_epi8(group, _mm_set1_epi8(static_cast<char>(h2)));
+  return static_cast<uint32_t>(_mm_movemask_epi8(eq));
+}
+
+inline SwissGroup::Mask SwissGroup::matchEmptyOrDeleted(const uint8_t *ctrl) {
+  __m128i group = _mm_loadu_si128(reinterpret_cast<const __m128i *>(ctrl));
+  return static_cast<uint32_t>(_mm_movemask_epi8(group));
+}
+#elif defined(__ARM_NEON)
+inline SwissGroup::Mask SwissGroup::match(const uint8_t *ctrl, uint8_t h2) {
+  uint8x16_t eq = vceqq_u8(vld1q_u8(ctrl), vdupq_n_u8(h2));
+  uint8x8_t narrowed = vshrn_n_u16(vreinterpretq_u16_u8(eq), 4);
+  return vget_lane_u64(vreinterpret_u64_u8(narrowed), 0) &
+         0x8888888888888888ULL;
+}
+
+inline SwissGroup::Mask SwissGroup::matchEmptyOrDeleted(const uint8_t *ctrl) {
+  uint8x16_t high =
+      vcltq_s8(vreinterpretq_s8_u8(vld1q_u8(ctrl)), vdupq_n_s8(0));
+  uint8x8_t narrowed = vshrn_n_u16(vreinterpretq_u16_u8(high), 4);
+  return vget_lane_u64(vreinterpret_u64_u8(narrowed), 0) &
+         0x8888888888888888ULL;
+}
+#else
+inline SwissGroup::Mask SwissGroup::match(const uint8_t *ctrl, uint8_t h2) {
+  Mask mask = 0;
+  for (size_t i = 0; i < Width; i++) {
+    mask |= static_cast<Mask>(ctrl[i] == h2) << i;
+  }
+  return mask;
+}
+
+inline SwissGroup::Mask SwissGroup::matchEmptyOrDeleted(const uint8_t *ctrl) {
+  Mask mask = 0;
+  for (size_t i = 0; i < Width; i++) {
+    mask |= static_cast<Mask>(ctrl[i] >> 7) << i;
+  }
+  return mask;
+}
+#endif
+
+/**
+ * SwissTable is a Swiss-table style open-addressing table of TSlot, not
+ * thread-safe.
+ *
+ * Slots are split into groups of 16, each slot has a control byte holding
+ * EMPTY, DELETED or the 7 bits hash tag of a full slot. Lookup compares the
+ * tag against a whole control group with one SIMD compare, then compares the
+ * slot only on tag match; a group holding an EMPTY byte terminates the probe.
+ * Groups are probed triangularly, a lookup touches one control line and one
+ * slot line in common case.
+ *
+ * The table stores no key nor hash code, callers pass the key's hash code and
+ * an equality predicate of TSlot. Load factor is kept at most 7/8, erase
+ * leaves DELETED behind unless the group holds an EMPTY byte. The table is
+ * sized to hold capacity live slots plus at least capacity / 8 tombstones.
+ * Once the load budget is used up, insert rehashes in place dropping
+ * tombstones, or doubles the table if it holds capacity live slots.
+ *
+ */
+template <typename TSlot> class SwissTable final {
+public:
+  constexpr static size_t NPOS = std::numeric_limits<size_t>::max();
+
+private:
+  std::vector<uint8_t> ctrl_;
+  std::vector<TSlot> slots_;
+  size_t groupMask_;
+  // log2 of group count.
+  int groupBits_;
+  size_t size_;
+  // EMPTY slots insert may still consume, keeps load factor <= 7/8.
+  size_t growthLeft_;
+  // live slots held without doubling.
+  size_t capacity_;
+
+private:
+  static size_t maxLoad(size_t slotCount) { return slotCount - slotCount / 8; }
+  // leaves at least capacity / 8 of the load budget to tombstones.
+  static size_t capacityOf(size_t groupCount) {
+    const size_t load = maxLoad(groupCount * SwissGroup::Width);
+    return load - load / 9;
+  }
+
+  /**
+   * mix spreads the hash code over 64 bits (Fibonacci hashing), the highest 7
+   * bits are the tag and the next groupBits_ bits select the first group.
+   */
+  static uint64_t mix(uint64_t hash) { return hash * 0x9E3779B97F4A7C15ULL; }
+  static uint8_t h2(uint64_t mixed) {
+    return static_cast<uint8_t>(mixed >> 57);
+  }
+  size_t h1(uint64_t mixed) const {
+    return static_cast<size_t>(mixed >> (57 - groupBits_)) & groupMask_;
+  }
+
+  void reset(size_t groupCount);
+
+  /**
+   * findFree returns the first EMPTY or DELETED position of the probe.
+   */
+  size_t findFree(uint64_t mixed) const;
+
+  /**
+   * rehash rebuilds the table with groupCount groups, dropping tombstones.
+   */
+  template <typename THashOf> void rehash(size_t groupCount, THashOf &&hashOf);
+
+public:
+  /**
+   * capacity: live slots held without doubling, at least 16 slots are
+   * allocated.
+   */
+  explicit SwissTable(size_t capacity);
+
+  SwissTable(const SwissTable &) = delete;
+  SwissTable &operator=(const SwissTable &) = delete;
+
+  size_t size() const noexcept { return size_; }
+
+  /**
+   * find returns the position of the slot satisfying eq(const TSlot &),
+   * NPOS if not found.
+   *
+   * find may race with a writer if the caller validates the result, e.g.
+   * with a seqlock: buffers are only reallocated when the table doubles, i.e.
+   * never while it holds at most capacity live slots, and the probe visits
+   * every group at most once.
+   */
+  template <typename TEq> size_t find(uint64_t hash, TEq &&eq) const;
+
+  /**
+   * insert stores slot, caller guarantees its key is absent.
+   * hashOf(const TSlot &) returns the hash code of a stored slot, used if the
+   * table is rehashed. Returns the position of the stored slot.
+   */
+  template <typename THashOf>
+  size_t insert(uint64_t hash, TSlot slot, THashOf &&hashOf);
+
+  /**
+   * erase empties the slot at pos, the slot is reset to TSlot{}.
+   */
+  void erase(size_t pos);
+
+  TSlot &slot(size_t pos) { return slots_[pos]; }
+  const TSlot &slot(size_t pos) const { return slots_[pos]; }
+
+  void clear();
+};
+
+template <typename TSlot>
+SwissTable<TSlot>::SwissTable(size_t capacity)
+    : ctrl_(), slots_(), groupMask_(0), groupBits_(0), size_(0),
+      growthLeft_(0), capacity_(0) {
+  size_t groupCount = 1;
+  while (capacityOf(groupCount) < capacity) {
+    groupCount <<= 1;
+  }
+
+  reset(groupCount);
+}
+
+template <typename TSlot> void SwissTable<TSlot>::reset(size_t groupCount) {
+  ctrl_.assign(groupCount * SwissGroup::Width, SwissGroup::EMPTY);
+  slots_.clear();
+  slots_.resize(groupCount * SwissGroup::Width);
+  groupMask_ = groupCount - 1;
+  groupBits_ = __builtin_ctzll(groupCount);
+  size_ = 0;
+  growthLeft_ = maxLoad(slots_.size());
+  capacity_ = capacityOf(groupCount);
+}
+
+template <typename TSlot>
+template <typename TEq>
+size_t SwissTable<TSlot>::find(uint64_t hash, TEq &&eq) const {
+  const uint64_t mixed = mix(hash);
+  const uint8_t tag = h2(mixed);
+
+  // load factor <= 7/8 guarantees a group holding EMPTY terminates the probe.
+  for (size_t g = h1(mixed), step = 1; step <= groupMask_ + 1;
+       g = (g + step++) & groupMask_) {
+    const uint8_t *ctrl = &ctrl_[g * SwissGroup::Width];
+
+    for (auto mask = SwissGroup::match(ctrl, tag); mask; mask &= mask - 1) {
+      size_t pos = g * SwissGroup::Width + SwissGroup::first(mask);
+      if (eq(slots_[pos])) {
+        return pos;
+      }
+    }
+
+    if (SwissGroup::matchEmpty(ctrl)) {
+      return NPOS;
+    }
+  }
+
+  return NPOS;
+}
+
+template <typename TSlot>
+size_t SwissTable<TSlot>::findFree(uint64_t mixed) const {
+  for (size_t g = h1(mixed), step = 1;; g = (g + step++) & groupMask_) {
+    const uint8_t *ctrl = &ctrl_[g * SwissGroup::Width];
+
+    if (auto mask = SwissGroup::matchEmptyOrDeleted(ctrl)) {
+      return g * SwissGroup::Width + SwissGroup::first(mask);
+    }
+  }
+}
+
+template <typename TSlot>
+template <typename THashOf>
+void SwissTable<TSlot>::rehash(size_t groupCount, THashOf &&hashOf) {
+  std::vector<TSlot> live;
+  live.reserve(size_);
+  for (size_t pos = 0; pos < ctrl_.size(); pos++) {
+    if ((ctrl_[pos] & 0x80) == 0) {
+      live.push_back(std::move(slots_[pos]));
+    }
+  }
+
+  // same size rehash keeps the buffers, see find.
+  if (groupCount == groupMask_ + 1) {
+    clear();
+  } else {
+    reset(groupCount);
+  }
+
+  for (auto &slot : live) {
+    const uint64_t mixed = mix(hashOf(slot));
+    size_t free = findFree(mixed);
+
+    ctrl_[free] = h2(mixed);
+    slots_[free] = std::move(slot);
+    size_++;
+    growthLeft_--;
+  }
+}
+
+template <typename TSlot>
+template <typename THashOf>
+size_t SwissTable<TSlot>::insert(uint64_t hash, TSlot slot, THashOf &&hashOf) {
+  const uint64_t mixed = mix(hash);
+  size_t pos = findFree(mixed);
+
+  // reusing DELETED doesn't consume the load budget.
+  if (ctrl_[pos] == SwissGroup::EMPTY && growthLeft_ == 0) {
+    const size_t groupCount = groupMask_ + 1;
+    rehash(size_ >= capacity_ ? groupCount * 2 : groupCount, hashOf);
+    pos = findFree(mixed);
+  }
+
+  if (ctrl_[pos] == SwissGroup::EMPTY) {
+    growthLeft_--;
+  }
+
+  ctrl_[pos] = h2(mixed);
+  slots_[pos] = std::move(slot);
+  size_++;
+
+  return pos;
+}
+
+template <typename TSlot> void SwissTable<TSlot>::erase(size_t pos) {
+  const size_t group = pos & ~(SwissGroup::Width - 1);
+
+  // groups are probed whole, a group holding EMPTY already terminates every
+  // probe passing through it.
+  if (SwissGroup::matchEmpty(&ctrl_[group])) {
+    ctrl_[pos] = SwissGroup::EMPTY;
+    growthLeft_++;
+  } else {
+    ctrl_[pos] = SwissGroup::DELETED;
+  }
+
+  slots_[pos] = TSlot{};
+  size_--;
+}
+
+template <typename TSlot> void SwissTable<TSlot>::clear() {
+  std::fill(ctrl_.begin(), ctrl_.end(), SwissGroup::EMPTY);
+  std::fill(slots_.begin(), slots_.end(), TSlot{});
+  size_ = 0;
+  growthLeft_ = maxLoad(slots_.size());
+}
+
+} // namespace vsdmars
@@ -24,3 +24,9 @@ AtsPluginUtils::IPTimeEntityCache& get_ip_time_entity_cache() {
 
   return cache;
 }
+
+AtsPluginUtils::IPTimeEntitySnapshot& get_ip_time_entity_snapshot() {
+  static AtsPluginUtils::IPTimeEntitySnapshot snapshot;
+
+  return snapshot;
+}
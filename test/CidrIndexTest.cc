@@ -0,0 +1,205 @@
+/**
+ * Unit Test for CidrIndex with type:
+ *
+ * key type: Cidr
+ * value type: CacheValue<CACHE_VALUE_TYPE::TIME_ENTITY_LOOKUP_INFO>>
+ */
+
+#include "lrucache_common.h"
+
+using namespace testing;
+
+namespace {
+
+/**
+ * entries parses "block" / expiryTs pairs into sorted IPCidrIndex::Entries.
+ */
+IPCidrIndex::Entries entries(const std::vector<std::pair<std::string, int>>& blocks) {
+  IPCidrIndex::Entries result;
+  for (const auto& [text, expiryTs] : blocks) {
+    LRUC::Cidr cidr;
+    EXPECT_TRUE(LRUC::Cidr::parse(text, &cidr)) << text;
+    result.emplace_back(cidr, create_cache_value(expiryTs));
+  }
+  std::sort(result.begin(), result.end(), [](const auto& lhs, const auto& rhs) { return lhs.first < rhs.first; });
+  return result;
+}
+
+/**
+ * expiryOf returns the expiryTs found for address text, -1 if none.
+ */
+int64_t expiryOf(const IPCidrIndex& index, std::string_view text) {
+  const auto* value = index.find(text);
+  return value != nullptr ? value->expiryTs : -1;
+}
+
+}  // namespace
+
+/**
+ * Cidr::parse accepts "address/prefixLen" and single addresses.
+ */
+TEST(CidrIndexTest, ParseCidr) {
+  LRUC::Cidr cidr;
+  ASSERT_TRUE(LRUC::Cidr::parse("10.0.0.0/8", &cidr));
+  EXPECT_EQ(AF_INET, cidr.address.base.sa_family);
+  EXPECT_EQ(8, cidr.prefixLen);
+  ASSERT_TRUE(LRUC::Cidr::parse("2001:db8::/32", &cidr));
+  EXPECT_EQ(AF_INET6, cidr.address.base.sa_family);
+  EXPECT_EQ(32, cidr.prefixLen);
+  ASSERT_TRUE(LRUC::Cidr::parse("1.2.3.4", &cidr));
+  EXPECT_EQ(32, cidr.prefixLen);
+  ASSERT_TRUE(LRUC::Cidr::parse("::1", &cidr));
+  EXPECT_EQ(128, cidr.prefixLen);
+  ASSERT_TRUE(LRUC::Cidr::parse("0.0.0.0/0", &cidr));
+  EXPECT_EQ(0, cidr.prefixLen);
+
+  for (const char* text : {"10.0.0.0/33", "::/129", "10.0.0.0/", "10.0.0.0/08", "10.0.0.0/8/8", "10.0.0/8", "/8",
+                           "10.0.0.0/a", ""}) {
+    EXPECT_FALSE(LRUC::Cidr::parse(text, &cidr)) << text;
+  }
+}
+
+/**
+ * IPv4 lookups return the longest block, across the /24 boundary of DIR-24-8.
+ */
+TEST(CidrIndexTest, LongestPrefixMatchV4) {
+  const IPCidrIndex index{entries({{"10.0.0.0/8", 8},
+                                   {"10.1.0.0/16", 16},
+                                   {"10.1.2.0/24", 24},
+                                   {"10.1.2.128/25", 25},
+                                   {"10.1.2.129/32", 32},
+                                   {"192.168.0.0/30", 30}})};
+  EXPECT_EQ(6, index.size());
+
+  EXPECT_EQ(8, expiryOf(index, "10.255.255.255"));
+  EXPECT_EQ(16, expiryOf(index, "10.1.255.1"));
+  EXPECT_EQ(24, expiryOf(index, "10.1.2.127"));
+  EXPECT_EQ(25, expiryOf(index, "10.1.2.128"));
+  EXPECT_EQ(32, expiryOf(index, "10.1.2.129"));
+  EXPECT_EQ(25, expiryOf(index, "10.1.2.255"));
+  EXPECT_EQ(30, expiryOf(index, "192.168.0.3"));
+  EXPECT_EQ(-1, expiryOf(index, "192.168.0.4"));
+  EXPECT_EQ(-1, expiryOf(index, "11.0.0.0"));
+  EXPECT_EQ(-1, expiryOf(index, "::ffff:10.1.2.129"));
+  EXPECT_EQ(-1, expiryOf(index, "not an address"));
+
+  const auto ip = create_IpAddress("10.1.2.129");
+  ASSERT_NE(nullptr, index.find(ip));
+  EXPECT_EQ(32, index.find(&ip.base)->expiryTs);
+
+  const IPCidrIndex all{entries({{"0.0.0.0/0", 0}})};
+  EXPECT_EQ(0, expiryOf(all, "255.255.255.255"));
+  EXPECT_EQ(-1, expiryOf(all, "::"));
+}
+
+/**
+ * IPv6 lookups return the longest block, through branching points and nested blocks.
+ */
+TEST(CidrIndexTest, LongestPrefixMatchV6) {
+  const IPCidrIndex index{entries({{"2001:db8::/32", 32},
+                                   {"2001:db8:1::/48", 48},
+                                   {"2001:db8:1:2::/64", 64},
+                                   {"2001:db8:1:2::1/128", 128},
+                                   {"2001:db8:1:3::/64", 63},
+                                   {"2001:db9::/32", 31},
+                                   {"fe80::/10", 10}})};
+
+  EXPECT_EQ(32, expiryOf(index, "2001:db8:ffff::1"));
+  EXPECT_EQ(48, expiryOf(index, "2001:db8:1:ffff::1"));
+  EXPECT_EQ(64, expiryOf(index, "2001:db8:1:2::2"));
+  EXPECT_EQ(128, expiryOf(index, "2001:db8:1:2::1"));
+  EXPECT_EQ(63, expiryOf(index, "2001:db8:1:3:ffff::"));
+  EXPECT_EQ(31, expiryOf(index, "2001:db9:1::"));
+  EXPECT_EQ(10, expiryOf(index, "febf::1"));
+  EXPECT_EQ(-1, expiryOf(index, "fec0::1"));
+  EXPECT_EQ(-1, expiryOf(index, "2001:dba::"));
+  EXPECT_EQ(-1, expiryOf(index, "10.1.2.3"));
+
+  const IPCidrIndex all{entries({{"::/0", 0}, {"::1", 1}})};
+  EXPECT_EQ(0, expiryOf(all, "ffff::"));
+  EXPECT_EQ(1, expiryOf(all, "::1"));
+}
+
+/**
+ * CidrIndex agrees with a linear longest prefix match over random nested blocks of both families.
+ */
+TEST(CidrIndexTest, MatchesLinearScan) {
+  std::mt19937_64 gen{42};
+  // few distinct high bits, blocks nest and share branching points.
+  auto randomAddress = [&gen](int family) {
+    struct sockaddr_in6 storage {};
+    if (family == AF_INET) {
+      auto* addr = reinterpret_cast<struct sockaddr_in*>(&storage);
+      addr->sin_family = AF_INET;
+      addr->sin_addr.s_addr = htonl(static_cast<uint32_t>((gen() % 4) << 30 | (gen() % 8) << 20 | (gen() & 0xFFFFF)));
+    } else {
+      storage.sin6_family = AF_INET6;
+      const uint64_t words[2] = {__builtin_bswap64((gen() % 4) << 60 | (gen() % 8) << 40 | (gen() & 0xFFFF)), gen()};
+      memcpy(storage.sin6_addr.s6_addr, words, sizeof(words));
+    }
+    return IpAddress{reinterpret_cast<const struct sockaddr*>(&storage)};
+  };
+
+  auto inBlock = [](const IpAddress& ip, const LRUC::Cidr& cidr) {
+    if (ip.base.sa_family != cidr.address.base.sa_family) {
+      return false;
+    }
+    const auto* lhs = ip.base.sa_family == AF_INET ? reinterpret_cast<const uint8_t*>(&ip.v4.sin_addr)
+                                                   : ip.v6.sin6_addr.s6_addr;
+    const auto* rhs = ip.base.sa_family == AF_INET ? reinterpret_cast<const uint8_t*>(&cidr.address.v4.sin_addr)
+                                                   : cidr.address.v6.sin6_addr.s6_addr;
+    for (int i = 0; i < cidr.prefixLen; i++) {
+      if (((lhs[i / 8] ^ rhs[i / 8]) >> (7 - i % 8) & 1) != 0) {
+        return false;
+      }
+    }
+    return true;
+  };
+
+  IPCidrIndex::Entries blocks;
+  for (int i = 0; i < 2000; i++) {
+    const int family = i % 2 == 0 ? AF_INET : AF_INET6;
+    LRUC::Cidr cidr;
+    cidr.address = randomAddress(family);
+    cidr.prefixLen = static_cast<uint8_t>(gen() % (family == AF_INET ? 33 : 129));
+    blocks.emplace_back(cidr, create_cache_value(i));
+  }
+  std::sort(blocks.begin(), blocks.end(), [](const auto& lhs, const auto& rhs) { return lhs.first < rhs.first; });
+  const IPCidrIndex index{blocks};
+
+  for (int i = 0; i < 10000; i++) {
+    const auto ip = randomAddress(i % 2 == 0 ? AF_INET : AF_INET6);
+    // the longest block, the last of equal blocks.
+    const CacheValue<CACHE_VALUE_TYPE::TIME_ENTITY_LOOKUP_INFO>* expected = nullptr;
+    int expectedLen = -1;
+    for (const auto& [cidr, value] : blocks) {
+      if (cidr.prefixLen >= expectedLen && inBlock(ip, cidr)) {
+        expected = &value;
+        expectedLen = cidr.prefixLen;
+      }
+    }
+
+    const auto* found = index.find(ip);
+    ASSERT_EQ(expected == nullptr, found == nullptr) << ip.toString();
+    if (expected != nullptr) {
+      ASSERT_EQ(expected->expiryTs, found->expiryTs) << ip.toString();
+    }
+  }
+}
+
+/**
+ * CidrIndex rejects unsorted entries and prefix lengths above the family's.
+ */
+TEST(CidrIndexTest, InvalidEntries) {
+  auto unsorted = entries({{"10.0.0.0/8", 8}, {"2001:db8::/32", 32}});
+  std::swap(unsorted[0], unsorted[1]);
+  EXPECT_THROW(IPCidrIndex{unsorted}, std::invalid_argument);
+
+  auto tooLong = entries({{"10.0.0.0/8", 8}});
+  tooLong[0].first.prefixLen = 33;
+  EXPECT_THROW(IPCidrIndex{tooLong}, std::invalid_argument);
+
+  const IPCidrIndex empty{};
+  EXPECT_EQ(nullptr, empty.find("10.0.0.1"));
+  EXPECT_EQ(nullptr, empty.find("::1"));
+}
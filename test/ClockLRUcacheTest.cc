@@ -356,3 +356,397 @@ TEST(ClockLRUCacheTest_Same_Key, ConcurrentInsertAndPop) {
 
   ASSERT_EQ(1, lruc.size()) << "cache.size() is not 1";
 }
+
+/**
+ * Test erased slot is reused by the next insert without evicting live keys.
+ */
+TEST(ClockLRUCacheTest_Erase, FreeSlotReused) {
+  auto key1 = create_IpAddress("192.168.1.1");
+  auto key2 = create_IpAddress("192.168.1.2");
+  auto key3 = create_IpAddress("192.168.1.3");
+  auto value = create_cache_value(42);
+
+  IPClockLRUCache lruc{2};
+  lruc.insert(key1, value);
+  lruc.insert(key2, value);
+  ASSERT_EQ(2, lruc.size()) << "cache.size() is not 2";
+
+  EXPECT_EQ(1, lruc.erase(key1));
+  EXPECT_EQ(0, lruc.erase(key1));
+
+  // key3 takes the erased slot, key2 stays.
+  lruc.insert(key3, value);
+  EXPECT_TRUE(lruc.find(key2).has_value()) << "live key evicted while free slot available";
+  EXPECT_TRUE(lruc.find(key3).has_value());
+  EXPECT_FALSE(lruc.find(key1).has_value());
+  ASSERT_EQ(2, lruc.size()) << "cache.size() is not 2";
+
+  // re-inserted key1 must survive eviction of the slot it was erased from.
+  lruc.insert(key1, value);
+  lruc.insert(key2, value);
+  EXPECT_TRUE(lruc.find(key1).has_value()) << "re-inserted key removed by stale slot eviction";
+  ASSERT_EQ(2, lruc.size()) << "cache.size() is not 2";
+
+  // clear resets all slots, cache refills without evicting.
+  lruc.clear();
+  ASSERT_EQ(0, lruc.size()) << "cache.size() is not 0";
+  lruc.insert(key1, value);
+  lruc.insert(key2, value);
+  EXPECT_TRUE(lruc.find(key1).has_value());
+  EXPECT_TRUE(lruc.find(key2).has_value());
+  ASSERT_EQ(2, lruc.size()) << "cache.size() is not 2";
+}
+
+/**
+ * visit reads the stored value in place.
+ */
+TEST_F(ClockLRUCacheTest, TestVisit) {
+  visitJob(lruc, EXPIRYTS);
+}
+
+/**
+ * CollidingHash maps keys to 4 hash codes, building long probe runs in the slot index.
+ */
+struct CollidingHash {
+  size_t operator()(int key) const noexcept { return static_cast<size_t>(key % 4); }
+};
+
+/**
+ * Slot index stays consistent under colliding insert/erase, checked against std::unordered_set.
+ */
+TEST(ClockLRUCacheTest_Index, CollidingInsertErase) {
+  constexpr int LRUC_SIZE = 64;
+  LRUC::LRUClockCache<int, int, CollidingHash> lruc{LRUC_SIZE};
+  std::unordered_set<int> expected;
+
+  std::mt19937 gen{42};
+  std::uniform_int_distribution<> pickKey{0, LRUC_SIZE - 1};
+
+  // key space equals capacity, nothing is evicted.
+  for (int i = 0; i < 10'000; i++) {
+    int key = pickKey(gen);
+    if (gen() % 2) {
+      EXPECT_EQ(expected.insert(key).second, lruc.insert(key, key));
+    } else {
+      EXPECT_EQ(expected.erase(key), lruc.erase(key));
+    }
+  }
+
+  ASSERT_EQ(expected.size(), lruc.size());
+  for (int key = 0; key < LRUC_SIZE; key++) {
+    auto found = lruc.find(key);
+    EXPECT_EQ(expected.count(key), found.has_value()) << "key [" << key << "]";
+    if (found) {
+      EXPECT_EQ(key, *found);
+    }
+  }
+
+  // key space exceeds capacity, every evicted key leaves the index.
+  for (int key = 0; key < LRUC_SIZE * 4; key++) {
+    lruc.insert(key, key);
+  }
+
+  size_t foundCnt = 0;
+  for (int key = 0; key < LRUC_SIZE * 4; key++) {
+    foundCnt += lruc.find(key).has_value();
+  }
+  ASSERT_EQ(LRUC_SIZE, lruc.size());
+  ASSERT_EQ(LRUC_SIZE, foundCnt);
+}
+
+/**
+ * Slot index stays consistent while erased keys leave tombstones behind and force in-place rehash,
+ * checked against std::unordered_set.
+ */
+TEST(ClockLRUCacheTest_Index, TombstoneChurn) {
+  constexpr int LRUC_SIZE = 200;
+  LRUC::LRUClockCache<int, int> lruc{LRUC_SIZE};
+  std::unordered_set<int> expected;
+
+  std::mt19937 gen{42};
+  std::uniform_int_distribution<> pickKey{0, 100'000};
+
+  // keys are mostly fresh, below capacity nothing is evicted.
+  for (int i = 0; i < 200'000; i++) {
+    int key = pickKey(gen);
+    if (expected.size() < LRUC_SIZE && gen() % 2) {
+      EXPECT_EQ(expected.insert(key).second, lruc.insert(key, key));
+    } else if (!expected.empty()) {
+      int erased = *expected.begin();
+      expected.erase(erased);
+      EXPECT_EQ(1, lruc.erase(erased));
+    }
+  }
+
+  ASSERT_EQ(expected.size(), lruc.size());
+  for (int key : expected) {
+    auto found = lruc.find(key);
+    ASSERT_TRUE(found.has_value()) << "key [" << key << "]";
+    EXPECT_EQ(key, *found);
+  }
+}
+
+/**
+ * gclockHotKey checks that a key found after every insert is never evicted
+ * while cold keys stream through the cache, and that every evicted key leaves the index.
+ */
+template <size_t CounterBits>
+void gclockHotKey() {
+  // spans several counter words, including a partial one.
+  constexpr int LRUC_SIZE = 1'000;
+  constexpr int HOT_KEY = -1;
+  LRUC::LRUClockCache<int, int, std::hash<int>, std::equal_to<int>, CounterBits> lruc{LRUC_SIZE};
+
+  lruc.insert(HOT_KEY, HOT_KEY);
+  for (int key = 0; key < LRUC_SIZE * 20; key++) {
+    lruc.insert(key, key);
+    ASSERT_TRUE(lruc.find(HOT_KEY).has_value()) << "hot key evicted, CounterBits [" << CounterBits << "]";
+  }
+
+  size_t foundCnt = 0;
+  for (int key = 0; key < LRUC_SIZE * 20; key++) {
+    foundCnt += lruc.find(key).has_value();
+  }
+  ASSERT_EQ(LRUC_SIZE, lruc.size());
+  ASSERT_EQ(LRUC_SIZE - 1, foundCnt);
+}
+
+/**
+ * GCLOCK counters of every supported width keep hot keys.
+ */
+TEST(ClockLRUCacheTest_GClock, HotKeySurvives) {
+  gclockHotKey<1>();
+  gclockHotKey<2>();
+  gclockHotKey<3>();
+  gclockHotKey<4>();
+}
+
+/**
+ * Saturated counters bound the sweep, every slot referenced still evicts.
+ */
+TEST(ClockLRUCacheTest_GClock, AllReferenced) {
+  constexpr int LRUC_SIZE = 300;
+  LRUC::LRUClockCache<int, int, std::hash<int>, std::equal_to<int>, 4> lruc{LRUC_SIZE};
+
+  for (int key = 0; key < LRUC_SIZE; key++) {
+    lruc.insert(key, key);
+  }
+
+  // saturate every counter.
+  for (int round = 0; round < 20; round++) {
+    for (int key = 0; key < LRUC_SIZE; key++) {
+      lruc.find(key);
+    }
+  }
+
+  EXPECT_TRUE(lruc.insert(LRUC_SIZE, LRUC_SIZE));
+  EXPECT_TRUE(lruc.find(LRUC_SIZE).has_value());
+  ASSERT_EQ(LRUC_SIZE, lruc.size());
+}
+
+/**
+ * DistributedSharedMutex excludes readers from writers and writers from each other.
+ */
+TEST(ClockLRUCacheTest_DistributedMutex, Exclusion) {
+  constexpr int THREAD_CNT = 8;
+  constexpr int LOOP_CNT = 20'000;
+  LRUC::DistributedSharedMutex mutex;
+  // written by writers only, readers expect both halves equal.
+  long long first = 0;
+  long long second = 0;
+  std::atomic<int> torn{0};
+
+  std::vector<std::thread> threads;
+  for (int t = 0; t < THREAD_CNT; t++) {
+    threads.emplace_back([&, t] {
+      for (int i = 0; i < LOOP_CNT; i++) {
+        if (i % 16 == t % 2) {
+          std::unique_lock lock(mutex);
+          first++;
+          second++;
+        } else {
+          std::shared_lock lock(mutex);
+          torn += first != second;
+        }
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  EXPECT_EQ(0, torn);
+  EXPECT_EQ(first, second);
+  EXPECT_EQ(THREAD_CNT * LOOP_CNT / 16, first);
+
+  EXPECT_TRUE(mutex.try_lock());
+  EXPECT_FALSE(mutex.try_lock_shared());
+  mutex.unlock();
+  EXPECT_TRUE(mutex.try_lock_shared());
+  EXPECT_FALSE(mutex.try_lock());
+  mutex.unlock_shared();
+}
+
+/**
+ * LRUClockCache guarded by DistributedSharedMutex under concurrent insert/find/erase.
+ */
+TEST(ClockLRUCacheTest_DistributedMutex, ConcurrentInsertEraseFind) {
+  constexpr int LRUC_SIZE = 255;
+  constexpr int KEY_CNT = LRUC_SIZE * 4;
+  LRUC::LRUClockCache<int, int, std::hash<int>, std::equal_to<int>, 2, LRUC::DistributedSharedMutex> lruc{LRUC_SIZE};
+
+  std::vector<int> data(KEY_CNT * 8);
+  std::iota(data.begin(), data.end(), 0);
+
+  tbb::parallel_for_each(data, [&lruc](int i) {
+    int key = i % KEY_CNT;
+    lruc.insert(key, key);
+    if (auto found = lruc.find(key); found) {
+      EXPECT_EQ(key, *found);
+    }
+    if (i % 3 == 0) {
+      lruc.erase(key);
+    }
+  });
+
+  size_t foundCnt = 0;
+  for (int key = 0; key < KEY_CNT; key++) {
+    foundCnt += lruc.find(key).has_value();
+  }
+  EXPECT_GE(LRUC_SIZE, lruc.size());
+  EXPECT_EQ(lruc.size(), foundCnt);
+}
+
+/**
+ * OptimisticRead is selected for bitwise copyable key and value of at most 2 cache lines.
+ */
+TEST(ClockLRUCacheTest_Optimistic, Selection) {
+  EXPECT_TRUE((LRUC::LRUClockCache<int, int>::OptimisticRead));
+  EXPECT_TRUE(IPClockLRUCache::OptimisticRead);
+  EXPECT_TRUE((LRUC::LRUClockCache<PackedIpKey, CacheValue<CACHE_VALUE_TYPE::TIME_ENTITY_LOOKUP_INFO>>::OptimisticRead));
+  EXPECT_FALSE((LRUC::LRUClockCache<int, std::string>::OptimisticRead));
+  EXPECT_FALSE((LRUC::LRUClockCache<int, std::array<char, 256>>::OptimisticRead));
+}
+
+/**
+ * Optimistic find never returns a torn value while writers overwrite slots.
+ */
+TEST(ClockLRUCacheTest_Optimistic, NoTornRead) {
+  // every word holds key * GEN_CNT + generation, a torn copy mixes generations.
+  using Value = std::array<uint64_t, 8>;
+  constexpr int LRUC_SIZE = 64;
+  constexpr int KEY_CNT = LRUC_SIZE * 2;
+  constexpr int GEN_CNT = 1'000;
+  constexpr int THREAD_CNT = 4;
+  LRUC::LRUClockCache<int, Value> lruc{LRUC_SIZE};
+
+  auto makeValue = [](int key, int gen) {
+    Value value;
+    value.fill(static_cast<uint64_t>(key) * GEN_CNT + static_cast<uint64_t>(gen));
+    return value;
+  };
+
+  std::atomic<int> torn{0};
+  std::vector<std::thread> threads;
+  for (int t = 0; t < THREAD_CNT; t++) {
+    threads.emplace_back([&, t] {
+      for (int gen = 0; gen < GEN_CNT; gen++) {
+        for (int key = t % 2; key < KEY_CNT; key += 2) {
+          if (t < THREAD_CNT / 2) {
+            lruc.erase(key);
+            lruc.insert(key, makeValue(key, gen));
+          } else if (auto found = lruc.find(key); found) {
+            const Value& value = *found;
+            torn += std::any_of(value.begin(), value.end(), [&value](uint64_t w) { return w != value[0]; }) ||
+                    static_cast<int>(value[0] / GEN_CNT) != key;
+          }
+        }
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  EXPECT_EQ(0, torn);
+  EXPECT_GE(LRUC_SIZE, lruc.size());
+}
+
+/**
+ * Optimistic hits touch GCLOCK counters while insert() evicts, a key found after every insert survives the stream.
+ */
+TEST(ClockLRUCacheTest_Optimistic, TouchWhileEvicting) {
+  constexpr int LRUC_SIZE = 1'000;
+  constexpr int HOT_CNT = 8;
+  constexpr int COLD_CNT = LRUC_SIZE * 20;
+  LRUC::LRUClockCache<int, int> lruc{LRUC_SIZE};
+
+  for (int key = 0; key < HOT_CNT; key++) {
+    lruc.insert(-1 - key, key);
+  }
+
+  std::atomic<bool> stop{false};
+  std::atomic<int> wrong{0};
+  std::thread reader([&] {
+    while (!stop) {
+      for (int key = 0; key < HOT_CNT; key++) {
+        if (auto found = lruc.find(-1 - key); found) {
+          wrong += *found != key;
+        }
+      }
+    }
+  });
+
+  int hotMissed = 0;
+  for (int key = 0; key < COLD_CNT; key++) {
+    lruc.insert(key, key);
+    // touched by this thread too, a concurrent touch never undoes it.
+    hotMissed += !lruc.find(-1).has_value();
+  }
+  stop = true;
+  reader.join();
+
+  EXPECT_EQ(0, wrong);
+  EXPECT_EQ(0, hotMissed);
+  EXPECT_EQ(LRUC_SIZE, lruc.size());
+}
+
+/**
+ * Optimistic find of key 0 (TKey{}) never hits a slot erase() reset to TKey{} / TValue{} through a stale index entry.
+ */
+TEST(ClockLRUCacheTest_Optimistic, EraseResetSlot) {
+  constexpr int LRUC_SIZE = 64;
+  constexpr int VALUE = 42;
+  constexpr int ROUND_CNT = 20'000;
+  LRUC::LRUClockCache<int, int, CollidingHash> lruc{LRUC_SIZE};
+
+  // key 0 probed after the colliding keys' entries.
+  for (int key = 4; key < LRUC_SIZE; key += 4) {
+    lruc.insert(key, key);
+  }
+  ASSERT_TRUE(lruc.insert(0, VALUE));
+
+  std::atomic<bool> stop{false};
+  std::atomic<int> wrong{0};
+  std::thread reader([&] {
+    while (!stop) {
+      auto found = lruc.find(0);
+      wrong += !found || *found != VALUE;
+    }
+  });
+
+  // keys colliding with key 0, erased slots are reset to key 0 and value 0.
+  for (int round = 0; round < ROUND_CNT; round++) {
+    for (int key = 4; key < LRUC_SIZE; key += 4) {
+      lruc.erase(key);
+    }
+    for (int key = 4; key < LRUC_SIZE; key += 4) {
+      lruc.insert(key, key);
+    }
+  }
+  stop = true;
+  reader.join();
+
+  EXPECT_EQ(0, wrong);
+  EXPECT_EQ(LRUC_SIZE / 4, lruc.size());
+}
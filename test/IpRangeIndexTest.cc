@@ -0,0 +1,155 @@
+/**
+ * Unit Test for IpRangeIndex with type:
+ *
+ * key type: IPv4 range
+ * value type: CacheValue<CACHE_VALUE_TYPE::TIME_ENTITY_LOOKUP_INFO>>
+ */
+
+#include "lrucache_common.h"
+
+#include <cstdio>
+#include <unistd.h>
+
+using namespace testing;
+
+namespace {
+
+using Record = IPRangeIndex::Record;
+
+/**
+ * randomRanges returns count sorted disjoint ranges, gaps and lengths of 1 to 2^16 addresses.
+ */
+std::vector<Record> randomRanges(size_t count, uint64_t seed) {
+  std::mt19937_64 gen{seed};
+  std::vector<Record> ranges;
+  uint64_t next = gen() % 4;
+  for (size_t i = 0; i < count && next <= 0xFFFFFFFFULL; i++) {
+    const uint64_t first = next;
+    const uint64_t last = std::min<uint64_t>(first + gen() % 65536, 0xFFFFFFFFULL);
+    ranges.push_back(Record{static_cast<uint32_t>(first), static_cast<uint32_t>(last),
+                            create_cache_value(static_cast<int64_t>(i))});
+    next = last + 1 + gen() % 65536;
+  }
+  return ranges;
+}
+
+/**
+ * expected returns the range holding ip with a binary search, nullptr if none does.
+ */
+const Record* expected(const std::vector<Record>& ranges, uint32_t ip) {
+  auto it = std::upper_bound(ranges.begin(), ranges.end(), ip,
+                             [](uint32_t value, const Record& range) { return value < range.first; });
+  if (it == ranges.begin() || ip > std::prev(it)->last) {
+    return nullptr;
+  }
+  return &*std::prev(it);
+}
+
+}  // namespace
+
+/**
+ * IpRangeIndex finds the range holding an address as a binary search does, for any range count.
+ */
+TEST(IpRangeIndexTest, MatchesBinarySearch) {
+  std::mt19937_64 gen{42};
+  for (size_t count : {size_t{0}, size_t{1}, size_t{2}, size_t{7}, size_t{8}, size_t{15}, size_t{16}, size_t{1000},
+                       size_t{4097}}) {
+    const auto ranges = randomRanges(count, count);
+    const IPRangeIndex index{ranges};
+    ASSERT_EQ(ranges.size(), index.size());
+
+    std::vector<uint32_t> probes{0, 0xFFFFFFFFU};
+    for (const auto& range : ranges) {
+      probes.insert(probes.end(), {range.first, range.last, range.first - 1, range.last + 1});
+    }
+    for (int i = 0; i < 1000; i++) {
+      probes.push_back(static_cast<uint32_t>(gen() % (ranges.empty() ? 1 : ranges.back().last + 2)));
+    }
+
+    for (uint32_t ip : probes) {
+      const Record* range = expected(ranges, ip);
+      const auto* found = index.find(ip);
+      ASSERT_EQ(range == nullptr, found == nullptr) << count << " " << ip;
+      if (range != nullptr) {
+        ASSERT_EQ(range->value.expiryTs, found->expiryTs) << count << " " << ip;
+      }
+    }
+  }
+}
+
+/**
+ * IpRangeIndex looks up IpAddress, sockaddr and address text in network byte order, IPv6 never matches.
+ */
+TEST(IpRangeIndexTest, Addresses) {
+  const IPRangeIndex index{std::vector<Record>{{0x0A000000, 0x0AFFFFFF, create_cache_value(10)},
+                                               {0xC0A80100, 0xC0A801FF, create_cache_value(192)},
+                                               {0xFFFFFFFF, 0xFFFFFFFF, create_cache_value(255)}}};
+
+  ASSERT_NE(nullptr, index.find("10.1.2.3"));
+  EXPECT_EQ(10, index.find("10.1.2.3")->expiryTs);
+  const auto ip = create_IpAddress("192.168.1.255");
+  ASSERT_NE(nullptr, index.find(ip));
+  EXPECT_EQ(192, index.find(&ip.base)->expiryTs);
+  EXPECT_EQ(255, index.find("255.255.255.255")->expiryTs);
+  EXPECT_EQ(nullptr, index.find("192.168.2.0"));
+  EXPECT_EQ(nullptr, index.find("::ffff:10.1.2.3"));
+  EXPECT_EQ(nullptr, index.find("not an address"));
+}
+
+/**
+ * IpRangeIndex rejects overlapping, unsorted and reversed ranges.
+ */
+TEST(IpRangeIndexTest, InvalidRanges) {
+  EXPECT_THROW(IPRangeIndex(std::vector<Record>{{10, 20, {}}, {20, 30, {}}}), std::invalid_argument);
+  EXPECT_THROW(IPRangeIndex(std::vector<Record>{{30, 40, {}}, {10, 20, {}}}), std::invalid_argument);
+  EXPECT_THROW(IPRangeIndex(std::vector<Record>{{20, 10, {}}}), std::invalid_argument);
+  EXPECT_EQ(nullptr, IPRangeIndex{}.find(0U));
+}
+
+/**
+ * IpRangeIndex loads the ranges a save() file holds, rejects other files.
+ */
+TEST(IpRangeIndexTest, SaveLoad) {
+  char path[] = "/tmp/ip_range_index_XXXXXX";
+  const int fd = mkstemp(path);
+  ASSERT_GE(fd, 0);
+  close(fd);
+
+  const auto ranges = randomRanges(10000, 7);
+  ASSERT_TRUE(IPRangeIndex::save(path, ranges));
+  const auto index = IPRangeIndex::load(path);
+  ASSERT_EQ(ranges.size(), index.size());
+  for (const auto& range : ranges) {
+    ASSERT_NE(nullptr, index.find(range.last));
+    ASSERT_EQ(range.value.expiryTs, index.find(range.last)->expiryTs);
+  }
+
+  // truncated file.
+  ASSERT_EQ(0, truncate(path, sizeof(IPRangeIndex::FileHeader) + sizeof(Record) * 10 - 1));
+  EXPECT_THROW(IPRangeIndex::load(path), std::runtime_error);
+  unlink(path);
+  EXPECT_THROW(IPRangeIndex::load(path), std::runtime_error);
+}
+
+/**
+ * readThrough serves cache misses from the index and fills the cache, misses of both are not cached.
+ */
+TEST(IpRangeIndexTest, ReadThrough) {
+  const IPRangeIndex index{std::vector<Record>{{0x0A000000, 0x0AFFFFFF, create_cache_value(10)}}};
+  IPTimeEntityCache lruc{64, 1};
+  int64_t expiryTs = 0;
+  auto read = [&expiryTs](const auto& value) { expiryTs = value.expiryTs; };
+
+  EXPECT_TRUE(index.readThrough(lruc, create_IpAddress("10.0.0.1"), read));
+  EXPECT_EQ(10, expiryTs);
+  EXPECT_EQ(1, lruc.size());
+
+  // served by the cache once filled.
+  lruc.erase(create_IpAddress("10.0.0.1"));
+  lruc.insert(create_IpAddress("10.0.0.1"), create_cache_value(11));
+  EXPECT_TRUE(index.readThrough(lruc, create_IpAddress("10.0.0.1"), read));
+  EXPECT_EQ(11, expiryTs);
+
+  EXPECT_FALSE(index.readThrough(lruc, create_IpAddress("11.0.0.1"), read));
+  EXPECT_EQ(1, lruc.size());
+}
@@ -212,7 +212,6 @@ TEST(LRUCacheTest_Same_Key, ConcurrentInsert) {
 
   // concurrent insert
   tbb::parallel_for_each(data, [&, key, value](auto _) {
-    IPLRUCache::ConstAccessor ca;
     // insert IP concurrently
     lruc.insert(key, value);
   });
@@ -232,7 +231,6 @@ TEST(LRUCacheTest_Same_Key, ConcurrentErase) {
 
   // concurrent insert
   tbb::parallel_for_each(data, [&, key, value](auto _) {
-    IPLRUCache::ConstAccessor ca;
     // insert IP concurrently
     lruc.insert(key, value);
   });
@@ -241,7 +239,6 @@ TEST(LRUCacheTest_Same_Key, ConcurrentErase) {
 
   // concurrent erase
   tbb::parallel_for_each(data, [&, key](auto _) {
-    IPLRUCache::ConstAccessor ca;
     // erase IP concurrently
     lruc.erase(key);
   });
@@ -373,3 +370,382 @@ TEST(LRUCacheTest_Same_Key, ConcurrentInsertAndPop) {
 
   ASSERT_EQ(1, lruc.size()) << "cache.size() is not 1";
 }
+
+/**
+ * visit reads the stored value in place.
+ */
+TEST_F(LRUCacheTest, TestVisit) {
+  visitJob(lruc, EXPIRYTS);
+
+  int code = -1;
+  EXPECT_TRUE(lruc.visit(create_IpAddress(getIPv4(0, 0, 42)), [&code](const auto& value) { code = value.denialInfoCode; }));
+  EXPECT_EQ(0, code);
+  EXPECT_FALSE(lruc.visit(create_IpAddress(getIPv4(2, 0, 42)), [](const auto&) { FAIL() << "visited missing key"; }));
+}
+
+/**
+ * OpenAddressingMap inserts of absent keys succeed while concurrent churn keeps using up the tombstone budget,
+ * the live entries never exceed the capacity.
+ */
+TEST(LRUCacheTest_OpenAddressingMap, ChurnNeverDrops) {
+  constexpr int CAPACITY = 64;
+  constexpr int THREAD_COUNT = 4;
+  constexpr auto DURATION = std::chrono::milliseconds(500);
+  LRUC::OpenAddressingMap<int, int, tbb::tbb_hash_compare<int>> map{CAPACITY, 0};
+
+  std::atomic<int> dropped{0};
+  std::vector<std::thread> threads;
+  const auto deadline = std::chrono::steady_clock::now() + DURATION;
+  for (int t = 0; t < THREAD_COUNT; t++) {
+    threads.emplace_back([&map, &dropped, &deadline, t] {
+      // every thread churns its own keys, CAPACITY / THREAD_COUNT live at most.
+      for (int round = 0; std::chrono::steady_clock::now() < deadline; round++) {
+        for (int k = 0; k < CAPACITY / THREAD_COUNT; k++) {
+          const int key = (round * CAPACITY + k) * THREAD_COUNT + t;
+          dropped += map.insert(key, key) ? 0 : 1;
+          map.erase(key);
+        }
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  EXPECT_EQ(0, dropped);
+}
+
+/**
+ * OptimisticRead is selected for bitwise copyable values of at most 2 cache lines over lock-free lookup backends.
+ */
+TEST(LRUCacheTest_Optimistic, Selection) {
+  using Value = CacheValue<CACHE_VALUE_TYPE::TIME_ENTITY_LOOKUP_INFO>;
+  using Hash = tbb::tbb_hash_compare<IpAddress>;
+  EXPECT_TRUE((LRUC::LRUCache<IpAddress, Value, Hash, LRUC::OpenAddressingMap>::OptimisticRead));
+  EXPECT_TRUE((LRUC::LRUCache<IpAddress, Value, Hash, LRUC::TbbUnorderedMap>::OptimisticRead));
+  EXPECT_TRUE((LRUC::ScalableLRUCache<IpAddress, Value, Hash, LRUC::OpenAddressingMap>::OptimisticRead));
+  EXPECT_FALSE((LRUC::LRUCache<IpAddress, Value, Hash, LRUC::TbbHashMap>::OptimisticRead));
+  EXPECT_FALSE((LRUC::LRUCache<IpAddress, Value, Hash, LRUC::SwissMap>::OptimisticRead));
+  EXPECT_FALSE((LRUC::LRUCache<IpAddress, std::string, Hash, LRUC::OpenAddressingMap>::OptimisticRead));
+  EXPECT_FALSE((LRUC::LRUCache<IpAddress, std::array<char, 256>, Hash, LRUC::OpenAddressingMap>::OptimisticRead));
+}
+
+/**
+ * optimisticNoTornRead checks that find() and visit() never return a torn value while writers update values in place
+ * and erase / insert keys.
+ */
+template <template <class, class, class> class TMap>
+void optimisticNoTornRead() {
+  // every word holds key * GEN_CNT + generation, a torn copy mixes generations.
+  using Value = std::array<uint64_t, 8>;
+  using Cache = LRUC::LRUCache<int, Value, tbb::tbb_hash_compare<int>, TMap>;
+  constexpr int KEY_CNT = 64;
+  constexpr int GEN_CNT = 2'000;
+  constexpr int READER_CNT = 3;
+  Cache lruc{KEY_CNT};
+  static_assert(Cache::OptimisticRead);
+
+  auto makeValue = [](int key, int gen) {
+    Value value;
+    value.fill(static_cast<uint64_t>(key) * GEN_CNT + static_cast<uint64_t>(gen));
+    return value;
+  };
+  auto isTorn = [](int key, const Value& value) {
+    return std::any_of(value.begin(), value.end(), [&value](uint64_t w) { return w != value[0]; }) ||
+           static_cast<int>(value[0] / GEN_CNT) != key;
+  };
+
+  for (int key = 0; key < KEY_CNT; key++) {
+    lruc.insert(key, makeValue(key, 0));
+  }
+
+  std::atomic<bool> stop{false};
+  std::atomic<int> torn{0};
+  std::atomic<long long> hits{0};
+  std::vector<std::thread> readers;
+  for (int t = 0; t < READER_CNT; t++) {
+    readers.emplace_back([&] {
+      while (!stop) {
+        for (int key = 0; key < KEY_CNT; key++) {
+          typename Cache::ConstAccessor ac;
+          if (lruc.find(ac, key)) {
+            torn += isTorn(key, *ac);
+            hits++;
+          }
+          lruc.visit(key, [&](const Value& value) { torn += isTorn(key, value); });
+        }
+      }
+    });
+  }
+
+  // odd keys are updated in place, even keys are erased and inserted again.
+  std::thread eraser([&] {
+    for (int gen = 1; gen < GEN_CNT; gen++) {
+      for (int key = 0; key < KEY_CNT; key += 2) {
+        lruc.erase(key);
+        lruc.insert(key, makeValue(key, gen));
+      }
+    }
+  });
+  for (int gen = 1; gen < GEN_CNT; gen++) {
+    for (int key = 1; key < KEY_CNT; key += 2) {
+      EXPECT_TRUE(lruc.update(key, makeValue(key, gen)));
+    }
+  }
+  eraser.join();
+  stop = true;
+  for (auto& reader : readers) {
+    reader.join();
+  }
+
+  EXPECT_EQ(0, torn);
+  EXPECT_LT(0, hits);
+  EXPECT_EQ(KEY_CNT, lruc.size());
+
+  typename Cache::ConstAccessor ac;
+  ASSERT_TRUE(lruc.find(ac, 1));
+  EXPECT_EQ(makeValue(1, GEN_CNT - 1), *ac);
+  EXPECT_FALSE(lruc.update(KEY_CNT, makeValue(KEY_CNT, 0)));
+}
+
+/**
+ * Optimistic find / visit never return a torn value while update() overwrites it in place.
+ */
+TEST(LRUCacheTest_Optimistic, NoTornRead) {
+  optimisticNoTornRead<LRUC::OpenAddressingMap>();
+  optimisticNoTornRead<LRUC::TbbUnorderedMap>();
+}
+
+/**
+ * PackedIpKey round trips IpAddress / sockaddr and IPv4 packs IPv4-mapped.
+ */
+TEST(LRUCacheTest_PackedIpKey, Conversion) {
+  const auto v4 = create_IpAddress("192.168.1.1");
+  const auto v6 = create_IPv6Address("2001:db8:8714::12");
+
+  PackedIpKey k4{v4};
+  PackedIpKey k6{&v6.base};
+  EXPECT_TRUE(k4.isV4());
+  EXPECT_FALSE(k6.isV4());
+  EXPECT_EQ(v4, k4.toIpAddress());
+  EXPECT_EQ(v6, k6.toIpAddress());
+  EXPECT_EQ("192.168.1.1", k4.toString());
+  EXPECT_EQ("2001:db8:8714::12", k6.toString());
+
+  // port is dropped, IPv4 equals its IPv4-mapped IPv6 form.
+  EXPECT_EQ(k4, PackedIpKey{create_IPv6Address("::ffff:192.168.1.1")});
+  EXPECT_EQ(k4, PackedIpKey{v4.v4.sin_addr.s_addr});
+  EXPECT_NE(k4, k6);
+  EXPECT_EQ(tbb::tbb_hash_compare<PackedIpKey>::hash(k4), tbb::tbb_hash_compare<PackedIpKey>::hash(PackedIpKey{v4}));
+
+  sockaddr_in6 out;
+  EXPECT_EQ(0U, k6.toSockaddr(reinterpret_cast<sockaddr*>(&out), sizeof(sockaddr_in)));
+  EXPECT_EQ(sizeof(sockaddr_in), k4.toSockaddr(reinterpret_cast<sockaddr*>(&out), sizeof(out)));
+  EXPECT_EQ(v4, IpAddress{reinterpret_cast<sockaddr*>(&out)});
+}
+
+/**
+ * PackedIpKey hash doesn't collapse keys whose word equals the salt it is mixed with.
+ */
+TEST(LRUCacheTest_PackedIpKey, HashSaltWords) {
+  std::unordered_set<size_t> hashes;
+  PackedIpKey key{};
+  for (uint64_t i = 0; i < 1000; i++) {
+    key.word[0] = i;
+    key.word[1] = 0xe7037ed1a0b428dbULL;
+    hashes.insert(key.hash());
+    key.word[0] = 0xa0761d6478bd642fULL;
+    key.word[1] = i;
+    hashes.insert(key.hash());
+  }
+  EXPECT_EQ(2000U, hashes.size());
+}
+
+/**
+ * LRUCache keyed by PackedIpKey.
+ */
+TEST(LRUCacheTest_PackedIpKey, Cache) {
+  constexpr int EXPIRYTS = 42;
+  LRUC::LRUCache<PackedIpKey, CacheValue<CACHE_VALUE_TYPE::TIME_ENTITY_LOOKUP_INFO>, tbb::tbb_hash_compare<PackedIpKey>,
+                 LRUC::LRUC_MAP>
+      lruc{255};
+
+  for (int d = 0; d < 255; d++) {
+    lruc.insert(PackedIpKey{create_IpAddress(getIPv4(0, 0, d))}, create_cache_value(d));
+    lruc.insert(PackedIpKey{create_IPv6Address(getIPv6(0, 0, d))}, create_cache_value(EXPIRYTS));
+  }
+  ASSERT_EQ(255, lruc.size());
+
+  decltype(lruc)::ConstAccessor ca;
+  EXPECT_FALSE(lruc.find(ca, PackedIpKey{create_IpAddress(getIPv4(0, 0, 0))}));
+  EXPECT_TRUE(lruc.find(ca, PackedIpKey{create_IPv6Address(getIPv6(0, 0, 254))}));
+  EXPECT_EQ(EXPIRYTS, ca->expiryTs);
+}
+
+/**
+ * IpText parses what inet_pton parses and formats what inet_ntop formats.
+ */
+TEST(LRUCacheTest_IpText, ParseLikeInetPton) {
+  const std::vector<std::string> texts{
+      "0.0.0.0", "1.2.3.4", "192.168.1.1", "255.255.255.255", "256.1.1.1", "1.2.3", "1.2.3.4.5", "01.2.3.4",
+      "1.2.3.04", "1..2.3", " 1.2.3.4", "1.2.3.4 ", "::", "::1", "1::", "2001:db8:8714::12", "2001:DB8::A:b",
+      "::ffff:192.168.1.1", "1:2:3:4:5:6:1.2.3.4", "1:2:3:4:5:6:7:1.2.3.4", "1:2:3:4:5:6:7:8", "1:2:3:4:5:6:7:8:9",
+      "1:2:3:4:5:6:7:8::", "::1:2:3:4:5:6:7", ":::", ":1", "1:", "1::2::3", "12345::", "::1.2.3.4:1", "::01.2.3.4",
+      "x::1", "", "0000:0000:0000:0000:0000:0000:0000:0000:"};
+
+  for (const auto& text : texts) {
+    sockaddr_in6 expected{};
+    int family = AF_UNSPEC;
+    if (inet_pton(AF_INET, text.c_str(), &reinterpret_cast<sockaddr_in*>(&expected)->sin_addr) == 1) {
+      family = AF_INET;
+    } else if (inet_pton(AF_INET6, text.c_str(), &expected.sin6_addr) == 1) {
+      family = AF_INET6;
+    }
+    expected.sin6_family = static_cast<sa_family_t>(family);
+
+    IpAddress ip;
+    EXPECT_EQ(family != AF_UNSPEC, ip.parse(text)) << text;
+    EXPECT_EQ(family, IpAddressText{text}.base.sa_family) << text;
+    if (family != AF_UNSPEC) {
+      EXPECT_EQ(IpAddress{reinterpret_cast<sockaddr*>(&expected)}, ip) << text;
+    }
+  }
+}
+
+TEST(LRUCacheTest_IpText, FormatLikeInetNtop) {
+  const std::vector<std::string> texts{"0.0.0.0", "1.2.3.4", "10.0.100.255", "::", "::1", "1::", "::ffff:1.2.3.4",
+                                       "::1.2.3.4", "::ffff:0:0", "2001:db8:8714::12", "2001:0:0:1::1",
+                                       "1:0:0:2:0:0:0:3", "1:2:3:4:5:6:7:8", "fe80::ffff:1:2", "::ffff"};
+
+  for (const auto& text : texts) {
+    IpAddress ip;
+    ASSERT_TRUE(ip.parse(text)) << text;
+
+    char expected[INET6_ADDRSTRLEN];
+    if (ip.base.sa_family == AF_INET) {
+      inet_ntop(AF_INET, &ip.v4.sin_addr, expected, sizeof(expected));
+    } else {
+      inet_ntop(AF_INET6, &ip.v6.sin6_addr, expected, sizeof(expected));
+    }
+
+    char buf[INET6_ADDRSTRLEN];
+    EXPECT_EQ(strlen(expected), ip.toChars(buf, sizeof(buf))) << text;
+    EXPECT_STREQ(expected, buf);
+    EXPECT_EQ(std::string(expected), ip.toString());
+  }
+
+  // too small buffer.
+  char buf[INET_ADDRSTRLEN];
+  EXPECT_EQ(0U, create_IPv6Address("::1").toChars(buf, sizeof(buf)));
+  EXPECT_EQ(0U, IpAddress{}.toChars(buf, sizeof(buf)));
+  EXPECT_EQ(7U, create_IpAddress("1.2.3.4").toChars(buf, sizeof(buf)));
+}
+
+TEST(LRUCacheTest_IpText, PackedIpKey) {
+  PackedIpKey k4;
+  PackedIpKey k6;
+  ASSERT_TRUE(k4.parse("192.168.1.1"));
+  ASSERT_TRUE(k6.parse("2001:db8:8714::12"));
+  EXPECT_EQ(PackedIpKey{create_IpAddress("192.168.1.1")}, k4);
+  EXPECT_EQ(PackedIpKey{create_IPv6Address("2001:db8:8714::12")}, k6);
+
+  char buf[INET6_ADDRSTRLEN];
+  EXPECT_EQ(11U, k4.toChars(buf, sizeof(buf)));
+  EXPECT_STREQ("192.168.1.1", buf);
+  EXPECT_EQ("2001:db8:8714::12", k6.toString());
+
+  EXPECT_FALSE(k6.parse("2001:db8:8714::12::"));
+  EXPECT_EQ(PackedIpKey{IpAddress{}}, k6);
+}
+
+/**
+ * hashMany hashes as hash() does, for any mix of families and any count.
+ */
+TEST(LRUCacheTest_IpHash, HashManyMatchesHash) {
+  std::mt19937_64 gen{42};
+  std::vector<IpAddress> keys;
+  for (int i = 0; i < 1021; i++) {
+    switch (gen() % 3) {
+      case 0:
+        keys.emplace_back(static_cast<u_int32_t>(gen()));
+        break;
+      case 1:
+        keys.push_back(create_IPv6Address(getIPv6(static_cast<int>(gen() % 0xffff), i, static_cast<int>(gen() % 256))));
+        break;
+      default:
+        keys.emplace_back();
+    }
+  }
+
+  std::vector<size_t> hashes(keys.size());
+  for (size_t count : {size_t{0}, size_t{1}, size_t{4}, size_t{7}, keys.size()}) {
+    std::fill(hashes.begin(), hashes.end(), 0);
+    tbb::tbb_hash_compare<IpAddress>::hashMany(keys.data(), count, hashes.data());
+    for (size_t i = 0; i < count; i++) {
+      ASSERT_EQ(tbb::tbb_hash_compare<IpAddress>::hash(keys[i]), hashes[i]) << keys[i].toString();
+      ASSERT_EQ(std::hash<IpAddress>{}(keys[i]), hashes[i]);
+    }
+    // nothing written past count.
+    EXPECT_TRUE(std::all_of(hashes.begin() + static_cast<std::ptrdiff_t>(count), hashes.end(),
+                            [](size_t hash) { return hash == 0; }));
+  }
+}
+
+/**
+ * IpHashCompare hashes IpAddress, sockaddr* and address text alike for every family, Compat as tbb_hash_compare does.
+ */
+TEST(LRUCacheTest_IpHash, HashFamilies) {
+  // CRC32C check value of "12345678", table driven or SSE4.2 alike.
+  uint64_t word;
+  memcpy(&word, "12345678", sizeof(word));
+  EXPECT_EQ(0x6087809aU, ~LRUC::detail::crc32c(~0U, word));
+
+  // SipHash-1-3 of the bytes 00 01 .. with the key 00 01 .. 0f.
+  const LRUC::detail::SipKey key{0x0706050403020100ULL, 0x0f0e0d0c0b0a0908ULL};
+  EXPECT_EQ(0xcf75576088d38328ULL, LRUC::detail::sipHash13(key, 0x03020100ULL, 0, 4));
+  EXPECT_EQ(0xcc4fdd1a7d908b66ULL, LRUC::detail::sipHash13(key, key.k0, key.k1, 16));
+
+  const std::vector<std::string> texts{"1.2.3.4", "10.0.0.1", "::ffff:1.2.3.4", "2001:db8::1", "::"};
+  auto check = [&](auto hashCompare) {
+    using HashCompare = decltype(hashCompare);
+    std::unordered_set<size_t> hashes;
+    for (const auto& text : texts) {
+      const auto ip = text.find(':') == std::string::npos ? create_IpAddress(text) : create_IPv6Address(text);
+      const size_t hash = HashCompare::hash(ip);
+      EXPECT_EQ(hash, HashCompare::hash(&ip.base)) << text;
+      const typename HashCompare::TextKey parsed{text};
+      EXPECT_EQ(hash, HashCompare::hash(parsed.lookup())) << text;
+      EXPECT_TRUE(HashCompare::equal(ip, parsed.lookup())) << text;
+      hashes.insert(hash);
+    }
+    EXPECT_EQ(texts.size(), hashes.size());
+  };
+  check(LRUC::IpHashCompare<LRUC::IpHashFamily::Compat>{});
+  check(LRUC::IpHashCompare<LRUC::IpHashFamily::Wy>{});
+  check(LRUC::IpHashCompare<LRUC::IpHashFamily::Crc32c>{});
+  check(LRUC::IpHashCompare<LRUC::IpHashFamily::SipHash13>{});
+
+  const auto ip = create_IPv6Address("2001:db8::1");
+  EXPECT_EQ(tbb::tbb_hash_compare<IpAddress>::hash(ip), LRUC::IpHashCompare<LRUC::IpHashFamily::Compat>::hash(ip));
+}
+
+/**
+ * Wy hash codes stay distinct for IPv6 addresses whose one word equals wyhash's secret of that word.
+ */
+TEST(LRUCacheTest_IpHash, WySecretWords) {
+  std::unordered_set<size_t> hashes;
+  sockaddr_in6 addr{};
+  addr.sin6_family = AF_INET6;
+  uint64_t word[2];
+  for (uint64_t i = 0; i < 1000; i++) {
+    word[0] = i;
+    word[1] = 0x8ebc6af09c88c6e3ULL;
+    memcpy(addr.sin6_addr.s6_addr, word, sizeof(word));
+    hashes.insert(LRUC::IpHashCompare<LRUC::IpHashFamily::Wy>::hash(reinterpret_cast<const sockaddr*>(&addr)));
+    word[0] = 0xe7037ed1a0b428dbULL;
+    word[1] = i;
+    memcpy(addr.sin6_addr.s6_addr, word, sizeof(word));
+    hashes.insert(LRUC::IpHashCompare<LRUC::IpHashFamily::Wy>::hash(reinterpret_cast<const sockaddr*>(&addr)));
+  }
+  EXPECT_EQ(2000U, hashes.size());
+}
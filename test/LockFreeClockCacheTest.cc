@@ -0,0 +1,210 @@
+/**
+ * Unit Test for LockFreeClockCache with type:
+ *
+ * key type: IpAddress
+ * value type: CacheValue<CACHE_VALUE_TYPE::TIME_ENTITY_LOOKUP_INFO>>
+ */
+#include "lrucache_common.h"
+
+using namespace testing;
+
+/**
+ * Init. LockFreeClockCache with 255 entries
+ */
+class LockFreeClockCacheTest : public Test {
+protected:
+  constexpr static int LRUC_SIZE = 255;
+  constexpr static int EXPIRYTS = 42;
+
+  // IPv4 a.b.c.d with 'a' stick to 192 and 'b', 'c', 'd' has the range [from,to)
+  constexpr static int bfrom{0};
+  constexpr static int bto{1};
+  constexpr static int cfrom{0};
+  constexpr static int cto{1};
+  constexpr static int dfrom{0};
+  constexpr static int dto{255};
+
+  IPLockFreeClockCache lruc{LRUC_SIZE};
+
+protected:
+  void SetUp() override { ipJob(lruc, bfrom, bto, cfrom, cto, dfrom, dto, EXPIRYTS); }
+  void TearDown() override {}
+};
+
+namespace {
+
+/**
+ * Entry is a value telling the key it was stored with, a torn or misplaced
+ * copy doesn't match its key. Several cache lines long, thus a copy is likely
+ * overwritten midway.
+ */
+struct Entry final {
+  uint64_t key;
+  std::array<uint64_t, 31> check;
+};
+
+Entry entryOf(uint64_t key) {
+  Entry value{key, {}};
+  value.check.fill(~key);
+  return value;
+}
+
+/**
+ * torn tells whether value isn't a whole value of key.
+ */
+bool torn(uint64_t key, const Entry& value) {
+  return value.key != key ||
+         std::any_of(value.check.begin(), value.check.end(), [key](uint64_t check) { return check != ~key; });
+}
+
+/**
+ * SameBucket hashes every key into the same index bucket.
+ */
+struct SameBucket final {
+  size_t operator()(uint64_t) const { return 0; }
+};
+
+using EntryClockCache = LRUC::LockFreeClockCache<uint64_t, Entry>;
+using SameBucketClockCache = LRUC::LockFreeClockCache<uint64_t, Entry, SameBucket>;
+
+}  // namespace
+
+/**
+ * Single thread access LRU cache test.
+ */
+TEST_F(LockFreeClockCacheTest, TestSingleThread) {
+  ASSERT_EQ(LRUC_SIZE, lruc.size()) << "cache.size() result not match";
+  ASSERT_EQ(LRUC_SIZE, lruc.capacity()) << "cache.capacity() result not match";
+
+  auto found = lruc.find(create_IpAddress(getIPv4(0, 0, 42)));
+  ASSERT_TRUE(found.has_value());
+  EXPECT_EQ(EXPIRYTS, (*found).expiryTs);
+  EXPECT_FALSE(lruc.insert(create_IpAddress(getIPv4(0, 0, 42)), create_cache_value(EXPIRYTS + 1)));
+
+  EXPECT_EQ(1, lruc.erase(create_IpAddress(getIPv4(0, 0, 42))));
+  EXPECT_FALSE(lruc.find(create_IpAddress(getIPv4(0, 0, 42))).has_value());
+  EXPECT_EQ(LRUC_SIZE - 1, lruc.size());
+
+  lruc.clear();
+  EXPECT_FALSE(lruc.find(create_IpAddress(getIPv4(0, 0, 1))).has_value());
+  EXPECT_EQ(0, lruc.size()) << "LRU cache cleared but size still show not 0";
+}
+
+/**
+ * A key found since the clock hand passed gets a second chance, the next
+ * unreferenced key is evicted instead.
+ */
+TEST(LockFreeClockCacheTest_Clock, SecondChance) {
+  EntryClockCache lruc{4};
+  for (uint64_t key = 1; key <= 4; key++) {
+    ASSERT_TRUE(lruc.insert(key, entryOf(key)));
+  }
+
+  // the hand wraps to key 1's slot, referenced, then evicts key 2.
+  ASSERT_TRUE(lruc.find(1).has_value());
+  ASSERT_TRUE(lruc.insert(5, entryOf(5)));
+  EXPECT_TRUE(lruc.find(1).has_value());
+  EXPECT_FALSE(lruc.find(2).has_value());
+  EXPECT_EQ(4, lruc.size());
+
+  // the hand moves on in slot order.
+  ASSERT_TRUE(lruc.insert(6, entryOf(6)));
+  EXPECT_FALSE(lruc.find(3).has_value());
+  ASSERT_TRUE(lruc.insert(7, entryOf(7)));
+  EXPECT_FALSE(lruc.find(4).has_value());
+  EXPECT_TRUE(lruc.find(1).has_value());
+}
+
+/**
+ * A key inserted into a full index bucket displaces the entry farthest behind
+ * the clock hand: the displaced key is dropped before the clock reaches it and
+ * its slot is reused.
+ */
+TEST(LockFreeClockCacheTest_Clock, BucketDisplacement) {
+  SameBucketClockCache lruc{64};
+  for (uint64_t key = 0; key < 7; key++) {
+    ASSERT_TRUE(lruc.insert(key, entryOf(key)));
+  }
+  ASSERT_EQ(7, lruc.size());
+
+  ASSERT_TRUE(lruc.insert(7, entryOf(7)));
+  EXPECT_FALSE(lruc.find(0).has_value()) << "oldest entry not displaced";
+  for (uint64_t key = 1; key <= 7; key++) {
+    EXPECT_TRUE(lruc.find(key).has_value()) << key;
+  }
+  EXPECT_EQ(7, lruc.size()) << "displaced key still counted";
+
+  // displaced key can be inserted again, displacing the next oldest.
+  ASSERT_TRUE(lruc.insert(0, entryOf(0)));
+  EXPECT_TRUE(lruc.find(0).has_value());
+  EXPECT_FALSE(lruc.find(1).has_value());
+  EXPECT_EQ(7, lruc.size());
+}
+
+/**
+ * Readers never see a value of another key or a torn value while writers keep
+ * overwriting the same slots, version validation discards those copies.
+ */
+TEST(LockFreeClockCacheTest_Clock, ConcurrentOverwrite) {
+  constexpr uint64_t KEYS = 64;
+  EntryClockCache lruc{8};
+  std::atomic<bool> stop{false};
+  std::atomic<size_t> hits{0};
+
+  std::vector<std::thread> threads;
+  for (uint64_t t = 0; t < 2; t++) {
+    threads.emplace_back([&, t] {
+      for (uint64_t i = t; !stop; i++) {
+        const uint64_t key = i * 7 % KEYS;
+        if (i % 3 == 0) {
+          lruc.erase(key);
+        } else {
+          lruc.insert(key, entryOf(key));
+        }
+      }
+    });
+    threads.emplace_back([&] {
+      for (uint64_t key = 0; !stop; key = (key + 1) % KEYS) {
+        lruc.visit(key, [&](const Entry& value) {
+          EXPECT_FALSE(torn(key, value)) << key;
+          hits++;
+        });
+      }
+    });
+  }
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(500));
+  stop = true;
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  EXPECT_LT(0, hits);
+  EXPECT_GE(8, lruc.size());
+}
+
+/**
+ * Test concurrent insert same key
+ */
+TEST(LockFreeClockCacheTest_Same_Key, ConcurrentInsert) {
+  auto key = create_IpAddress("192.168.1.1");
+  auto value = create_cache_value(42);
+  std::array<unsigned char, 10000> data;
+  data.fill('o');
+  IPLockFreeClockCache lruc{42};
+
+  // concurrent insert
+  tbb::parallel_for_each(data, [&, key, value](auto&&) {
+    // insert IP concurrently
+    lruc.insert(key, value);
+  });
+
+  ASSERT_EQ(1, lruc.size()) << "cache.size() result not match";
+}
+
+/**
+ * visit reads the stored value in place.
+ */
+TEST_F(LockFreeClockCacheTest, TestVisit) {
+  visitJob(lruc, EXPIRYTS);
+}
@@ -0,0 +1,129 @@
+/**
+ * Unit Test for NearLRUCache with type:
+ *
+ * key type: IpAddress
+ * value type: CacheValue<CACHE_VALUE_TYPE::TIME_ENTITY_LOOKUP_INFO>>
+ */
+
+#include "lrucache_common.h"
+
+using namespace testing;
+
+/**
+ * Init. NearLRUCache with 255 entries
+ */
+class NearLRUCacheTest : public Test {
+protected:
+  constexpr static int LRUC_SIZE = 255;
+  constexpr static int EXPIRYTS = 42;
+
+  // IPv4 a.b.c.d with 'a' stick to 192 and 'b', 'c', 'd' has the range [from,to)
+  constexpr static int bfrom{0};
+  constexpr static int bto{1};
+  constexpr static int cfrom{0};
+  constexpr static int cto{1};
+  constexpr static int dfrom{0};
+  constexpr static int dto{255};
+
+  NEAR_IPLRUCache lruc{LRUC_SIZE};
+
+protected:
+  void SetUp() override { ipJob(lruc, bfrom, bto, cfrom, cto, dfrom, dto, EXPIRYTS); }
+  void TearDown() override {}
+};
+
+/**
+ * Single thread access near cache test.
+ */
+TEST_F(NearLRUCacheTest, TestSingleThread) {
+  ASSERT_GE(LRUC_SIZE, lruc.size()) << "cache.size() is greater than init. cache size!";
+  ASSERT_EQ(LRUC_SIZE, lruc.capacity()) << "cache.capacity() result not match";
+
+  auto key = create_IpAddress(getIPv4(1, 0, 42));
+  NEAR_IPLRUCache::ConstAccessor ca;
+
+  EXPECT_FALSE(lruc.find(ca, key));
+  EXPECT_TRUE(lruc.insert(key, create_cache_value(EXPIRYTS)));
+
+  // first find fills the near cache, second find hits it.
+  EXPECT_TRUE(lruc.find(ca, key));
+  EXPECT_TRUE(lruc.find(ca, key));
+  EXPECT_EQ(EXPIRYTS, (*ca).expiryTs);
+
+  auto stats = lruc.nearStats();
+  EXPECT_EQ(1, stats.hits);
+  EXPECT_EQ(2, stats.misses);
+
+  // erase invalidates near cache.
+  EXPECT_EQ(1, lruc.erase(key));
+  EXPECT_FALSE(lruc.find(ca, key)) << "erased key served from near cache";
+
+  // re-inserted key served with the new value.
+  lruc.insert(key, create_cache_value(EXPIRYTS + 1));
+  EXPECT_TRUE(lruc.find(ca, key));
+  EXPECT_TRUE(lruc.find(ca, key));
+  EXPECT_EQ(EXPIRYTS + 1, (*ca).expiryTs);
+
+  lruc.clear();
+  EXPECT_FALSE(lruc.find(ca, key)) << "LRU cache cleared but IP key still can be found";
+  ASSERT_EQ(0, lruc.size()) << "LRU cache cleared but size still show not 0";
+}
+
+/**
+ * multi-threads access near cache test.
+ *
+ * Keys erased by one thread are not served from other threads' near cache.
+ */
+TEST_F(NearLRUCacheTest, TestMultiThread_1) {
+  std::vector<IpAddress> keys;
+  for (int d = dfrom; d < dto; d++) {
+    keys.push_back(create_IpAddress(getIPv4(0, 0, d)));
+  }
+
+  // fill every thread's near cache.
+  tbb::parallel_for_each(begin(keys), end(keys), [this](const auto& key) {
+    NEAR_IPLRUCache::ConstAccessor ca;
+    lruc.find(ca, key);
+    lruc.find(ca, key);
+  });
+
+  for (const auto& key : keys) {
+    lruc.erase(key);
+  }
+
+  tbb::parallel_for_each(begin(keys), end(keys), [this](const auto& key) {
+    NEAR_IPLRUCache::ConstAccessor ca;
+    EXPECT_FALSE(lruc.find(ca, key)) << "IP: [" << key.toString() << "] found after erase";
+  });
+
+  EXPECT_EQ(0, lruc.size()) << "cache.size() result not match";
+}
+
+/**
+ * visit reads the stored value in place.
+ */
+TEST_F(NearLRUCacheTest, TestVisit) {
+  visitJob(lruc, EXPIRYTS);
+}
+
+/**
+ * A key evicted by the backing cache then inserted again with a new value is not served stale from the near cache.
+ */
+TEST(NearLRUCacheTest_Coherence, EvictReinsert) {
+  NEAR_IPLRUCache lruc{1, 1};
+  const auto key1 = create_IpAddress(getIPv4(1, 0, 1));
+  const auto key2 = create_IpAddress(getIPv4(1, 0, 2));
+  NEAR_IPLRUCache::ConstAccessor ca;
+
+  ASSERT_TRUE(lruc.insert(key1, create_cache_value(100)));
+  ASSERT_TRUE(lruc.find(ca, key1));
+  EXPECT_EQ(100, ca->expiryTs);
+
+  // key2 evicts key1 from the backing cache, key1 comes back with a new value.
+  ASSERT_TRUE(lruc.insert(key2, create_cache_value(200)));
+  ASSERT_EQ(1, lruc.size());
+  ASSERT_TRUE(lruc.insert(key1, create_cache_value(111)));
+
+  ASSERT_TRUE(lruc.find(ca, key1));
+  EXPECT_EQ(111, ca->expiryTs);
+}
@@ -0,0 +1,138 @@
+/**
+ * Unit Test for ScalableClockCache with type:
+ *
+ * key type: IpAddress
+ * value type: CacheValue<CACHE_VALUE_TYPE::TIME_ENTITY_LOOKUP_INFO>>
+ */
+
+#include "lrucache_common.h"
+
+using namespace testing;
+
+/**
+ * Init. ScalableClockCache with 255 entries
+ */
+class ScaleClockCacheTest : public Test {
+protected:
+  constexpr static int LRUC_SIZE = 255;
+  constexpr static int EXPIRYTS = 42;
+
+  // IPv4 a.b.c.d with 'a' stick to 192 and 'b', 'c', 'd' has the range [from,to)
+  constexpr static int bfrom{0};
+  constexpr static int bto{1};
+  constexpr static int cfrom{0};
+  constexpr static int cto{1};
+  constexpr static int dfrom{0};
+  constexpr static int dto{255};
+
+  std::random_device rd{};
+  std::mt19937 gen{rd()};
+
+  SCALE_IPClockCache lruc{LRUC_SIZE};
+
+protected:
+  void SetUp() override { ipJob(lruc, bfrom, bto, cfrom, cto, dfrom, dto, EXPIRYTS); }
+  void TearDown() override {}
+};
+
+/**
+ * Single thread access clock cache test.
+ */
+TEST_F(ScaleClockCacheTest, TestSingleThread) {
+  std::cout << "HW Core count: [" << std::thread::hardware_concurrency() << "]\n" << std::flush;
+
+  // Shards may be skewed and evict before the cache is full, see ScaleLRUCacheTest.
+  ASSERT_GE(LRUC_SIZE, lruc.size()) << "cache.size() is greater than init. cache size!";
+  ASSERT_EQ(LRUC_SIZE, lruc.capacity()) << "cache.capacity() result not match";
+
+  for (size_t i = 0; i < lruc.shardCount(); i++) {
+    std::cout << "Shard[" << i << "] size: [" << lruc.size(i) << "]\n" << std::flush;
+  }
+
+  // random generator
+  std::uniform_int_distribution<> rangeC{0, 0};
+  std::uniform_int_distribution<> rangeD{0, 254};
+  std::uniform_int_distribution<> rangeFalseB{1, 2};
+
+  std::stringstream randomFalseIPv4;
+  randomFalseIPv4 << "192." << rangeFalseB(gen) << "." << rangeC(gen) << "." << rangeD(gen);
+  EXPECT_FALSE(lruc.find(create_IpAddress(randomFalseIPv4.str())).has_value())
+      << "IP [" << randomFalseIPv4.str() << "] shouldn't be found in clock cache";
+
+  lruc.insert(create_IpAddress(randomFalseIPv4.str()), create_cache_value(EXPIRYTS));
+  auto found = lruc.find(create_IpAddress(randomFalseIPv4.str()));
+  EXPECT_TRUE(found.has_value());
+  EXPECT_EQ(EXPIRYTS, (*found).expiryTs);
+
+  auto eraseResult = lruc.erase(create_IpAddress(randomFalseIPv4.str()));
+  EXPECT_EQ(1, eraseResult);
+  EXPECT_FALSE(lruc.find(create_IpAddress(randomFalseIPv4.str())).has_value());
+
+  lruc.clear();
+  EXPECT_EQ(0, lruc.size()) << "clock cache cleared but size still show not 0";
+  ASSERT_EQ(LRUC_SIZE, lruc.capacity()) << "cache.capacity() result not match";
+}
+
+/**
+ * Capacity is split the same way as ScalableLRUCache, shard 0 takes the remainder.
+ */
+TEST_F(ScaleClockCacheTest, TestShardCapacity) {
+  SCALE_IPClockCache cache{LRUC_SIZE, 4};
+
+  ASSERT_EQ(4, cache.shardCount());
+  EXPECT_EQ(LRUC_SIZE / 4 + LRUC_SIZE % 4, cache.capacity(0));
+  for (size_t i = 1; i < cache.shardCount(); i++) {
+    EXPECT_EQ(LRUC_SIZE / 4, cache.capacity(i));
+  }
+  EXPECT_EQ(0, cache.capacity(cache.shardCount()));
+  EXPECT_EQ(0, cache.size(cache.shardCount()));
+
+  // key lives in the shard shardIndex() routes it to.
+  auto key = create_IpAddress(getIPv4(0, 0, 42));
+  cache.insert(key, create_cache_value(EXPIRYTS));
+  EXPECT_EQ(1, cache.size(cache.shardIndex(key)));
+  EXPECT_EQ(1, cache.size());
+
+  // shard count never exceeds capacity.
+  SCALE_IPClockCache tiny{2, 16};
+  EXPECT_EQ(2, tiny.shardCount());
+  EXPECT_EQ(2, tiny.capacity());
+}
+
+/**
+ * multi-threads access clock cache test.
+ *
+ * Insert, find and erase IPs concurrently.
+ */
+TEST_F(ScaleClockCacheTest, TestMultiThread_1) {
+  constexpr int rbfrom = 1;
+  std::vector<std::string> flushOutIPs;
+
+  // fill the container flushOutIPs with new IPs.
+  for (int d = dfrom; d < dto; d++) {
+    flushOutIPs.push_back(getIPv4(rbfrom, 0, d));
+  }
+
+  std::atomic<int> ipCnt{0};
+  tbb::parallel_for_each(begin(flushOutIPs), end(flushOutIPs), [this, &ipCnt](const auto& ipv4) {
+    auto key = create_IpAddress(ipv4);
+
+    lruc.insert(key, create_cache_value(EXPIRYTS));
+    lruc.find(key);
+    lruc.erase(key);
+    EXPECT_FALSE(lruc.find(key).has_value()) << "IP: [" << ipv4 << "] found after erase";
+
+    ipCnt++;
+  });
+
+  EXPECT_GE(LRUC_SIZE, lruc.size()) << "cache.size() result not match";
+  ASSERT_EQ(LRUC_SIZE, ipCnt) << "IP count not match";
+  ASSERT_EQ(LRUC_SIZE, lruc.capacity()) << "cache.capacity() result not match";
+}
+
+/**
+ * visit reads the stored value in place.
+ */
+TEST_F(ScaleClockCacheTest, TestVisit) {
+  visitJob(lruc, EXPIRYTS);
+}
@@ -7,6 +7,8 @@
 
 #include "lrucache_common.h"
 
+#include <set>
+
 using namespace testing;
 
 /**
@@ -162,3 +164,648 @@ TEST_F(ScaleLRUCacheTest, TestMultiThread_1) {
   ASSERT_EQ(LRUC_SIZE, ipCnt) << "IP count not match";
   ASSERT_EQ(LRUC_SIZE, lruc.capacity()) << "cache.capacity() result not match";
 }
+
+/**
+ * HashedKey overloads hit the same shard/entry as the key overloads.
+ */
+TEST_F(ScaleLRUCacheTest, TestHashedKey) {
+  SCALE_IPLRUCache::ConstAccessor ca;
+
+  // key inserted through TKey overload found through HashedKey overload.
+  SCALE_IPLRUCache::HashedKey hashedIPv4{create_IpAddress(getIPv4(0, 0, 42))};
+  EXPECT_TRUE(lruc.find(ca, hashedIPv4));
+  EXPECT_EQ(EXPIRYTS, (*ca).expiryTs);
+
+  // key inserted through HashedKey overload found through TKey overload.
+  auto ipv6 = create_IPv6Address(getIPv6(1, 2, 3));
+  SCALE_IPLRUCache::HashedKey hashedIPv6{ipv6};
+  EXPECT_FALSE(lruc.find(ca, hashedIPv6));
+  EXPECT_TRUE(lruc.insert(hashedIPv6, create_cache_value(EXPIRYTS + 1)));
+  EXPECT_FALSE(lruc.insert(ipv6, create_cache_value(EXPIRYTS)));
+  EXPECT_TRUE(lruc.find(ca, ipv6));
+  EXPECT_EQ(EXPIRYTS + 1, (*ca).expiryTs);
+
+  EXPECT_EQ(1, lruc.erase(hashedIPv6));
+  EXPECT_FALSE(lruc.find(ca, ipv6));
+}
+
+/**
+ * Heterogeneous lookup by const sockaddr* and address text finds the IpAddress entries.
+ */
+TEST_F(ScaleLRUCacheTest, TestHeterogeneousLookup) {
+  SCALE_IPLRUCache::ConstAccessor ca;
+
+  sockaddr_in v4{};
+  v4.sin_family = AF_INET;
+  v4.sin_port = 4242;
+  ASSERT_EQ(1, inet_pton(AF_INET, "192.0.0.42", &v4.sin_addr));
+  EXPECT_TRUE(lruc.find(ca, reinterpret_cast<const sockaddr*>(&v4)));
+  EXPECT_EQ(EXPIRYTS, ca->expiryTs);
+  EXPECT_TRUE(lruc.find(ca, std::string_view{"192.0.0.42"}));
+  EXPECT_TRUE(lruc.find(ca, "192.0.0.42"));
+  EXPECT_FALSE(lruc.find(ca, "192.1.0.42"));
+  EXPECT_FALSE(lruc.find(ca, "not an address"));
+
+  int code = -1;
+  EXPECT_TRUE(lruc.visit("192.0.0.42", [&code](const auto& value) { code = value.denialInfoCode; }));
+  EXPECT_EQ(0, code);
+
+  auto ipv6 = create_IPv6Address(getIPv6(1, 2, 3));
+  lruc.insert(ipv6, create_cache_value(EXPIRYTS + 1));
+  EXPECT_TRUE(lruc.find(ca, &ipv6.base));
+  EXPECT_EQ(EXPIRYTS + 1, ca->expiryTs);
+  EXPECT_TRUE(lruc.find(ca, getIPv6(1, 2, 3)));
+  EXPECT_FALSE(lruc.find(ca, getIPv6(1, 2, 4)));
+
+  // sockaddr of other families never matches.
+  sockaddr unspec{};
+  EXPECT_FALSE(lruc.find(ca, &unspec));
+}
+
+/**
+ * visit reads the stored value in place.
+ */
+TEST_F(ScaleLRUCacheTest, TestVisit) {
+  visitJob(lruc, EXPIRYTS);
+}
+
+/**
+ * IPv4 and IPv6 entries of IPFamilyTimeEntityCache share the capacity and the LRU eviction.
+ */
+TEST(ScaleLRUCacheTest_IpFamily, SharedCapacity) {
+  constexpr int LRUC_SIZE = 512;
+  constexpr int EXPIRYTS = 42;
+  IPFamilyTimeEntityCache lruc{LRUC_SIZE, 1};
+  IPFamilyTimeEntityCache::ConstAccessor ca;
+
+  auto countFound = [&](auto create, auto getIP, int b) {
+    int cnt = 0;
+    for (int d = 0; d < 256; d++) {
+      cnt += lruc.find(ca, create(getIP(b, 0, d))) ? 1 : 0;
+    }
+    return cnt;
+  };
+
+  ipJob(lruc, 0, 1, 0, 1, 0, 256, EXPIRYTS);
+  for (int d = 0; d < 256; d++) {
+    EXPECT_TRUE(lruc.insert(create_IPv6Address(getIPv6(0, 0, d)), create_cache_value(d)));
+  }
+  ASSERT_EQ(LRUC_SIZE, lruc.size());
+
+  // new IPv4 entries evict the least recently used IPv4 entries only.
+  ipJob(lruc, 1, 2, 0, 1, 0, 256, EXPIRYTS);
+  ASSERT_EQ(LRUC_SIZE, lruc.size());
+  EXPECT_EQ(0, countFound(create_IpAddress, getIPv4, 0));
+  EXPECT_EQ(256, countFound(create_IPv6Address, getIPv6, 0));
+  EXPECT_EQ(256, countFound(create_IpAddress, getIPv4, 1));
+
+  // new IPv6 entries evict the least recently used IPv6 entries.
+  for (int d = 0; d < 256; d++) {
+    EXPECT_TRUE(lruc.insert(create_IPv6Address(getIPv6(1, 0, d)), create_cache_value(d)));
+  }
+  ASSERT_EQ(LRUC_SIZE, lruc.size());
+  EXPECT_EQ(0, countFound(create_IPv6Address, getIPv6, 0));
+  EXPECT_EQ(256, countFound(create_IpAddress, getIPv4, 1));
+  EXPECT_EQ(256, countFound(create_IPv6Address, getIPv6, 1));
+
+  ASSERT_TRUE(lruc.find(ca, create_IPv6Address(getIPv6(1, 0, 42))));
+  EXPECT_EQ(42, ca->expiryTs);
+}
+
+/**
+ * IPv4 and its IPv4-mapped IPv6 form are different IPFamilyTimeEntityCache keys.
+ */
+TEST(ScaleLRUCacheTest_IpFamily, MappedIsDistinct) {
+  IPFamilyTimeEntityCache lruc{16, 1};
+  IPFamilyTimeEntityCache::ConstAccessor ca;
+
+  const auto v4 = create_IpAddress("1.2.3.4");
+  const auto mapped = create_IPv6Address("::ffff:1.2.3.4");
+  EXPECT_TRUE(lruc.insert(v4, create_cache_value(4)));
+  EXPECT_TRUE(lruc.insert(mapped, create_cache_value(6)));
+  EXPECT_EQ(2, lruc.size());
+
+  ASSERT_TRUE(lruc.find(ca, v4));
+  EXPECT_EQ(4, ca->expiryTs);
+  EXPECT_EQ(1, lruc.erase(mapped));
+  EXPECT_FALSE(lruc.find(ca, mapped));
+  EXPECT_TRUE(lruc.find(ca, v4));
+}
+
+/**
+ * Concurrent insert/find/erase of both families.
+ */
+TEST(ScaleLRUCacheTest_IpFamily, ConcurrentInsertEraseFind) {
+  constexpr int LRUC_SIZE = 1024;
+  constexpr int THREAD_CNT = 4;
+  constexpr int ROUND = 4096;
+  IPFamilyTimeEntityCache lruc{LRUC_SIZE, 2};
+
+  std::vector<IpAddress> ips;
+  for (int d = 0; d < 256; d++) {
+    ips.push_back(create_IpAddress(getIPv4(0, 0, d)));
+    ips.push_back(create_IPv6Address(getIPv6(0, 0, d)));
+  }
+
+  std::vector<std::thread> threads;
+  for (int t = 0; t < THREAD_CNT; t++) {
+    threads.emplace_back([&, t] {
+      std::mt19937 gen{static_cast<unsigned>(t)};
+      std::uniform_int_distribution<size_t> pick{0, ips.size() - 1};
+      IPFamilyTimeEntityCache::ConstAccessor ca;
+
+      for (int i = 0; i < ROUND; i++) {
+        const auto& ip = ips[pick(gen)];
+        switch (i % 3) {
+          case 0:
+            lruc.insert(ip, create_cache_value(42));
+            break;
+          case 1:
+            if (lruc.find(ca, ip)) {
+              EXPECT_EQ(42, ca->expiryTs);
+            }
+            break;
+          default:
+            lruc.erase(ip);
+        }
+      }
+    });
+  }
+
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  EXPECT_GE(LRUC_SIZE, lruc.size());
+  int foundCnt = 0;
+  IPFamilyTimeEntityCache::ConstAccessor ca;
+  for (const auto& ip : ips) {
+    foundCnt += lruc.find(ca, ip) ? 1 : 0;
+  }
+  EXPECT_EQ(lruc.size(), foundCnt);
+}
+
+/**
+ * IPFamilyTimeEntityCache heterogeneous lookup routes const sockaddr* and address text to the packed tables.
+ */
+TEST(ScaleLRUCacheTest_IpFamily, HeterogeneousLookup) {
+  IPFamilyTimeEntityCache lruc{16, 1};
+  IPFamilyTimeEntityCache::ConstAccessor ca;
+
+  const auto v4 = create_IpAddress("10.0.0.1");
+  const auto v6 = create_IPv6Address("2001:db8::1");
+  lruc.insert(v4, create_cache_value(4));
+  lruc.insert(v6, create_cache_value(6));
+
+  ASSERT_TRUE(lruc.find(ca, &v4.base));
+  EXPECT_EQ(4, ca->expiryTs);
+  ASSERT_TRUE(lruc.find(ca, &v6.base));
+  EXPECT_EQ(6, ca->expiryTs);
+  ASSERT_TRUE(lruc.find(ca, "10.0.0.1"));
+  EXPECT_EQ(4, ca->expiryTs);
+  ASSERT_TRUE(lruc.find(ca, std::string_view{"2001:db8::1"}));
+  EXPECT_EQ(6, ca->expiryTs);
+
+  EXPECT_FALSE(lruc.find(ca, "::ffff:10.0.0.1"));
+  EXPECT_FALSE(lruc.find(ca, "10.0.0.2"));
+  EXPECT_FALSE(lruc.find(ca, ""));
+  EXPECT_TRUE(lruc.visit("2001:db8::1", [](const auto& value) { EXPECT_EQ(6, value.expiryTs); }));
+}
+
+/**
+ * ScalableLRUCache with IpHashCompare spreads sequential class C blocks over every shard, for every hash family.
+ */
+TEST(ScaleLRUCacheTest_IpHash, HashFamilies) {
+  constexpr int LRUC_SIZE = 4096;
+  constexpr size_t SHARD_COUNT = 8;
+
+  auto check = [&](auto hashCompare) {
+    using Cache = LRUC::ScalableLRUCache<IpAddress, CacheValue<CACHE_VALUE_TYPE::TIME_ENTITY_LOOKUP_INFO>,
+                                         decltype(hashCompare)>;
+    Cache lruc{LRUC_SIZE, SHARD_COUNT};
+    typename Cache::ConstAccessor ca;
+
+    for (int b = 0; b < 4; b++) {
+      for (int c = 0; c < 2; c++) {
+        for (int d = 0; d < 256; d++) {
+          lruc.insert(create_IpAddress(getIPv4(b, c, d)), create_cache_value(42));
+        }
+      }
+    }
+    ASSERT_EQ(2048, lruc.size());
+    for (size_t i = 0; i < SHARD_COUNT; i++) {
+      // 256 entries per shard expected, each shard holds up to 512.
+      EXPECT_GT(lruc.size(i), 128) << i;
+      EXPECT_LT(lruc.size(i), 384) << i;
+    }
+
+    ASSERT_TRUE(lruc.find(ca, create_IpAddress(getIPv4(3, 1, 255))));
+    EXPECT_EQ(42, ca->expiryTs);
+    EXPECT_TRUE(lruc.find(ca, std::string_view{getIPv4(0, 0, 0)}));
+    EXPECT_EQ(1, lruc.erase(create_IpAddress(getIPv4(3, 1, 255))));
+    EXPECT_FALSE(lruc.find(ca, create_IpAddress(getIPv4(3, 1, 255))));
+  };
+  check(LRUC::IpHashCompare<LRUC::IpHashFamily::Compat>{});
+  check(LRUC::IpHashCompare<LRUC::IpHashFamily::Wy>{});
+  check(LRUC::IpHashCompare<LRUC::IpHashFamily::Crc32c>{});
+  check(LRUC::IpHashCompare<LRUC::IpHashFamily::SipHash13>{});
+}
+
+/**
+ * IPPrefixTimeEntityCache aggregates a /64 once threshold64 distinct addresses of it are inserted denied.
+ */
+TEST(ScaleLRUCacheTest_IpPrefix, Aggregate64) {
+  constexpr uint32_t THRESHOLD = 8;
+  IPPrefixTimeEntityCache lruc{1024, 64, THRESHOLD, 0, 2};
+  IPPrefixTimeEntityCache::ConstAccessor ca;
+
+  for (uint32_t i = 1; i <= THRESHOLD; i++) {
+    EXPECT_TRUE(lruc.insert(create_IPv6Address("2001:db8:1:2::" + std::to_string(i)), create_denied_value(42)));
+  }
+  EXPECT_EQ(THRESHOLD, lruc.size());
+  EXPECT_EQ(1, lruc.prefixSize());
+
+  // the /64 covers new addresses, they are not inserted.
+  EXPECT_FALSE(lruc.insert(create_IPv6Address("2001:db8:1:2:dead:beef::1"), create_denied_value(7)));
+  EXPECT_EQ(THRESHOLD, lruc.size());
+  ASSERT_TRUE(lruc.find(ca, create_IPv6Address("2001:db8:1:2:dead:beef::1")));
+  EXPECT_EQ(42, ca->expiryTs);
+  EXPECT_TRUE(lruc.visit(create_IPv6Address("2001:db8:1:2:ffff::"), [](const auto& value) { EXPECT_EQ(42, value.expiryTs); }));
+
+  // the neighbour /64 is not covered.
+  EXPECT_FALSE(lruc.find(ca, create_IPv6Address("2001:db8:1:3::1")));
+  EXPECT_TRUE(lruc.insert(create_IPv6Address("2001:db8:1:3::1"), create_denied_value(3)));
+
+  EXPECT_EQ(1, lruc.erasePrefixes(create_IPv6Address("2001:db8:1:2::99")));
+  EXPECT_EQ(0, lruc.prefixSize());
+  EXPECT_FALSE(lruc.find(ca, create_IPv6Address("2001:db8:1:2:dead:beef::1")));
+  ASSERT_TRUE(lruc.find(ca, create_IPv6Address("2001:db8:1:2::1")));
+
+  // IPv4 is cached exactly.
+  for (int d = 0; d < 64; d++) {
+    EXPECT_TRUE(lruc.insert(create_IpAddress(getIPv4(0, 0, d)), create_cache_value(d)));
+  }
+  EXPECT_EQ(0, lruc.prefixSize());
+  EXPECT_FALSE(lruc.find(ca, create_IpAddress(getIPv4(0, 0, 64))));
+}
+
+/**
+ * IPPrefixTimeEntityCache aggregates a /64 again once its prefix entry is evicted while its count survives.
+ */
+TEST(ScaleLRUCacheTest_IpPrefix, ReaggregateEvicted) {
+  constexpr uint32_t THRESHOLD = 2;
+  IPPrefixTimeEntityCache lruc{1024, 2, THRESHOLD, 0, 1};
+  IPPrefixTimeEntityCache::ConstAccessor ca;
+
+  // counts and prefix entries both hold B then A.
+  for (const char* prefix : {"2001:db8:b::", "2001:db8:a::"}) {
+    for (uint32_t i = 1; i <= THRESHOLD; i++) {
+      EXPECT_TRUE(lruc.insert(create_IPv6Address(prefix + std::to_string(i)), create_denied_value(42)));
+    }
+  }
+  EXPECT_EQ(2, lruc.prefixSize());
+
+  // B becomes the most recent prefix entry, the /64 C evicts the A entry but B's count.
+  ASSERT_TRUE(lruc.find(ca, create_IPv6Address("2001:db8:b::99")));
+  for (uint32_t i = 1; i <= THRESHOLD; i++) {
+    EXPECT_TRUE(lruc.insert(create_IPv6Address("2001:db8:c::" + std::to_string(i)), create_denied_value(42)));
+  }
+  EXPECT_FALSE(lruc.find(ca, create_IPv6Address("2001:db8:a::99")));
+
+  // A's count is past the threshold, the next address aggregates A again.
+  EXPECT_TRUE(lruc.insert(create_IPv6Address("2001:db8:a::3"), create_denied_value(42)));
+  EXPECT_TRUE(lruc.find(ca, create_IPv6Address("2001:db8:a::99")));
+  EXPECT_FALSE(lruc.insert(create_IPv6Address("2001:db8:a::4"), create_denied_value(42)));
+}
+
+/**
+ * IPPrefixTimeEntityCache counts an address denied again, once its exact entry is evicted, as one address.
+ */
+TEST(ScaleLRUCacheTest_IpPrefix, RedenyEvicted) {
+  constexpr uint32_t THRESHOLD = 2;
+  IPPrefixTimeEntityCache lruc{1, 64, THRESHOLD, THRESHOLD, 1};
+  IPPrefixTimeEntityCache::ConstAccessor ca;
+  const auto host = create_IPv6Address("2001:db8:1:2::1");
+
+  for (int i = 0; i < 8; i++) {
+    EXPECT_TRUE(lruc.insert(host, create_denied_value(42)));
+    // evicts the exact entry of host.
+    EXPECT_TRUE(lruc.insert(create_IpAddress(getIPv4(0, 0, i)), create_denied_value(i)));
+    EXPECT_FALSE(lruc.find(ca, host));
+  }
+  EXPECT_EQ(0, lruc.prefixSize());
+  EXPECT_FALSE(lruc.find(ca, create_IPv6Address("2001:db8:1:2::2")));
+
+  // a second address of the /64 reaches the threshold.
+  EXPECT_TRUE(lruc.insert(create_IPv6Address("2001:db8:1:2::2"), create_denied_value(42)));
+  EXPECT_EQ(2, lruc.prefixSize());
+  EXPECT_TRUE(lruc.find(ca, create_IPv6Address("2001:db8:1:2::3")));
+}
+
+/**
+ * IPPrefixTimeEntityCache aggregates a /56 once threshold56 distinct addresses of it are inserted denied, across its /64s.
+ */
+TEST(ScaleLRUCacheTest_IpPrefix, Aggregate56) {
+  constexpr uint32_t THRESHOLD = 16;
+  IPPrefixTimeEntityCache lruc{1024, 64, THRESHOLD, THRESHOLD, 2};
+  IPPrefixTimeEntityCache::ConstAccessor ca;
+
+  // one address in each /64, no /64 reaches its threshold.
+  char text[INET6_ADDRSTRLEN];
+  for (uint32_t i = 0; i < THRESHOLD; i++) {
+    snprintf(text, sizeof(text), "2001:db8:0:%x::1", 0x1200 + i);
+    EXPECT_TRUE(lruc.insert(create_IPv6Address(text), create_denied_value(56)));
+  }
+  EXPECT_EQ(1, lruc.prefixSize());
+
+  ASSERT_TRUE(lruc.find(ca, create_IPv6Address("2001:db8:0:12ff::abcd")));
+  EXPECT_EQ(56, ca->expiryTs);
+  EXPECT_FALSE(lruc.insert(create_IPv6Address("2001:db8:0:1280::1"), create_denied_value(1)));
+  EXPECT_FALSE(lruc.find(ca, create_IPv6Address("2001:db8:0:1300::1")));
+}
+
+/**
+ * IPPrefixTimeEntityCache never aggregates allowed verdicts, and records an allowed or denied address inside a /64
+ * aggregated afterwards.
+ */
+TEST(ScaleLRUCacheTest_IpPrefix, AggregateDenialsOnly) {
+  constexpr uint32_t THRESHOLD = 4;
+  IPPrefixTimeEntityCache lruc{1024, 64, THRESHOLD, THRESHOLD, 2};
+  IPPrefixTimeEntityCache::ConstAccessor ca;
+
+  for (uint32_t i = 1; i <= 4 * THRESHOLD; i++) {
+    EXPECT_TRUE(lruc.insert(create_IPv6Address("2001:db8:1:2::" + std::to_string(i)), create_cache_value(7)));
+  }
+  EXPECT_EQ(0, lruc.prefixSize());
+  EXPECT_FALSE(lruc.find(ca, create_IPv6Address("2001:db8:1:2::ffff")));
+
+  // allowed verdicts do not count toward the threshold either.
+  for (uint32_t i = 1; i < THRESHOLD; i++) {
+    EXPECT_TRUE(lruc.insert(create_IPv6Address("2001:db8:1:2::a:" + std::to_string(i)), create_denied_value(42)));
+  }
+  EXPECT_EQ(0, lruc.prefixSize());
+  EXPECT_TRUE(lruc.insert(create_IPv6Address("2001:db8:1:2::a:ffff"), create_denied_value(42)));
+  EXPECT_EQ(2, lruc.prefixSize());
+
+  // the /64 denies new addresses, an allowed verdict inside it is still recorded and found exactly.
+  ASSERT_TRUE(lruc.find(ca, create_IPv6Address("2001:db8:1:2::b:1")));
+  EXPECT_EQ(42, ca->expiryTs);
+  EXPECT_TRUE(lruc.insert(create_IPv6Address("2001:db8:1:2::b:1"), create_cache_value(7)));
+  ASSERT_TRUE(lruc.find(ca, create_IPv6Address("2001:db8:1:2::b:1")));
+  EXPECT_EQ(7, ca->expiryTs);
+  EXPECT_EQ(0, ca->denialInfoCode);
+
+  // a denial inside the /56 but outside the /64 is covered by the /56 entry.
+  ASSERT_TRUE(lruc.find(ca, create_IPv6Address("2001:db8:1:3::1")));
+  EXPECT_NE(0, ca->denialInfoCode);
+}
+
+/**
+ * IPPrefixTimeEntityCache holds a bounded number of entries of a /64 rotated through by many threads.
+ */
+TEST(ScaleLRUCacheTest_IpPrefix, ConcurrentRotation) {
+  constexpr uint32_t THRESHOLD = 32;
+  constexpr int THREAD_COUNT = 4;
+  constexpr int ADDRESS_COUNT = 4096;
+  IPPrefixTimeEntityCache lruc{ADDRESS_COUNT * THREAD_COUNT, 64, THRESHOLD, 0, 4};
+
+  std::vector<std::thread> threads;
+  for (int t = 0; t < THREAD_COUNT; t++) {
+    threads.emplace_back([&lruc, t] {
+      std::mt19937_64 gen{static_cast<uint64_t>(t)};
+      for (int i = 0; i < ADDRESS_COUNT; i++) {
+        struct sockaddr_in6 addr {};
+        addr.sin6_family = AF_INET6;
+        inet_pton(AF_INET6, "2001:db8:1:2::", &addr.sin6_addr);
+        const uint64_t interfaceId = gen();
+        memcpy(addr.sin6_addr.s6_addr + 8, &interfaceId, sizeof(interfaceId));
+        lruc.insert(IpAddress{reinterpret_cast<const struct sockaddr*>(&addr)}, create_denied_value(i));
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  EXPECT_EQ(1, lruc.prefixSize());
+  // inserts racing with the aggregation may land, at most one per thread.
+  EXPECT_GE(lruc.size(), THRESHOLD);
+  EXPECT_LE(lruc.size(), THRESHOLD + THREAD_COUNT);
+}
+
+/**
+ * IPRateLimitCache goes over limit past limit hits in a window, the previous window weighted by its remaining overlap.
+ */
+TEST(ScaleLRUCacheTest_RateLimit, SlidingWindow) {
+  constexpr uint32_t LIMIT = 10;
+  constexpr int64_t WINDOW = 1000;
+  IPRateLimitCache lruc{64, LIMIT, WINDOW, 2};
+  const auto ip = create_IpAddress("10.0.0.1");
+
+  for (uint32_t i = 0; i < LIMIT; i++) {
+    EXPECT_FALSE(lruc.hit(ip, 5000 + i));
+  }
+  EXPECT_TRUE(lruc.hit(ip, 5500));
+  EXPECT_DOUBLE_EQ(11, lruc.rate(ip, 5999));
+  EXPECT_FALSE(lruc.hit(create_IpAddress("10.0.0.2"), 5500));
+
+  // 11 hits of the previous window weigh 11 * 0.75 at 6250, 11 * 0.25 at 6750.
+  EXPECT_DOUBLE_EQ(8.25, lruc.rate(ip, 6250));
+  EXPECT_FALSE(lruc.hit(ip, 6250));
+  EXPECT_TRUE(lruc.hit(ip, 6250));
+  EXPECT_TRUE(lruc.hit(ip, 6250));
+  EXPECT_DOUBLE_EQ(2.75 + 3, lruc.rate(ip, 6750));
+
+  // a window without hits clears both counts.
+  EXPECT_DOUBLE_EQ(0, lruc.rate(ip, 8000));
+  EXPECT_FALSE(lruc.hit(ip, 8000));
+  EXPECT_DOUBLE_EQ(1, lruc.rate(ip, 8000));
+  EXPECT_DOUBLE_EQ(0, lruc.rate(create_IpAddress("10.0.0.3"), 8000));
+}
+
+/**
+ * IPRateLimitCache counts a hit with an older now, read before a concurrent hit's newer now, into the newer window.
+ */
+TEST(ScaleLRUCacheTest_RateLimit, OlderNow) {
+  constexpr uint32_t LIMIT = 10;
+  constexpr int64_t WINDOW = 1000;
+  IPRateLimitCache lruc{64, LIMIT, WINDOW, 2};
+  const auto ip = create_IpAddress("10.0.0.1");
+
+  for (uint32_t i = 0; i < LIMIT; i++) {
+    EXPECT_FALSE(lruc.hit(ip, 6000));
+  }
+  EXPECT_TRUE(lruc.hit(ip, 5999));
+  EXPECT_DOUBLE_EQ(LIMIT + 1, lruc.rate(ip, 6000));
+  EXPECT_DOUBLE_EQ(LIMIT + 1, lruc.rate(ip, 5999));
+  EXPECT_TRUE(lruc.hit(ip, 6001));
+  EXPECT_DOUBLE_EQ((LIMIT + 2) * 0.5, lruc.rate(ip, 7500));
+}
+
+/**
+ * IPRateLimitCache tells windows apart across 2^32 window numbers, a key idle for 2^24 windows counts from 0 again.
+ */
+TEST(ScaleLRUCacheTest_RateLimit, WindowRange) {
+  constexpr int64_t WINDOW = 1000;
+  IPRateLimitCache lruc{64, 10, WINDOW, 2};
+  const auto ip = create_IpAddress("10.0.0.1");
+
+  EXPECT_FALSE(lruc.hit(ip, WINDOW));
+  EXPECT_DOUBLE_EQ(1, lruc.rate(ip, WINDOW));
+  EXPECT_DOUBLE_EQ(0, lruc.rate(ip, ((1 << 24) + 1) * WINDOW));
+  EXPECT_FALSE(lruc.hit(ip, ((1 << 24) + 1) * WINDOW));
+  EXPECT_DOUBLE_EQ(1, lruc.rate(ip, ((1 << 24) + 1) * WINDOW));
+
+  // the last window before 2^32 windows, then the next one wrapping the window number to 0, on a fresh key: the
+  // counter of ip is 2^31 windows or more behind.
+  const auto wrapIp = create_IpAddress("10.0.0.2");
+  const int64_t wrap = (INT64_C(1) << 32) * WINDOW;
+  EXPECT_FALSE(lruc.hit(wrapIp, wrap - WINDOW));
+  EXPECT_FALSE(lruc.hit(wrapIp, wrap - WINDOW));
+  EXPECT_DOUBLE_EQ(2, lruc.rate(wrapIp, wrap - 1));
+  EXPECT_FALSE(lruc.hit(wrapIp, wrap));
+  EXPECT_DOUBLE_EQ(2 * 0.5 + 1, lruc.rate(wrapIp, wrap + WINDOW / 2));
+  EXPECT_DOUBLE_EQ(1, lruc.rate(wrapIp, wrap + WINDOW));
+  EXPECT_DOUBLE_EQ(0, lruc.rate(wrapIp, wrap + 2 * WINDOW));
+
+  // epoch milliseconds with 1 millisecond windows, past 2^32 windows.
+  IPRateLimitCache shortWindow{64, 2, 1, 2};
+  const int64_t epochMs = INT64_C(1'790'000'000'000);
+  EXPECT_FALSE(shortWindow.hit(ip, epochMs));
+  EXPECT_FALSE(shortWindow.hit(ip, epochMs));
+  EXPECT_TRUE(shortWindow.hit(ip, epochMs));
+  EXPECT_DOUBLE_EQ(0, shortWindow.rate(ip, epochMs + 2));
+}
+
+/**
+ * IPRateLimitCache counts every hit of concurrent threads, keys are evicted at capacity.
+ */
+TEST(ScaleLRUCacheTest_RateLimit, ConcurrentHits) {
+  constexpr int THREAD_COUNT = 4;
+  constexpr int HIT_COUNT = 10000;
+  IPRateLimitCache lruc{16, THREAD_COUNT * HIT_COUNT / 2, 1000, 1};
+  const auto ip = create_IpAddress("10.0.0.1");
+
+  std::atomic<int> overLimit{0};
+  std::vector<std::thread> threads;
+  for (int t = 0; t < THREAD_COUNT; t++) {
+    threads.emplace_back([&lruc, &ip, &overLimit] {
+      for (int i = 0; i < HIT_COUNT; i++) {
+        overLimit += lruc.hit(ip, 100) ? 1 : 0;
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  EXPECT_DOUBLE_EQ(THREAD_COUNT * HIT_COUNT, lruc.rate(ip, 100));
+  EXPECT_EQ(THREAD_COUNT * HIT_COUNT / 2, overLimit.load());
+
+  for (int i = 0; i < 32; i++) {
+    lruc.hit(create_IpAddress(getIPv4(1, 0, i)), 100);
+  }
+  EXPECT_EQ(16, lruc.size());
+  EXPECT_DOUBLE_EQ(0, lruc.rate(ip, 100));
+
+  EXPECT_THROW(IPRateLimitCache(16, IPRateLimitCache::MAX_COUNT + 1, 1000), std::invalid_argument);
+  EXPECT_THROW(IPRateLimitCache(16, 10, 0), std::invalid_argument);
+}
+
+/**
+ * IPOrderedTimeEntityCache eraseRange drops the entries inside a block only, of either family.
+ */
+TEST(ScaleLRUCacheTest_EraseRange, Cidr) {
+  IPOrderedTimeEntityCache lruc{4096, 4};
+  for (int c = 0; c < 4; c++) {
+    for (int d = 0; d < 256; d++) {
+      lruc.insert(create_IpAddress(getIPv4(168, c, d)), create_cache_value(c));
+    }
+  }
+  for (const char* ip : {"2001:db8:1:2::1", "2001:db8:1:2::ffff", "2001:db8:1:3::1", "::ffff:192.168.1.1"}) {
+    lruc.insert(create_IPv6Address(ip), create_cache_value(6));
+  }
+  ASSERT_EQ(1028, lruc.size());
+
+  auto cidr = [](const char* text) {
+    LRUC::Cidr block;
+    EXPECT_TRUE(LRUC::Cidr::parse(text, &block)) << text;
+    return block;
+  };
+
+  EXPECT_EQ(256, lruc.eraseRange(cidr("192.168.1.0/24")));
+  EXPECT_EQ(772, lruc.size());
+  IPOrderedTimeEntityCache::ConstAccessor ca;
+  EXPECT_FALSE(lruc.find(ca, create_IpAddress("192.168.1.0")));
+  EXPECT_FALSE(lruc.find(ca, create_IpAddress("192.168.1.255")));
+  EXPECT_TRUE(lruc.find(ca, create_IpAddress("192.168.0.255")));
+  EXPECT_TRUE(lruc.find(ca, create_IpAddress("192.168.2.0")));
+  EXPECT_TRUE(lruc.find(ca, create_IPv6Address("::ffff:192.168.1.1")));
+
+  EXPECT_EQ(2, lruc.eraseRange(cidr("2001:db8:1:2::/64")));
+  EXPECT_TRUE(lruc.find(ca, create_IPv6Address("2001:db8:1:3::1")));
+  EXPECT_EQ(1, lruc.eraseRange(cidr("192.168.3.7")));
+  EXPECT_EQ(0, lruc.eraseRange(cidr("10.0.0.0/8")));
+  EXPECT_EQ(2, lruc.eraseRange(cidr("::/0")));
+  EXPECT_EQ(767, lruc.eraseRange(cidr("0.0.0.0/0")));
+  EXPECT_EQ(0, lruc.size());
+}
+
+/**
+ * IPOrderedTimeEntityCache keeps its index exact through evictions and concurrent inserts.
+ */
+TEST(ScaleLRUCacheTest_EraseRange, EvictionAndConcurrency) {
+  constexpr int THREAD_COUNT = 4;
+  IPOrderedTimeEntityCache lruc{512, 2};
+  LRUC::Cidr all;
+  ASSERT_TRUE(LRUC::Cidr::parse("0.0.0.0/0", &all));
+
+  std::vector<std::thread> threads;
+  for (int t = 0; t < THREAD_COUNT; t++) {
+    threads.emplace_back([&lruc, &all, t] {
+      for (int i = 0; i < 4096; i++) {
+        lruc.insert(create_IpAddress(getIPv4(t, i >> 8, i & 0xff)), create_cache_value(i));
+        if (i % 1024 == 0) {
+          lruc.eraseRange(all);
+        }
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  // evicted keys left the index, every remaining key is still in it.
+  const long long size = lruc.size();
+  EXPECT_LE(size, 512);
+  EXPECT_EQ(static_cast<size_t>(size), lruc.eraseRange(all));
+  EXPECT_EQ(0, lruc.size());
+}
+
+/**
+ * SortedBlockSet holds the keys std::set holds through random inserts and erases, splitting and merging blocks.
+ */
+TEST(ScaleLRUCacheTest_EraseRange, SortedBlockSet) {
+  std::mt19937 gen{42};
+  LRUC::SortedBlockSet<uint32_t> blocks;
+  std::set<uint32_t> expected;
+
+  for (int i = 0; i < 200000; i++) {
+    // inserts dominate first, erases later, blocks split then merge.
+    const uint32_t key = gen() % 8192;
+    if (gen() % 100 < (i < 100000 ? 70U : 30U)) {
+      ASSERT_EQ(expected.insert(key).second, blocks.insert(key)) << key;
+    } else {
+      ASSERT_EQ(expected.erase(key) == 1, blocks.erase(key)) << key;
+    }
+
+    if (i % 1000 == 0) {
+      const uint32_t first = gen() % 8192;
+      const uint32_t last = first + gen() % 1024;
+      std::vector<uint32_t> found;
+      blocks.forRange(first, last, [&found](uint32_t k) { found.push_back(k); });
+      const std::vector<uint32_t> want(expected.lower_bound(first), expected.upper_bound(last));
+      ASSERT_EQ(want, found) << first << " " << last;
+    }
+  }
+}
@@ -0,0 +1,136 @@
+/**
+ * Unit Test for SnapshotCache with type:
+ *
+ * key type: IpAddress
+ * value type: CacheValue<CACHE_VALUE_TYPE::TIME_ENTITY_LOOKUP_INFO>>
+ */
+
+#include "lrucache_common.h"
+
+using namespace testing;
+
+/**
+ * Init. SnapshotCache with 255 entries
+ */
+class SnapshotCacheTest : public Test {
+protected:
+  constexpr static int SNAPSHOT_SIZE = 255;
+  constexpr static int EXPIRYTS = 42;
+
+  // IPv4 a.b.c.d with 'a' stick to 192 and 'b', 'c', 'd' has the range [from,to)
+  constexpr static int bfrom{0};
+  constexpr static int bto{1};
+  constexpr static int cfrom{0};
+  constexpr static int cto{1};
+  constexpr static int dfrom{0};
+  constexpr static int dto{255};
+
+  IPTimeEntitySnapshot cache{};
+  IPTimeEntitySnapshot::Entries entries{};
+
+protected:
+  void SetUp() override {
+    ipJob(entries, bfrom, bto, cfrom, cto, dfrom, dto, EXPIRYTS);
+    cache.publish(entries);
+  }
+  void TearDown() override {}
+};
+
+/**
+ * Single thread access snapshot cache test.
+ */
+TEST_F(SnapshotCacheTest, TestSingleThread) {
+  ASSERT_EQ(SNAPSHOT_SIZE, cache.size()) << "cache.size() result not match";
+
+  IPTimeEntitySnapshot::ConstAccessor ca;
+  EXPECT_TRUE(cache.find(ca, create_IpAddress(getIPv4(0, 0, 42))));
+  EXPECT_EQ(EXPIRYTS, (*ca).expiryTs);
+  EXPECT_FALSE(cache.find(ca, create_IpAddress(getIPv4(1, 0, 42))));
+
+  // duplicated key, first entry wins.
+  entries.emplace_back(create_IpAddress(getIPv4(0, 0, 42)), create_cache_value(EXPIRYTS + 1));
+  entries.emplace_back(create_IPv6Address(getIPv6(1, 2, 3)), create_cache_value(EXPIRYTS + 1));
+  cache.publish(entries);
+
+  ASSERT_EQ(SNAPSHOT_SIZE + 1, cache.size()) << "cache.size() result not match";
+  EXPECT_TRUE(cache.find(ca, create_IpAddress(getIPv4(0, 0, 42))));
+  EXPECT_EQ(EXPIRYTS, (*ca).expiryTs);
+  EXPECT_TRUE(cache.find(ca, create_IPv6Address(getIPv6(1, 2, 3))));
+  EXPECT_EQ(EXPIRYTS + 1, (*ca).expiryTs);
+
+  cache.publish(IPTimeEntitySnapshot::Entries{});
+  EXPECT_FALSE(cache.find(ca, create_IpAddress(getIPv4(0, 0, 42))));
+  ASSERT_EQ(0, cache.size()) << "cache.size() result not match";
+}
+
+/**
+ * multi-threads access snapshot cache test.
+ *
+ * Readers always see a whole snapshot while writer keeps publishing.
+ */
+TEST_F(SnapshotCacheTest, TestMultiThread_1) {
+  IPTimeEntitySnapshot::Entries nextEntries;
+  ipJob(nextEntries, bfrom, bto, cfrom, cto, dfrom, dto, EXPIRYTS + 1);
+
+  std::atomic<bool> stop{false};
+  std::thread writer([&] {
+    for (int i = 0; i < 100; i++) {
+      cache.publish(i % 2 ? entries : nextEntries);
+    }
+    stop = true;
+  });
+
+  tbb::parallel_for_each(begin(entries), end(entries), [&](const auto& entry) {
+    while (!stop) {
+      IPTimeEntitySnapshot::ConstAccessor ca;
+      EXPECT_TRUE(cache.find(ca, std::get<0>(entry)));
+      EXPECT_LE(EXPIRYTS, (*ca).expiryTs);
+      EXPECT_GE(EXPIRYTS + 1, (*ca).expiryTs);
+    }
+  });
+
+  writer.join();
+  ASSERT_EQ(SNAPSHOT_SIZE, cache.size()) << "cache.size() result not match";
+}
+
+/**
+ * visit reads the value inside the current snapshot.
+ */
+TEST_F(SnapshotCacheTest, TestVisit) {
+  int64_t ts = 0;
+  EXPECT_TRUE(cache.visit(create_IpAddress(getIPv4(0, 0, 42)), [&ts](const auto& value) { ts = value.expiryTs; }));
+  EXPECT_EQ(EXPIRYTS, ts);
+
+  EXPECT_FALSE(cache.visit(create_IpAddress(getIPv4(1, 0, 42)), [](const auto&) { FAIL() << "visited missing key"; }));
+}
+
+/**
+ * More reader threads than a block of reader slots read at once, the slots grow instead of the reads failing.
+ */
+TEST_F(SnapshotCacheTest, TestManyReaders) {
+  constexpr int READERS = 2 * static_cast<int>(LRUC::RcuDomain::BlockReaders) + 1;
+  std::atomic<int> found{0};
+  std::atomic<int> arrived{0};
+  std::vector<std::thread> readers;
+  for (int i = 0; i < READERS; i++) {
+    readers.emplace_back([&, i] {
+      IPTimeEntitySnapshot::ConstAccessor ca;
+      if (cache.find(ca, create_IpAddress(getIPv4(0, 0, i % SNAPSHOT_SIZE)))) {
+        found++;
+      }
+      // keep every reader slot claimed until all readers have read.
+      arrived++;
+      while (arrived < READERS) {
+        std::this_thread::yield();
+      }
+    });
+  }
+  for (auto& reader : readers) {
+    reader.join();
+  }
+  EXPECT_EQ(READERS, found);
+
+  // synchronize() waits on the appended slots too.
+  cache.publish(IPTimeEntitySnapshot::Entries{});
+  EXPECT_EQ(0, cache.size());
+}
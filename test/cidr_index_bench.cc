@@ -0,0 +1,85 @@
+#include <benchmark/benchmark.h>
+
+#include <lrucache_common.h>
+
+using namespace AtsPluginUtils;
+
+constexpr size_t BLOCK_COUNT = 10000;
+constexpr size_t LOOKUP_COUNT = 4096;
+
+/**
+ * randomAddress returns a random address of family: IPv4 in 64 /8s, IPv6 in 2000::/8 (global unicast).
+ */
+static IpAddress randomAddress(std::mt19937_64& gen, int family) {
+  struct sockaddr_in6 storage {};
+  if (family == AF_INET) {
+    auto* addr = reinterpret_cast<struct sockaddr_in*>(&storage);
+    addr->sin_family = AF_INET;
+    addr->sin_addr.s_addr = htonl(static_cast<uint32_t>((gen() % 64) << 24 | (gen() & 0xFFFFFF)));
+  } else {
+    storage.sin6_family = AF_INET6;
+    const uint64_t words[2] = {__builtin_bswap64(0x2000000000000000ULL | (gen() >> 8)), gen()};
+    memcpy(storage.sin6_addr.s6_addr, words, sizeof(words));
+  }
+  return IpAddress{reinterpret_cast<const struct sockaddr*>(&storage)};
+}
+
+/**
+ * blocklist returns BLOCK_COUNT blocks of family as a blocklist holds them: IPv4 /16 to /32, IPv6 /32 to /64.
+ */
+static IPCidrIndex::Entries blocklist(int family) {
+  std::mt19937_64 gen{42};
+  IPCidrIndex::Entries entries;
+  for (size_t i = 0; i < BLOCK_COUNT; i++) {
+    LRUC::Cidr cidr;
+    cidr.address = randomAddress(gen, family);
+    cidr.prefixLen = static_cast<uint8_t>(family == AF_INET ? 16 + gen() % 17 : 32 + gen() % 33);
+    entries.emplace_back(cidr, create_cache_value(static_cast<int64_t>(i)));
+  }
+  std::sort(entries.begin(), entries.end(), [](const auto& lhs, const auto& rhs) { return lhs.first < rhs.first; });
+  return entries;
+}
+
+/**
+ * lookups returns LOOKUP_COUNT addresses of family, half inside a block.
+ */
+static std::vector<IpAddress> lookups(const IPCidrIndex::Entries& entries, int family) {
+  std::mt19937_64 gen{7};
+  std::vector<IpAddress> ips;
+  for (size_t i = 0; i < LOOKUP_COUNT; i++) {
+    ips.push_back(i % 2 == 0 ? entries[gen() % entries.size()].first.address : randomAddress(gen, family));
+  }
+  return ips;
+}
+
+/**
+ * Benchmark for CidrIndex longest prefix match lookups, Arg is the address family.
+ */
+static void BM_CidrIndexFind(benchmark::State& state) {
+  const int family = static_cast<int>(state.range(0));
+  const auto entries = blocklist(family);
+  const IPCidrIndex index{entries};
+  const auto ips = lookups(entries, family);
+
+  size_t i = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(index.find(ips[i++ % ips.size()]));
+  }
+}
+BENCHMARK(BM_CidrIndexFind)->Arg(AF_INET)->Arg(AF_INET6);
+
+/**
+ * Benchmark for building CidrIndex from a sorted blocklist, Arg is the address family.
+ */
+static void BM_CidrIndexBuild(benchmark::State& state) {
+  const auto entries = blocklist(static_cast<int>(state.range(0)));
+
+  for (auto _ : state) {
+    const IPCidrIndex index{entries};
+    benchmark::DoNotOptimize(index.size());
+  }
+  state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(entries.size()));
+}
+BENCHMARK(BM_CidrIndexBuild)->Arg(AF_INET)->Arg(AF_INET6)->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
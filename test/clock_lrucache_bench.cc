@@ -437,4 +437,57 @@ BENCHMARK(BM_ClockLRUCacheConcurrentFindInsertErase_3)
     // ->Name("[concurrent] Find/Insert/Erase same key in different Thread")
     ->Threads(tcnt);
 
+/**
+ * Benchmark for LRUClockCache read-mostly load (99% find, 1% erase and re-insert) in different thread, guarded by TMutex.
+ */
+template <typename TMutex>
+static void BM_ClockLRUCacheReadMostly(benchmark::State& state) {
+  using Cache = LRUC::LRUClockCache<IpAddress, CacheValue<CACHE_VALUE_TYPE::TIME_ENTITY_LOOKUP_INFO>,
+                                    std::hash<IpAddress>, std::equal_to<IpAddress>, 2, TMutex>;
+  constexpr int LRUC_SIZE = 65'280;
+  constexpr int bfrom{0};
+  constexpr int bto{1};
+  constexpr int cfrom{0};
+  constexpr int cto{255};
+  constexpr int dfrom{0};
+  constexpr int dto{255};
+  constexpr int EXPIRYTS{42};
+
+  static Cache* cache;
+
+  // init. benchmark suite variables.
+  if (state.thread_index == 0) {
+    cache = new Cache{LRUC_SIZE};
+    randomIPs = new IPVec;
+    // init. random ip vector and fill the cache
+    ipJob(*randomIPs, bfrom, bto, cfrom, cto, dfrom, dto, EXPIRYTS);
+    for (const auto& [ip, value] : *randomIPs) {
+      cache->insert(ip, value);
+    }
+  }
+
+  std::mt19937 gen{static_cast<unsigned>(state.thread_index)};
+  std::uniform_int_distribution<size_t> pick{0, LRUC_SIZE - 1};
+
+  size_t i = 0;
+  for (auto _ : state) {
+    const auto& entry = (*randomIPs)[pick(gen)];
+
+    if (++i % 100 == 0) {
+      cache->erase(std::get<0>(entry));
+      cache->insert(std::get<0>(entry), std::get<1>(entry));
+    } else {
+      benchmark::DoNotOptimize(cache->find(std::get<0>(entry)));
+    }
+  }
+
+  // cleanup benchmark suite variables.
+  if (state.thread_index == 0) {
+    delete randomIPs;
+    delete cache;
+  }
+}
+BENCHMARK_TEMPLATE(BM_ClockLRUCacheReadMostly, std::shared_mutex)->ThreadRange(1, 64)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_ClockLRUCacheReadMostly, LRUC::DistributedSharedMutex)->ThreadRange(1, 64)->UseRealTime();
+
 BENCHMARK_MAIN();
@@ -0,0 +1,199 @@
+#include <benchmark/benchmark.h>
+
+#include <lrucache_common.h>
+
+#include <cmath>
+
+using namespace AtsPluginUtils;
+
+/**
+ * mixedIPs returns count addresses, IPv4 class C blocks as ipJob generates and IPv6, in random order as a trace
+ * replay sees them.
+ */
+static std::vector<IpAddress> mixedIPs(size_t count) {
+  std::vector<IpAddress> ips;
+  ips.reserve(count);
+  for (size_t i = 0; i < count; i++) {
+    const int c = static_cast<int>(i / 256 % 256);
+    const int d = static_cast<int>(i % 256);
+    ips.push_back(i % 2 == 0 ? create_IpAddress(getIPv4(static_cast<int>(i / 65536), c, d))
+                             : create_IPv6Address(getIPv6(static_cast<int>(i / 65536), c, d)));
+  }
+
+  std::shuffle(ips.begin(), ips.end(), std::mt19937{42});
+  return ips;
+}
+
+/**
+ * Benchmark for hashing a batch of keys one at a time with tbb_hash_compare<IpAddress>::hash.
+ */
+static void BM_HashOneByOne(benchmark::State& state) {
+  const auto ips = mixedIPs(static_cast<size_t>(state.range(0)));
+  std::vector<size_t> hashes(ips.size());
+
+  for (auto _ : state) {
+    for (size_t i = 0; i < ips.size(); i++) {
+      hashes[i] = tbb::tbb_hash_compare<IpAddress>::hash(ips[i]);
+    }
+    benchmark::DoNotOptimize(hashes.data());
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_HashOneByOne)->Arg(64)->Arg(4096);
+
+/**
+ * Benchmark for hashing a batch of keys with tbb_hash_compare<IpAddress>::hashMany.
+ */
+static void BM_HashMany(benchmark::State& state) {
+  const auto ips = mixedIPs(static_cast<size_t>(state.range(0)));
+  std::vector<size_t> hashes(ips.size());
+
+  for (auto _ : state) {
+    tbb::tbb_hash_compare<IpAddress>::hashMany(ips.data(), ips.size(), hashes.data());
+    benchmark::DoNotOptimize(hashes.data());
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_HashMany)->Arg(64)->Arg(4096);
+
+/**
+ * classCIPs returns count IPv4 addresses in sequential class C blocks, as ipJob generates them.
+ */
+static std::vector<IpAddress> classCIPs(size_t count) {
+  std::vector<IpAddress> ips;
+  ips.reserve(count);
+  for (size_t i = 0; i < count; i++) {
+    ips.push_back(create_IpAddress(getIPv4(static_cast<int>(i / 65536), static_cast<int>(i / 256 % 256),
+                                           static_cast<int>(i % 256))));
+  }
+  return ips;
+}
+
+/**
+ * randomIPv6s returns count random IPv6 addresses.
+ */
+static std::vector<IpAddress> randomIPv6s(size_t count) {
+  std::mt19937_64 gen{42};
+  std::vector<IpAddress> ips(count);
+  for (auto& ip : ips) {
+    struct sockaddr_in6 addr {};
+    addr.sin6_family = AF_INET6;
+    const uint64_t words[2] = {gen(), gen()};
+    memcpy(addr.sin6_addr.s6_addr, words, sizeof(words));
+    ip.set(reinterpret_cast<const struct sockaddr*>(&addr));
+  }
+  return ips;
+}
+
+/**
+ * chiSquare returns the chi-square statistic of the bins over the expected uniform count divided by its degrees of
+ * freedom, close to 1 for a uniform distribution.
+ */
+static double chiSquare(const std::vector<size_t>& bins, size_t total) {
+  const double expected = static_cast<double>(total) / static_cast<double>(bins.size());
+  double chi2 = 0;
+  for (size_t observed : bins) {
+    const double diff = static_cast<double>(observed) - expected;
+    chi2 += diff * diff / expected;
+  }
+  return chi2 / static_cast<double>(bins.size() - 1);
+}
+
+/**
+ * Benchmark for the IpHashCompare families, ns/hash on a key set and the distribution of the hash codes:
+ *  bucket_chi2: low 12 bits, as the shard's hash map picks a bucket.
+ *  shard_chi2: high 16 bits modulo 16 shards, as ScalableLRUCache::shardIndexOf does.
+ * Arg(0) hashes 65536 addresses in sequential class C blocks, Arg(1) 65536 random IPv6 addresses.
+ */
+template <LRUC::IpHashFamily Family>
+static void BM_HashFamily(benchmark::State& state) {
+  constexpr size_t KEY_COUNT = 65536;
+  constexpr size_t BUCKET_COUNT = 4096;
+  constexpr size_t SHARD_COUNT = 16;
+  const auto ips = state.range(0) == 0 ? classCIPs(KEY_COUNT) : randomIPv6s(KEY_COUNT);
+
+  size_t i = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(LRUC::IpHashCompare<Family>::hash(ips[i++ % ips.size()]));
+  }
+
+  std::vector<size_t> buckets(BUCKET_COUNT);
+  std::vector<size_t> shards(SHARD_COUNT);
+  for (const auto& ip : ips) {
+    const size_t hash = LRUC::IpHashCompare<Family>::hash(ip);
+    buckets[hash % BUCKET_COUNT]++;
+    shards[(hash >> (std::numeric_limits<size_t>::digits - 16)) % SHARD_COUNT]++;
+  }
+  state.counters["bucket_chi2"] = chiSquare(buckets, ips.size());
+  state.counters["shard_chi2"] = chiSquare(shards, ips.size());
+}
+BENCHMARK_TEMPLATE(BM_HashFamily, LRUC::IpHashFamily::Compat)->Arg(0)->Arg(1);
+BENCHMARK_TEMPLATE(BM_HashFamily, LRUC::IpHashFamily::Wy)->Arg(0)->Arg(1);
+BENCHMARK_TEMPLATE(BM_HashFamily, LRUC::IpHashFamily::Crc32c)->Arg(0)->Arg(1);
+BENCHMARK_TEMPLATE(BM_HashFamily, LRUC::IpHashFamily::SipHash13)->Arg(0)->Arg(1);
+
+constexpr size_t FLOOD_KEY_COUNT = 1024;
+constexpr size_t FLOOD_SHARD_COUNT = 4;
+
+/**
+ * floodIPs returns FLOOD_KEY_COUNT addresses of the IPv6 /64 2001:db8:1:2::/64. Sequential ones when colliding is
+ * false; otherwise ones an attacker knowing the public Compat hash picks: their hash codes share the low 12 bits (one
+ * bucket for hash maps up to 4096 buckets) and the shard.
+ */
+static const std::vector<IpAddress>& floodIPs(bool colliding) {
+  static const auto ips = [] {
+    std::array<std::vector<IpAddress>, 2> sets;
+    struct sockaddr_in6 addr {};
+    addr.sin6_family = AF_INET6;
+    inet_pton(AF_INET6, "2001:db8:1:2::", &addr.sin6_addr);
+
+    for (uint64_t interfaceId = 1; sets[0].size() < FLOOD_KEY_COUNT || sets[1].size() < FLOOD_KEY_COUNT;
+         interfaceId++) {
+      memcpy(addr.sin6_addr.s6_addr + 8, &interfaceId, sizeof(interfaceId));
+      IpAddress ip;
+      ip.set(reinterpret_cast<const struct sockaddr*>(&addr));
+
+      if (sets[0].size() < FLOOD_KEY_COUNT) {
+        sets[0].push_back(ip);
+      }
+      const size_t hash = LRUC::IpHashCompare<LRUC::IpHashFamily::Compat>::hash(ip);
+      if ((hash & 0xFFF) == 0 && (hash >> (std::numeric_limits<size_t>::digits - 16)) % FLOOD_SHARD_COUNT == 0 &&
+          sets[1].size() < FLOOD_KEY_COUNT) {
+        sets[1].push_back(ip);
+      }
+    }
+    return sets;
+  }();
+  return ips[colliding ? 1 : 0];
+}
+
+/**
+ * Benchmark for a hash flood: FLOOD_KEY_COUNT addresses inserted into then looked up from a ScalableLRUCache of
+ * FLOOD_SHARD_COUNT shards. Arg(0) sequential addresses, Arg(1) addresses colliding under the Compat hash.
+ * Compat degrades to one shard and one bucket chain, SipHash13 hashes both sets alike.
+ */
+template <LRUC::IpHashFamily Family>
+static void BM_CollisionAttack(benchmark::State& state) {
+  using Cache = LRUC::ScalableLRUCache<IpAddress, CacheValue<CACHE_VALUE_TYPE::TIME_ENTITY_LOOKUP_INFO>,
+                                       LRUC::IpHashCompare<Family>>;
+  const auto& ips = floodIPs(state.range(0) != 0);
+  Cache lruc{FLOOD_KEY_COUNT * 4, FLOOD_SHARD_COUNT};
+  typename Cache::ConstAccessor ca;
+
+  for (auto _ : state) {
+    lruc.clear();
+    for (const auto& ip : ips) {
+      lruc.insert(ip, create_cache_value(42));
+    }
+    for (const auto& ip : ips) {
+      benchmark::DoNotOptimize(lruc.find(ca, ip));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(ips.size()));
+}
+BENCHMARK_TEMPLATE(BM_CollisionAttack, LRUC::IpHashFamily::Compat)->Arg(0)->Arg(1);
+BENCHMARK_TEMPLATE(BM_CollisionAttack, LRUC::IpHashFamily::SipHash13)->Arg(0)->Arg(1);
+
+BENCHMARK_MAIN();
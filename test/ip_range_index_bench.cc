@@ -0,0 +1,89 @@
+#include <benchmark/benchmark.h>
+
+#include <lrucache_common.h>
+
+using namespace AtsPluginUtils;
+
+constexpr size_t LOOKUP_COUNT = 1 << 16;
+
+using Record = IPRangeIndex::Record;
+
+/**
+ * feed returns count sorted disjoint ranges spread over the IPv4 space, as a geo / reputation feed holds them.
+ */
+static std::vector<Record> feed(size_t count) {
+  std::mt19937_64 gen{42};
+  const uint64_t stride = (1ULL << 32) / count;
+  std::vector<Record> ranges;
+  for (size_t i = 0; i < count; i++) {
+    const uint64_t first = i * stride + gen() % (stride / 2);
+    ranges.push_back(Record{static_cast<uint32_t>(first), static_cast<uint32_t>(first + gen() % (stride / 2)),
+                            create_cache_value(static_cast<int64_t>(i))});
+  }
+  return ranges;
+}
+
+/**
+ * lookups returns LOOKUP_COUNT random addresses.
+ */
+static std::vector<uint32_t> lookups() {
+  std::mt19937_64 gen{7};
+  std::vector<uint32_t> ips;
+  for (size_t i = 0; i < LOOKUP_COUNT; i++) {
+    ips.push_back(static_cast<uint32_t>(gen()));
+  }
+  return ips;
+}
+
+/**
+ * Benchmark for IpRangeIndex Eytzinger lookups, Arg is the range count.
+ */
+static void BM_IpRangeIndexFind(benchmark::State& state) {
+  const IPRangeIndex index{feed(static_cast<size_t>(state.range(0)))};
+  const auto ips = lookups();
+
+  size_t i = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(index.find(ips[i++ % ips.size()]));
+  }
+}
+BENCHMARK(BM_IpRangeIndexFind)->Arg(1 << 10)->Arg(1 << 16)->Arg(1 << 22);
+
+/**
+ * Benchmark for std::upper_bound lookups over the sorted ranges, the baseline, Arg is the range count.
+ */
+static void BM_BinarySearchFind(benchmark::State& state) {
+  const auto ranges = feed(static_cast<size_t>(state.range(0)));
+  const auto ips = lookups();
+
+  size_t i = 0;
+  for (auto _ : state) {
+    const uint32_t ip = ips[i++ % ips.size()];
+    auto it = std::upper_bound(ranges.begin(), ranges.end(), ip,
+                               [](uint32_t value, const Record& range) { return value < range.first; });
+    const bool found = it != ranges.begin() && ip <= std::prev(it)->last;
+    benchmark::DoNotOptimize(found ? &std::prev(it)->value : nullptr);
+  }
+}
+BENCHMARK(BM_BinarySearchFind)->Arg(1 << 10)->Arg(1 << 16)->Arg(1 << 22);
+
+/**
+ * Benchmark for loading IpRangeIndex from a memory mapped file, Arg is the range count.
+ */
+static void BM_IpRangeIndexLoad(benchmark::State& state) {
+  char path[] = "/tmp/ip_range_index_bench_XXXXXX";
+  const int fd = mkstemp(path);
+  close(fd);
+  const auto ranges = feed(static_cast<size_t>(state.range(0)));
+  IPRangeIndex::save(path, ranges);
+
+  for (auto _ : state) {
+    const auto index = IPRangeIndex::load(path);
+    benchmark::DoNotOptimize(index.size());
+  }
+  state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(ranges.size()));
+  unlink(path);
+}
+BENCHMARK(BM_IpRangeIndexLoad)->Arg(1 << 22)->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,146 @@
+#include <benchmark/benchmark.h>
+
+#include <lru_cache/ats_type.h>
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace AtsPluginUtils;
+
+/**
+ * headerIPs returns client addresses as they show up in X-Forwarded-For / True-Client-IP headers.
+ */
+static const std::vector<std::string>& headerIPs(int family) {
+  static const std::vector<std::string> v4{"1.2.3.4",      "10.0.0.1",        "66.249.66.1",    "192.168.1.254",
+                                           "172.16.254.3", "203.0.113.195",   "8.8.8.8",        "100.64.12.7",
+                                           "52.94.236.248", "255.255.255.255", "127.0.0.1",      "23.45.67.89"};
+  static const std::vector<std::string> v6{"2001:db8:8714::12",
+                                           "::1",
+                                           "fe80::1ff:fe23:4567:890a",
+                                           "2a03:2880:f12f:83:face:b00c:0:25de",
+                                           "2001:db8:85a3:0:0:8a2e:370:7334",
+                                           "::ffff:192.168.1.1",
+                                           "2600:1f18:24e6:b900:7d3b:4a7c:1e2f:9a01",
+                                           "2001:4860:4860::8888"};
+  return family == AF_INET ? v4 : v6;
+}
+
+/**
+ * Benchmark for address text parsing with inet_pton, the text copied and NUL-terminated first as a
+ * std::string_view header value requires.
+ */
+static void BM_ParseInetPton(benchmark::State& state) {
+  const int family = static_cast<int>(state.range(0));
+  const auto& texts = headerIPs(family);
+  size_t i = 0;
+
+  for (auto _ : state) {
+    const std::string_view text = texts[i++ % texts.size()];
+    char str[INET6_ADDRSTRLEN];
+    memcpy(str, text.data(), text.size());
+    str[text.size()] = '\0';
+
+    struct in6_addr addr {};
+    benchmark::DoNotOptimize(inet_pton(family, str, &addr));
+    benchmark::DoNotOptimize(addr);
+  }
+}
+BENCHMARK(BM_ParseInetPton)->Arg(AF_INET)->Arg(AF_INET6);
+
+/**
+ * Benchmark for address text parsing with IpText.
+ */
+static void BM_ParseIpText(benchmark::State& state) {
+  const int family = static_cast<int>(state.range(0));
+  const auto& texts = headerIPs(family);
+  size_t i = 0;
+
+  for (auto _ : state) {
+    const std::string_view text = texts[i++ % texts.size()];
+    if (family == AF_INET) {
+      struct in_addr addr {};
+      benchmark::DoNotOptimize(IpText::parse(text, &addr));
+      benchmark::DoNotOptimize(addr);
+    } else {
+      struct in6_addr addr {};
+      benchmark::DoNotOptimize(IpText::parse(text, &addr));
+      benchmark::DoNotOptimize(addr);
+    }
+  }
+}
+BENCHMARK(BM_ParseIpText)->Arg(AF_INET)->Arg(AF_INET6);
+
+/**
+ * Benchmark for IpAddressText, trying IPv4 then IPv6 as the heterogeneous cache lookup does.
+ */
+static void BM_ParseIpAddressText(benchmark::State& state) {
+  const auto& texts = headerIPs(static_cast<int>(state.range(0)));
+  size_t i = 0;
+
+  for (auto _ : state) {
+    const IpAddressText addr{texts[i++ % texts.size()]};
+    benchmark::DoNotOptimize(addr.base.sa_family);
+  }
+}
+BENCHMARK(BM_ParseIpAddressText)->Arg(AF_INET)->Arg(AF_INET6);
+
+static std::vector<IpAddress> headerAddresses(int family) {
+  std::vector<IpAddress> ips;
+  for (const auto& text : headerIPs(family)) {
+    IpAddress ip;
+    ip.parse(text);
+    ips.push_back(ip);
+  }
+  return ips;
+}
+
+/**
+ * Benchmark for address formatting with inet_ntop.
+ */
+static void BM_FormatInetNtop(benchmark::State& state) {
+  const auto ips = headerAddresses(static_cast<int>(state.range(0)));
+  size_t i = 0;
+
+  for (auto _ : state) {
+    const IpAddress& ip = ips[i++ % ips.size()];
+    char buf[INET6_ADDRSTRLEN];
+    if (ip.base.sa_family == AF_INET) {
+      benchmark::DoNotOptimize(inet_ntop(AF_INET, &ip.v4.sin_addr, buf, sizeof(buf)));
+    } else {
+      benchmark::DoNotOptimize(inet_ntop(AF_INET6, &ip.v6.sin6_addr, buf, sizeof(buf)));
+    }
+    benchmark::ClobberMemory();
+  }
+}
+BENCHMARK(BM_FormatInetNtop)->Arg(AF_INET)->Arg(AF_INET6);
+
+/**
+ * Benchmark for address formatting with IpAddress::toChars into a caller buffer.
+ */
+static void BM_FormatToChars(benchmark::State& state) {
+  const auto ips = headerAddresses(static_cast<int>(state.range(0)));
+  size_t i = 0;
+
+  for (auto _ : state) {
+    char buf[INET6_ADDRSTRLEN];
+    benchmark::DoNotOptimize(ips[i++ % ips.size()].toChars(buf, sizeof(buf)));
+    benchmark::ClobberMemory();
+  }
+}
+BENCHMARK(BM_FormatToChars)->Arg(AF_INET)->Arg(AF_INET6);
+
+/**
+ * Benchmark for IpAddress::toString, formatting into a std::string.
+ */
+static void BM_FormatToString(benchmark::State& state) {
+  const auto ips = headerAddresses(static_cast<int>(state.range(0)));
+  size_t i = 0;
+
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(ips[i++ % ips.size()].toString());
+  }
+}
+BENCHMARK(BM_FormatToString)->Arg(AF_INET)->Arg(AF_INET6);
+
+BENCHMARK_MAIN();
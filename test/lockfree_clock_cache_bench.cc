@@ -0,0 +1,79 @@
+#include <benchmark/benchmark.h>
+
+#include <lrucache_common.h>
+
+using namespace AtsPluginUtils;
+
+using IPVec = std::vector<std::tuple<IpAddress, CacheValue<CACHE_VALUE_TYPE::TIME_ENTITY_LOOKUP_INFO>>>;
+
+constexpr int LRUC_SIZE = 65'025;
+
+// will be init. inside the benchmark functions.
+template <typename TCache>
+TCache* lruc;
+IPVec* randomIPs;
+
+/**
+ * setUp creates the cache and the key set twice its capacity, so every insert
+ * past warm up runs the clock sweep.
+ */
+template <typename TCache>
+static void setUp(const benchmark::State& state) {
+  if (state.thread_index == 0) {
+    lruc<TCache> = new TCache{LRUC_SIZE};
+    randomIPs = new IPVec;
+    ipJob(*randomIPs, 0, 2, 0, 255, 0, 255, 42);
+  }
+}
+
+template <typename TCache>
+static void tearDown(const benchmark::State& state) {
+  if (state.thread_index == 0) {
+    delete randomIPs;
+    delete lruc<TCache>;
+  }
+}
+
+/**
+ * Benchmark for concurrent inserts evicting through the clock hand,
+ * LRUClockCache sweeps under its exclusive lock, LockFreeClockCache doesn't.
+ */
+template <typename TCache>
+static void BM_ConcurrentInsert(benchmark::State& state) {
+  setUp<TCache>(state);
+
+  size_t i = static_cast<size_t>(state.thread_index) * 7919;
+  for (auto _ : state) {
+    const auto& ip = (*randomIPs)[i++ % randomIPs->size()];
+    lruc<TCache>->insert(std::get<0>(ip), std::get<1>(ip));
+  }
+
+  tearDown<TCache>(state);
+}
+BENCHMARK_TEMPLATE(BM_ConcurrentInsert, IPClockLRUCache)->ThreadRange(1, 16)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_ConcurrentInsert, IPLockFreeClockCache)->ThreadRange(1, 16)->UseRealTime();
+
+/**
+ * Benchmark for concurrent finds with one insert every 100 finds,
+ * LRUClockCache finds share its lock, LockFreeClockCache finds are wait-free.
+ */
+template <typename TCache>
+static void BM_ConcurrentReadMostly(benchmark::State& state) {
+  setUp<TCache>(state);
+
+  size_t i = static_cast<size_t>(state.thread_index) * 7919;
+  for (auto _ : state) {
+    const auto& ip = (*randomIPs)[i++ % randomIPs->size()];
+    if (i % 100 == 0) {
+      lruc<TCache>->insert(std::get<0>(ip), std::get<1>(ip));
+    } else {
+      benchmark::DoNotOptimize(lruc<TCache>->find(std::get<0>(ip)));
+    }
+  }
+
+  tearDown<TCache>(state);
+}
+BENCHMARK_TEMPLATE(BM_ConcurrentReadMostly, IPClockLRUCache)->ThreadRange(1, 16)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_ConcurrentReadMostly, IPLockFreeClockCache)->ThreadRange(1, 16)->UseRealTime();
+
+BENCHMARK_MAIN();
@@ -11,6 +11,7 @@
 #include <tbb/pipeline.h>
 
 #include <lrucache_singleton.h>
+#include <lru_cache/near-lrucache.h>
 
 // posix header
 #include <arpa/inet.h>
@@ -21,6 +22,7 @@
 #include <algorithm>
 #include <array>
 #include <iostream>
+#include <numeric>
 #include <random>
 #include <sstream>
 #include <thread>
@@ -31,13 +33,23 @@
 
 using namespace AtsPluginUtils;
 
+/**
+ * LRUC_MAP is the hash-map backend of IPLRUCache and SCALE_IPLRUCache, see
+ * lrucache_map.h. Test and benchmark targets are built once per backend.
+ *
+ */
+#ifndef LRUC_MAP
+#define LRUC_MAP TbbHashMap
+#endif
+
 /**
  * IPLRUCache is LRUC::LRUCache cache with
  * key: AtsPluginUtils::IpAddress
  * value: AtsPluginUtils::CacheValue<CACHE_VALUE_TYPE::TIME_ENTITY_LOOKUP_INFO>
  *
  */
-using IPLRUCache = LRUC::LRUCache<IpAddress, CacheValue<CACHE_VALUE_TYPE::TIME_ENTITY_LOOKUP_INFO>>;
+using IPLRUCache = LRUC::LRUCache<IpAddress, CacheValue<CACHE_VALUE_TYPE::TIME_ENTITY_LOOKUP_INFO>,
+                                  tbb::tbb_hash_compare<IpAddress>, LRUC::LRUC_MAP>;
 
 /**
  * SCALE_IPLRUCache is LRUC::ScalableLRUCache cache with
@@ -45,10 +57,35 @@ using IPLRUCache = LRUC::LRUCache<IpAddress, CacheValue<CACHE_VALUE_TYPE::TIME_E
  * value: AtsPluginUtils::CacheValue<CACHE_VALUE_TYPE::TIME_ENTITY_LOOKUP_INFO>
  *
  */
-using SCALE_IPLRUCache = LRUC::ScalableLRUCache<IpAddress, CacheValue<CACHE_VALUE_TYPE::TIME_ENTITY_LOOKUP_INFO>>;
+using SCALE_IPLRUCache = LRUC::ScalableLRUCache<IpAddress, CacheValue<CACHE_VALUE_TYPE::TIME_ENTITY_LOOKUP_INFO>,
+                                                tbb::tbb_hash_compare<IpAddress>, LRUC::LRUC_MAP>;
 
 using IPClockLRUCache = LRUC::LRUClockCache<IpAddress, CacheValue<CACHE_VALUE_TYPE::TIME_ENTITY_LOOKUP_INFO>>;
 
+/**
+ * SCALE_IPClockCache is LRUC::ScalableClockCache cache with
+ * key: AtsPluginUtils::IpAddress
+ * value: AtsPluginUtils::CacheValue<CACHE_VALUE_TYPE::TIME_ENTITY_LOOKUP_INFO>
+ *
+ */
+using SCALE_IPClockCache = LRUC::ScalableClockCache<IpAddress, CacheValue<CACHE_VALUE_TYPE::TIME_ENTITY_LOOKUP_INFO>>;
+
+/**
+ * IPLockFreeClockCache is LRUC::LockFreeClockCache cache with
+ * key: AtsPluginUtils::IpAddress
+ * value: AtsPluginUtils::CacheValue<CACHE_VALUE_TYPE::TIME_ENTITY_LOOKUP_INFO>
+ *
+ */
+using IPLockFreeClockCache = LRUC::LockFreeClockCache<IpAddress, CacheValue<CACHE_VALUE_TYPE::TIME_ENTITY_LOOKUP_INFO>>;
+
+/**
+ * NEAR_IPLRUCache is LRUC::NearLRUCache cache with
+ * key: AtsPluginUtils::IpAddress
+ * value: AtsPluginUtils::CacheValue<CACHE_VALUE_TYPE::TIME_ENTITY_LOOKUP_INFO>
+ *
+ */
+using NEAR_IPLRUCache = LRUC::NearLRUCache<IpAddress, CacheValue<CACHE_VALUE_TYPE::TIME_ENTITY_LOOKUP_INFO>>;
+
 namespace {
 
 /**
@@ -69,6 +106,35 @@ auto create_IpAddress = [](std::string ipv4) -> IpAddress {
   return IpAddress{};
 };
 
+/**
+ * create_IPv6Address is a callable object, taking ipv6 string (e.g '2001:db8::1')
+ * and returns AtsPluginUtils::IpAddress instance.
+ *
+ */
+auto create_IPv6Address = [](std::string ipv6) -> IpAddress {
+  sockaddr_in6 socket{};
+  socket.sin6_family = AF_INET6;
+  socket.sin6_port = 42;
+
+  if (inet_pton(AF_INET6, ipv6.c_str(), &socket.sin6_addr) == 1) {
+    IpAddress ipa{reinterpret_cast<sockaddr*>(&socket)};
+    return ipa;
+  }
+
+  return IpAddress{};
+};
+
+/**
+ * getIPv6 is a callable object generating IPv6 address as string (e.g '2001:db8:b:c::d')
+ *
+ */
+auto getIPv6 = [](int b, int c, int d) -> std::string {
+  std::stringstream ipv6;
+
+  ipv6 << "2001:db8:" << std::hex << b << ":" << c << "::" << d;
+  return ipv6.str();
+};
+
 /**
  * create_cache_value is a callable object, taking timestamp (e.g 1'222'333'444)
  * and returns CacheValue<CACHE_VALUE_TYPE::TIME_ENTITY_LOOKUP_INFO> instance
@@ -78,6 +144,14 @@ auto create_cache_value = [](auto ts) -> CacheValue<CACHE_VALUE_TYPE::TIME_ENTIT
   return CacheValue<CACHE_VALUE_TYPE::TIME_ENTITY_LOOKUP_INFO>{ts};
 };
 
+/**
+ * create_denied_value is create_cache_value with a non zero denialInfoCode.
+ *
+ */
+auto create_denied_value = [](auto ts) -> CacheValue<CACHE_VALUE_TYPE::TIME_ENTITY_LOOKUP_INFO> {
+  return CacheValue<CACHE_VALUE_TYPE::TIME_ENTITY_LOOKUP_INFO>{ts, 1};
+};
+
 /**
  * generator generates number from 'from' to 'to' exclusively and returns a callable object,
  * which each call to the object returns a number sequentially.
@@ -106,7 +180,7 @@ std::string getIPv4(int b, int c, int d) {
  *
  */
 template <typename T>
-void containerInsert(T&& t, int b, int c, int d, int expiryTS) {
+auto containerInsert(T&& t, int b, int c, int d, int expiryTS) -> decltype(t.insert(std::string{}), void()) {
   std::stringstream ipv4;
   ipv4 << "192." << b << "." << c << "." << d;
   t.insert(ipv4.str());
@@ -126,33 +200,14 @@ void containerInsert(std::vector<T, U...>& t, int b, int c, int d, int expiryTS)
 }
 
 /**
- * containerInsert inserts IPv4 class C address into LRUC::LRUCache with value
- * CacheValue<CACHE_VALUE_TYPE::TIME_ENTITY_LOOKUP_INFO>
+ * containerInsert inserts IPv4 class C address into cache t with value
+ * CacheValue<CACHE_VALUE_TYPE::TIME_ENTITY_LOOKUP_INFO>, t being any cache with insert(IpAddress, CacheValue).
  *
  */
-template <>
-void containerInsert(IPLRUCache& lruc, int b, int c, int d, int expiryTS) {
-  lruc.insert(create_IpAddress(getIPv4(b, c, d)), create_cache_value(expiryTS));
-}
-
-/**
- * containerInsert inserts IPv4 class C address into LRUC::ScalableLRUCache with value
- * CacheValue<CACHE_VALUE_TYPE::TIME_ENTITY_LOOKUP_INFO>
- *
- */
-template <>
-void containerInsert(SCALE_IPLRUCache& lruc, int b, int c, int d, int expiryTS) {
-  lruc.insert(create_IpAddress(getIPv4(b, c, d)), create_cache_value(expiryTS));
-}
-
-/**
- * containerInsert inserts IPv4 class C address into LRUC::LRUClockCache with value
- * CacheValue<CACHE_VALUE_TYPE::TIME_ENTITY_LOOKUP_INFO>
- *
- */
-template <>
-void containerInsert(IPClockLRUCache& lruc, int b, int c, int d, int expiryTS) {
-  lruc.insert(create_IpAddress(getIPv4(b, c, d)), create_cache_value(expiryTS));
+template <typename T>
+auto containerInsert(T&& t, int b, int c, int d, int expiryTS)
+    -> decltype(t.insert(std::declval<IpAddress>(), create_cache_value(expiryTS)), void()) {
+  t.insert(create_IpAddress(getIPv4(b, c, d)), create_cache_value(expiryTS));
 }
 
 /**
@@ -187,4 +242,27 @@ void ipJob(T&& t, int bfrom, int bto, int cfrom, int cto, int dfrom, int dto, in
   }
 }
 
+/**
+ * visitJob checks visit() of cache t reads the stored value in place and
+ * misses the key once erased, t being any cache with insert/erase/visit.
+ *
+ */
+template <typename T>
+void visitJob(T& t, int expiryTS) {
+  const auto key = create_IpAddress(getIPv4(1, 0, 42));
+  t.insert(key, CacheValue<CACHE_VALUE_TYPE::TIME_ENTITY_LOOKUP_INFO>{expiryTS, 7});
+
+  int64_t ts = 0;
+  int code = -1;
+  EXPECT_TRUE(t.visit(key, [&](const auto& value) {
+    ts = value.expiryTs;
+    code = value.denialInfoCode;
+  }));
+  EXPECT_EQ(expiryTS, ts);
+  EXPECT_EQ(7, code);
+
+  t.erase(key);
+  EXPECT_FALSE(t.visit(key, [](const auto&) { FAIL() << "visited erased key"; }));
+}
+
 }  // namespace
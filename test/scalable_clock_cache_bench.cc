@@ -0,0 +1,409 @@
+#include <benchmark/benchmark.h>
+
+#include <lrucache_common.h>
+
+using namespace AtsPluginUtils;
+
+using IPVec = std::vector<std::tuple<IpAddress, CacheValue<CACHE_VALUE_TYPE::TIME_ENTITY_LOOKUP_INFO>>>;
+
+// will be init. inside the benchmark functions.
+SCALE_IPClockCache* slruc;
+IPVec* randomIPs;
+
+// thread count (depends on hardware)
+constexpr size_t tcnt = 16;
+
+/**
+ * Benchmark for ScalableClockCache find and insert in each thread.
+ *
+ */
+static void BM_ScalableClockCacheConcurrentFindInsert_1(benchmark::State& state) {
+  // keep those const variables inside the function and make it as constexpr
+  constexpr int LRUC_SIZE = 1'885'725;
+  constexpr int bfrom{0};
+  constexpr int bto{29};
+  constexpr int cfrom{0};
+  constexpr int cto{255};
+  constexpr int dfrom{0};
+  constexpr int dto{255};
+  constexpr int EXPIRYTS{42};
+
+  // init. random device.
+  std::random_device rd{};
+  std::mt19937 gen{rd()};
+
+  // uniform distribution device
+  std::uniform_int_distribution<size_t> pick{0, LRUC_SIZE - 1};
+
+  // init. benchmark suite variables.
+  if (state.thread_index == 0) {
+    slruc = new SCALE_IPClockCache{LRUC_SIZE};
+    randomIPs = new IPVec;
+    // init. random ip vector
+    ipJob(*randomIPs, bfrom, bto, cfrom, cto, dfrom, dto, EXPIRYTS);
+  }
+
+  for (auto _ : state) {
+    state.PauseTiming();
+    size_t idx1 = pick(gen);
+    size_t idx2 = pick(gen);
+    state.ResumeTiming();
+
+    slruc->insert(std::get<0>((*randomIPs)[idx1]), std::get<1>((*randomIPs)[idx1]));
+    slruc->find(std::get<0>((*randomIPs)[idx2]));
+  }
+
+  // cleanup benchmark suite variables.
+  if (state.thread_index == 0) {
+    delete randomIPs;
+    delete slruc;
+  }
+}
+BENCHMARK(BM_ScalableClockCacheConcurrentFindInsert_1)
+    // ->Name("[concurrent] Scalable Clock Cache Find/Insert in each Thread")
+    ->Threads(tcnt);
+
+/**
+ * Benchmark for ScalableClockCache find and insert in different thread.
+ *
+ */
+static void BM_ScalableClockCacheConcurrentFindInsert_2(benchmark::State& state) {
+  // keep those const variables inside the function and make it as constexpr
+  constexpr int LRUC_SIZE = 1'885'725;
+  constexpr int bfrom{0};
+  constexpr int bto{29};
+  constexpr int cfrom{0};
+  constexpr int cto{255};
+  constexpr int dfrom{0};
+  constexpr int dto{255};
+  constexpr int EXPIRYTS{42};
+
+  // init. random device.
+  std::random_device rd{};
+  std::mt19937 gen{rd()};
+  // uniform distribution device
+  std::uniform_int_distribution<size_t> pick{0, LRUC_SIZE - 1};
+
+  // init. benchmark suite variables.
+  if (state.thread_index == 0) {
+    slruc = new SCALE_IPClockCache{LRUC_SIZE};
+    randomIPs = new IPVec;
+    // init. random ip vector
+    ipJob(*randomIPs, bfrom, bto, cfrom, cto, dfrom, dto, EXPIRYTS);
+  }
+
+  for (auto _ : state) {
+    state.PauseTiming();
+    size_t idx1 = pick(gen);
+    state.ResumeTiming();
+
+    if (state.iterations() % 2) {
+      slruc->find(std::get<0>((*randomIPs)[idx1]));
+    } else {
+      slruc->insert(std::get<0>((*randomIPs)[idx1]), std::get<1>((*randomIPs)[idx1]));
+    }
+  }
+
+  // cleanup benchmark suite variables.
+  if (state.thread_index == 0) {
+    delete randomIPs;
+    delete slruc;
+  }
+}
+BENCHMARK(BM_ScalableClockCacheConcurrentFindInsert_2)
+    // ->Name("[concurrent] Scalable Clock Cache Find/Insert in different Thread")
+    ->Threads(tcnt);
+
+/**
+ * Benchmark for ScalableClockCache find in different thread.
+ *
+ */
+static void BM_ScalableClockCacheConcurrentFind_1(benchmark::State& state) {
+  // keep those const variables inside the function and make it as constexpr
+  constexpr int LRUC_SIZE = 1'885'725;
+  constexpr int bfrom{0};
+  constexpr int bto{29};
+  constexpr int cfrom{0};
+  constexpr int cto{255};
+  constexpr int dfrom{0};
+  constexpr int dto{255};
+  constexpr int EXPIRYTS{42};
+
+  // init. random device.
+  std::random_device rd{};
+  std::mt19937 gen{rd()};
+  // uniform distribution device
+  std::uniform_int_distribution<size_t> pick{0, LRUC_SIZE - 1};
+
+  // init. benchmark suite variables.
+  if (state.thread_index == 0) {
+    slruc = new SCALE_IPClockCache{LRUC_SIZE};
+    randomIPs = new IPVec;
+    // init. random ip vector
+    ipJob(*randomIPs, bfrom, bto, cfrom, cto, dfrom, dto, EXPIRYTS);
+  }
+
+  for (auto _ : state) {
+    state.PauseTiming();
+    size_t idx1 = pick(gen);
+    state.ResumeTiming();
+
+    slruc->find(std::get<0>((*randomIPs)[idx1]));
+  }
+
+  // cleanup benchmark suite variables.
+  if (state.thread_index == 0) {
+    delete randomIPs;
+    delete slruc;
+  }
+}
+BENCHMARK(BM_ScalableClockCacheConcurrentFind_1)
+    // ->Name("[concurrent] Scalable Clock Cache Find in different Thread")
+    ->Threads(tcnt);
+
+/**
+ * Benchmark for ScalableClockCache insert in different thread.
+ *
+ */
+static void BM_ScalableClockCacheConcurrentInsert_1(benchmark::State& state) {
+  // keep those const variables inside the function and make it as constexpr
+  constexpr int LRUC_SIZE = 1'885'725;
+  constexpr int bfrom{0};
+  constexpr int bto{29};
+  constexpr int cfrom{0};
+  constexpr int cto{255};
+  constexpr int dfrom{0};
+  constexpr int dto{255};
+  constexpr int EXPIRYTS{42};
+
+  // init. random device.
+  std::random_device rd{};
+  std::mt19937 gen{rd()};
+  // uniform distribution device
+  std::uniform_int_distribution<size_t> pick{0, LRUC_SIZE - 1};
+
+  // init. benchmark suite variables.
+  if (state.thread_index == 0) {
+    slruc = new SCALE_IPClockCache{LRUC_SIZE};
+    randomIPs = new IPVec;
+    // init. random ip vector
+    ipJob(*randomIPs, bfrom, bto, cfrom, cto, dfrom, dto, EXPIRYTS);
+  }
+
+  for (auto _ : state) {
+    state.PauseTiming();
+    size_t idx1 = pick(gen);
+    state.ResumeTiming();
+
+    slruc->insert(std::get<0>((*randomIPs)[idx1]), std::get<1>((*randomIPs)[idx1]));
+  }
+
+  // cleanup benchmark suite variables.
+  if (state.thread_index == 0) {
+    delete randomIPs;
+    delete slruc;
+  }
+}
+BENCHMARK(BM_ScalableClockCacheConcurrentInsert_1)
+    // ->Name("[concurrent] Scalable Clock Cache Insert in different Thread")
+    ->Threads(tcnt);
+
+/**
+ * Benchmark for ScalableClockCache insert in sequential.
+ *
+ */
+static void BM_ScalableClockCacheInsert_1(benchmark::State& state) {
+  // keep those const variables inside the function and make it as constexpr
+  constexpr int LRUC_SIZE = 1'885'725;
+  constexpr int bfrom{0};
+  constexpr int bto{29};
+  constexpr int cfrom{0};
+  constexpr int cto{255};
+  constexpr int dfrom{0};
+  constexpr int dto{255};
+  constexpr int EXPIRYTS{42};
+
+  // init. random device.
+  std::random_device rd{};
+  std::mt19937 gen{rd()};
+  // uniform distribution device
+  std::uniform_int_distribution<size_t> pick{0, LRUC_SIZE - 1};
+
+  // init. benchmark suite variables.
+  if (state.thread_index == 0) {
+    slruc = new SCALE_IPClockCache{LRUC_SIZE};
+    randomIPs = new IPVec;
+    // init. random ip vector
+    ipJob(*randomIPs, bfrom, bto, cfrom, cto, dfrom, dto, EXPIRYTS);
+  }
+
+  for (auto _ : state) {
+    state.PauseTiming();
+    size_t idx1 = pick(gen);
+    state.ResumeTiming();
+
+    slruc->insert(std::get<0>((*randomIPs)[idx1]), std::get<1>((*randomIPs)[idx1]));
+  }
+
+  // cleanup benchmark suite variables.
+  if (state.thread_index == 0) {
+    delete randomIPs;
+    delete slruc;
+  }
+}
+// BENCHMARK(BM_ScalableClockCacheInsert_1)->Name("Scalable Clock Cache Insert in sequential");
+BENCHMARK(BM_ScalableClockCacheInsert_1);
+
+/**
+ * Benchmark for ScalableClockCache find in sequential.
+ *
+ */
+static void BM_ScalableClockCacheFind_1(benchmark::State& state) {
+  // keep those const variables inside the function and make it as constexpr
+  constexpr int LRUC_SIZE = 1'885'725;
+  constexpr int bfrom{0};
+  constexpr int bto{29};
+  constexpr int cfrom{0};
+  constexpr int cto{255};
+  constexpr int dfrom{0};
+  constexpr int dto{255};
+  constexpr int EXPIRYTS{42};
+
+  // init. random device.
+  std::random_device rd{};
+  std::mt19937 gen{rd()};
+  // uniform distribution device
+  std::uniform_int_distribution<size_t> pick{0, LRUC_SIZE - 1};
+
+  // init. benchmark suite variables.
+  if (state.thread_index == 0) {
+    slruc = new SCALE_IPClockCache{LRUC_SIZE};
+    randomIPs = new IPVec;
+    // init. random ip vector
+    ipJob(*randomIPs, bfrom, bto, cfrom, cto, dfrom, dto, EXPIRYTS);
+  }
+
+  for (auto _ : state) {
+    state.PauseTiming();
+    size_t idx1 = pick(gen);
+    state.ResumeTiming();
+
+    slruc->find(std::get<0>((*randomIPs)[idx1]));
+  }
+
+  // cleanup benchmark suite variables.
+  if (state.thread_index == 0) {
+    delete randomIPs;
+    delete slruc;
+  }
+}
+// BENCHMARK(BM_ScalableClockCacheFind_1)->Name("Scalable Clock Cache Find in sequential");
+BENCHMARK(BM_ScalableClockCacheFind_1);
+
+/**
+ * Benchmark for ScalableClockCache find/insert/erase in each thread.
+ *
+ */
+static void BM_ScalableClockCacheConcurrentFindInsertErase_1(benchmark::State& state) {
+  // keep those const variables inside the function and make it as constexpr
+  constexpr int LRUC_SIZE = 1'885'725;
+  constexpr int bfrom{0};
+  constexpr int bto{29};
+  constexpr int cfrom{0};
+  constexpr int cto{255};
+  constexpr int dfrom{0};
+  constexpr int dto{255};
+  constexpr int EXPIRYTS{42};
+
+  // init. random device.
+  std::random_device rd{};
+  std::mt19937 gen{rd()};
+  // uniform distribution device
+  std::uniform_int_distribution<size_t> pick{0, LRUC_SIZE - 1};
+
+  // init. benchmark suite variables.
+  if (state.thread_index == 0) {
+    slruc = new SCALE_IPClockCache{LRUC_SIZE};
+    randomIPs = new IPVec{};
+    // init. random ip vector
+    ipJob(*randomIPs, bfrom, bto, cfrom, cto, dfrom, dto, EXPIRYTS);
+  }
+
+  for (auto _ : state) {
+    state.PauseTiming();
+    size_t idx1 = pick(gen);
+    size_t idx2 = pick(gen);
+    state.ResumeTiming();
+
+    slruc->insert(std::get<0>((*randomIPs)[idx1]), std::get<1>((*randomIPs)[idx1]));
+    slruc->find(std::get<0>((*randomIPs)[idx2]));
+    slruc->erase(std::get<0>((*randomIPs)[idx2]));
+  }
+
+  // cleanup benchmark suite variables.
+  if (state.thread_index == 0) {
+    delete randomIPs;
+    delete slruc;
+  }
+}
+BENCHMARK(BM_ScalableClockCacheConcurrentFindInsertErase_1)
+    // ->Name("[concurrent] Scalable Clock Cache Find/Insert/Erase in each Thread")
+    ->Threads(tcnt);
+
+/**
+ * Benchmark for ScalableClockCache find/insert/erase in different thread.
+ *
+ */
+static void BM_ScalableClockCacheConcurrentFindInsertErase_2(benchmark::State& state) {
+  // keep those const variables inside the function and make it as constexpr
+  constexpr int LRUC_SIZE = 1'885'725;
+  constexpr int bfrom{0};
+  constexpr int bto{29};
+  constexpr int cfrom{0};
+  constexpr int cto{255};
+  constexpr int dfrom{0};
+  constexpr int dto{255};
+  constexpr int EXPIRYTS{42};
+
+  // init. random device.
+  std::random_device rd{};
+  std::mt19937 gen{rd()};
+  // uniform distribution device
+  std::uniform_int_distribution<size_t> pick{0, LRUC_SIZE - 1};
+
+  // init. benchmark suite variables.
+  if (state.thread_index == 0) {
+    slruc = new SCALE_IPClockCache{LRUC_SIZE};
+    randomIPs = new IPVec;
+    // init. random ip vector
+    ipJob(*randomIPs, bfrom, bto, cfrom, cto, dfrom, dto, EXPIRYTS);
+  }
+
+  for (auto _ : state) {
+    state.PauseTiming();
+    size_t idx1 = pick(gen);
+    state.ResumeTiming();
+
+    switch (state.iterations() % 3) {
+      case 0: {
+        slruc->find(std::get<0>((*randomIPs)[idx1]));
+      } break;
+      case 1:
+        slruc->insert(std::get<0>((*randomIPs)[idx1]), std::get<1>((*randomIPs)[idx1]));
+        break;
+      case 2:
+        slruc->erase(std::get<0>((*randomIPs)[idx1]));
+    }
+  }
+
+  // cleanup benchmark suite variables.
+  if (state.thread_index == 0) {
+    delete randomIPs;
+    delete slruc;
+  }
+}
+BENCHMARK(BM_ScalableClockCacheConcurrentFindInsertErase_2)
+    // ->Name("[concurrent] Scalable Clock Cache Find/Insert/Erase in different Thread")
+    ->Threads(tcnt);
+
+BENCHMARK_MAIN();
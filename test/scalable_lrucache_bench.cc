@@ -412,4 +412,194 @@ BENCHMARK(BM_ScalableLRUCacheConcurrentFindInsertErase_2)
     // ->Name("[concurrent] Scalable LRU Cache Find/Insert/Erase in different Thread")
     ->Threads(tcnt);
 
+/**
+ * hashedKeyIPs returns keys for the HashedKey benchmarks, IPv4 (192.b.c.d) or IPv6 (2001:db8:b:c::d) depends on family.
+ *
+ */
+std::vector<IpAddress> hashedKeyIPs(int family, int cnt) {
+  std::vector<IpAddress> ips;
+  ips.reserve(static_cast<size_t>(cnt));
+
+  for (int i = 0; i < cnt; i++) {
+    int b = (i >> 16) & 0xff;
+    int c = (i >> 8) & 0xff;
+    int d = i & 0xff;
+    ips.push_back(family == AF_INET ? create_IpAddress(getIPv4(b, c, d)) : create_IPv6Address(getIPv6(b, c, d)));
+  }
+
+  // shuffle to avoid sequential access pattern.
+  std::shuffle(ips.begin(), ips.end(), std::mt19937{42});
+  return ips;
+}
+
+/**
+ * Benchmark for ScalableLRUCache find-or-insert with TKey overloads, key hashed inside each call.
+ * TCache: SCALE_IPLRUCache or IPFamilyTimeEntityCache (IPv4 / IPv6 routed to their own tables)
+ * state.range(0): AF_INET or AF_INET6
+ *
+ */
+template <typename TCache>
+static void BM_ScalableLRUCacheFindOrInsert_Key(benchmark::State& state) {
+  constexpr int LRUC_SIZE = 65'536;
+  constexpr int IP_CNT = LRUC_SIZE * 2;
+  constexpr int EXPIRYTS{42};
+
+  TCache cache{LRUC_SIZE};
+  auto ips = hashedKeyIPs(static_cast<int>(state.range(0)), IP_CNT);
+  auto value = create_cache_value(EXPIRYTS);
+  size_t idx = 0;
+
+  for (auto _ : state) {
+    const auto& key = ips[idx];
+    idx = (idx + 1) % ips.size();
+
+    typename TCache::ConstAccessor ca;
+    if (!cache.find(ca, key)) {
+      cache.insert(key, value);
+    }
+  }
+}
+BENCHMARK_TEMPLATE(BM_ScalableLRUCacheFindOrInsert_Key, SCALE_IPLRUCache)->Arg(AF_INET)->Arg(AF_INET6);
+BENCHMARK_TEMPLATE(BM_ScalableLRUCacheFindOrInsert_Key, IPFamilyTimeEntityCache)->Arg(AF_INET)->Arg(AF_INET6);
+BENCHMARK_TEMPLATE(BM_ScalableLRUCacheFindOrInsert_Key, IPOrderedTimeEntityCache)->Arg(AF_INET)->Arg(AF_INET6);
+
+/**
+ * Benchmark for ScalableLRUCache find-or-insert with HashedKey overloads, key hashed once per iteration.
+ * state.range(0): AF_INET or AF_INET6
+ *
+ */
+static void BM_ScalableLRUCacheFindOrInsert_HashedKey(benchmark::State& state) {
+  constexpr int LRUC_SIZE = 65'536;
+  constexpr int IP_CNT = LRUC_SIZE * 2;
+  constexpr int EXPIRYTS{42};
+
+  SCALE_IPLRUCache cache{LRUC_SIZE};
+  auto ips = hashedKeyIPs(static_cast<int>(state.range(0)), IP_CNT);
+  auto value = create_cache_value(EXPIRYTS);
+  size_t idx = 0;
+
+  for (auto _ : state) {
+    SCALE_IPLRUCache::HashedKey key{ips[idx]};
+    idx = (idx + 1) % ips.size();
+
+    SCALE_IPLRUCache::ConstAccessor ca;
+    if (!cache.find(ca, key)) {
+      cache.insert(key, value);
+    }
+  }
+}
+BENCHMARK(BM_ScalableLRUCacheFindOrInsert_HashedKey)->Arg(AF_INET)->Arg(AF_INET6);
+
+/**
+ * Benchmark for find from the client address as const sockaddr* or text, hit only.
+ * TCache: SCALE_IPLRUCache or IPFamilyTimeEntityCache
+ * state.range(0): AF_INET or AF_INET6
+ * state.range(1): 0 builds an IpAddress key, 1 heterogeneous lookup by const sockaddr*, 2 by text
+ *
+ */
+template <typename TCache>
+static void BM_ScalableLRUCacheFind_Heterogeneous(benchmark::State& state) {
+  constexpr int LRUC_SIZE = 65'536;
+  constexpr int EXPIRYTS{42};
+
+  TCache cache{LRUC_SIZE};
+  auto ips = hashedKeyIPs(static_cast<int>(state.range(0)), LRUC_SIZE / 2);
+  std::vector<std::string> texts;
+  for (const auto& ip : ips) {
+    cache.insert(ip, create_cache_value(EXPIRYTS));
+    texts.push_back(ip.toString());
+  }
+  size_t idx = 0;
+
+  for (auto _ : state) {
+    const sockaddr* addr = &ips[idx].base;
+    const std::string_view text = texts[idx];
+    idx = (idx + 1) % ips.size();
+
+    typename TCache::ConstAccessor ca;
+    switch (state.range(1)) {
+      case 0:
+        benchmark::DoNotOptimize(cache.find(ca, IpAddress{addr}));
+        break;
+      case 1:
+        benchmark::DoNotOptimize(cache.find(ca, addr));
+        break;
+      default:
+        benchmark::DoNotOptimize(cache.find(ca, text));
+    }
+  }
+}
+BENCHMARK_TEMPLATE(BM_ScalableLRUCacheFind_Heterogeneous, SCALE_IPLRUCache)
+    ->ArgsProduct({{AF_INET, AF_INET6}, {0, 1, 2}});
+BENCHMARK_TEMPLATE(BM_ScalableLRUCacheFind_Heterogeneous, IPFamilyTimeEntityCache)
+    ->ArgsProduct({{AF_INET, AF_INET6}, {0, 1, 2}});
+
+/**
+ * Benchmark for counting requests per IP: IPRateLimitCache hit in place (0) against the copy-out / erase / insert a
+ * SCALE_IPLRUCache counting in its value needs (1).
+ * state.range(0): 0 or 1
+ *
+ */
+static void BM_ScalableLRUCacheRateCount(benchmark::State& state) {
+  constexpr int LRUC_SIZE = 65'536;
+  constexpr int IP_CNT = LRUC_SIZE / 2;
+
+  IPRateLimitCache rates{LRUC_SIZE, 100, 1000};
+  SCALE_IPLRUCache counts{LRUC_SIZE};
+  auto ips = hashedKeyIPs(AF_INET, IP_CNT);
+  size_t idx = 0;
+  int64_t now = 0;
+
+  for (auto _ : state) {
+    const auto& key = ips[idx];
+    idx = (idx + 1) % ips.size();
+    now++;
+
+    if (state.range(0) == 0) {
+      benchmark::DoNotOptimize(rates.hit(key, now));
+    } else {
+      SCALE_IPLRUCache::ConstAccessor ca;
+      auto value = create_cache_value(0);
+      if (counts.find(ca, key)) {
+        value = *ca;
+        counts.erase(key);
+      }
+      value.expiryTs++;
+      counts.insert(key, value);
+      benchmark::DoNotOptimize(value.expiryTs > 100);
+    }
+  }
+}
+BENCHMARK(BM_ScalableLRUCacheRateCount)->Arg(0)->Arg(1);
+
+/**
+ * Benchmark for IPOrderedTimeEntityCache eraseRange of a /24 out of 1M entries, the /24 inserted back untimed.
+ *
+ */
+static void BM_ScalableLRUCacheEraseRange(benchmark::State& state) {
+  constexpr int LRUC_SIZE = 1 << 20;
+  constexpr int EXPIRYTS{42};
+
+  IPOrderedTimeEntityCache cache{LRUC_SIZE};
+  auto ips = hashedKeyIPs(AF_INET, LRUC_SIZE);
+  for (const auto& ip : ips) {
+    cache.insert(ip, create_cache_value(EXPIRYTS));
+  }
+  int c = 0;
+
+  for (auto _ : state) {
+    LRUC::Cidr block;
+    LRUC::Cidr::parse(getIPv4(8, c, 0) + "/24", &block);
+    benchmark::DoNotOptimize(cache.eraseRange(block));
+
+    state.PauseTiming();
+    for (int d = 0; d < 256; d++) {
+      cache.insert(create_IpAddress(getIPv4(8, c, d)), create_cache_value(EXPIRYTS));
+    }
+    c = (c + 1) % 256;
+    state.ResumeTiming();
+  }
+}
+BENCHMARK(BM_ScalableLRUCacheEraseRange);
+
 BENCHMARK_MAIN();
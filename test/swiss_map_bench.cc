@@ -0,0 +1,147 @@
+#include <benchmark/benchmark.h>
+
+#include <lrucache_common.h>
+
+using namespace AtsPluginUtils;
+
+using IPValue = CacheValue<CACHE_VALUE_TYPE::TIME_ENTITY_LOOKUP_INFO>;
+using IPVec = std::vector<std::tuple<IpAddress, IPValue>>;
+
+// will be init. inside the benchmark functions.
+IPVec* randomIPs;
+
+// entries fillMap creates, known before thread 0 fills randomIPs.
+constexpr size_t ENTRIES = 32 * 255 * 255;
+
+/**
+ * fillMap creates about 2M IPv4 entries (192.[0, 32).c.d) and inserts them into map.
+ */
+template <typename TMap>
+static TMap* fillMap() {
+  constexpr int bfrom{0};
+  constexpr int bto{32};
+  constexpr int cfrom{0};
+  constexpr int cto{255};
+  constexpr int dfrom{0};
+  constexpr int dto{255};
+  constexpr int EXPIRYTS{42};
+
+  randomIPs = new IPVec;
+  ipJob(*randomIPs, bfrom, bto, cfrom, cto, dfrom, dto, EXPIRYTS);
+
+  auto* map = new TMap{randomIPs->size(), std::thread::hardware_concurrency() * 8};
+  for (const auto& [ip, value] : *randomIPs) {
+    map->insert(ip, value);
+  }
+
+  return map;
+}
+
+/**
+ * Benchmark for hash-map backend find hits over 2M entries in different thread.
+ */
+template <template <class, class, class> class TMap>
+static void BM_MapFind(benchmark::State& state) {
+  using Map = TMap<IpAddress, IPValue, tbb::tbb_hash_compare<IpAddress>>;
+  static Map* map;
+
+  // init. benchmark suite variables.
+  if (state.thread_index == 0) {
+    map = fillMap<Map>();
+  }
+
+  std::mt19937 gen{static_cast<unsigned>(state.thread_index)};
+  std::uniform_int_distribution<size_t> pick{0, ENTRIES - 1};
+
+  for (auto _ : state) {
+    const auto& entry = (*randomIPs)[pick(gen)];
+    IPValue value;
+    benchmark::DoNotOptimize(map->visit(std::get<0>(entry), [&value](const IPValue& found) { value = found; }));
+    benchmark::DoNotOptimize(value);
+  }
+
+  // cleanup benchmark suite variables.
+  if (state.thread_index == 0) {
+    delete randomIPs;
+    delete map;
+  }
+}
+BENCHMARK_TEMPLATE(BM_MapFind, LRUC::TbbHashMap)->ThreadRange(1, 16)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_MapFind, LRUC::SwissMap)->ThreadRange(1, 16)->UseRealTime();
+
+/**
+ * Benchmark for hash-map backend find misses over 2M entries in different thread.
+ */
+template <template <class, class, class> class TMap>
+static void BM_MapFindMiss(benchmark::State& state) {
+  using Map = TMap<IpAddress, IPValue, tbb::tbb_hash_compare<IpAddress>>;
+  static Map* map;
+  static std::vector<IpAddress>* missIPs;
+
+  // init. benchmark suite variables.
+  if (state.thread_index == 0) {
+    map = fillMap<Map>();
+    missIPs = new std::vector<IpAddress>;
+    for (int c = 0; c < 256; c++) {
+      for (int d = 0; d < 256; d++) {
+        missIPs->push_back(create_IpAddress(getIPv6(0, c, d)));
+      }
+    }
+  }
+
+  std::mt19937 gen{static_cast<unsigned>(state.thread_index)};
+  std::uniform_int_distribution<size_t> pick{0, 256 * 256 - 1};
+
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(map->visit((*missIPs)[pick(gen)], [](const IPValue&) {}));
+  }
+
+  // cleanup benchmark suite variables.
+  if (state.thread_index == 0) {
+    delete missIPs;
+    delete randomIPs;
+    delete map;
+  }
+}
+BENCHMARK_TEMPLATE(BM_MapFindMiss, LRUC::TbbHashMap)->ThreadRange(1, 16)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_MapFindMiss, LRUC::SwissMap)->ThreadRange(1, 16)->UseRealTime();
+
+/**
+ * Benchmark for hash-map backend read-mostly load (99% find, 1% erase and re-insert) over 2M entries in different
+ * thread.
+ */
+template <template <class, class, class> class TMap>
+static void BM_MapReadMostly(benchmark::State& state) {
+  using Map = TMap<IpAddress, IPValue, tbb::tbb_hash_compare<IpAddress>>;
+  static Map* map;
+
+  // init. benchmark suite variables.
+  if (state.thread_index == 0) {
+    map = fillMap<Map>();
+  }
+
+  std::mt19937 gen{static_cast<unsigned>(state.thread_index)};
+  std::uniform_int_distribution<size_t> pick{0, ENTRIES - 1};
+
+  size_t i = 0;
+  for (auto _ : state) {
+    const auto& [ip, value] = (*randomIPs)[pick(gen)];
+
+    if (++i % 100 == 0) {
+      map->erase(ip);
+      map->insert(ip, value);
+    } else {
+      benchmark::DoNotOptimize(map->visit(ip, [](const IPValue&) {}));
+    }
+  }
+
+  // cleanup benchmark suite variables.
+  if (state.thread_index == 0) {
+    delete randomIPs;
+    delete map;
+  }
+}
+BENCHMARK_TEMPLATE(BM_MapReadMostly, LRUC::TbbHashMap)->ThreadRange(1, 16)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_MapReadMostly, LRUC::SwissMap)->ThreadRange(1, 16)->UseRealTime();
+
+BENCHMARK_MAIN();